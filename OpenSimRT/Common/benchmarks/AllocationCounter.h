@@ -0,0 +1,85 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file AllocationCounter.h
+ *
+ * \brief Counts the heap allocations of a benchmark loop. The global operator
+ * new is replaced, thus this header must be included by exactly one translation
+ * unit of each benchmark executable (allocations in the shared libraries are
+ * counted as well).
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <new>
+
+namespace OpenSimRT {
+
+inline std::atomic<long long>& allocationCount() {
+    static std::atomic<long long> count(0);
+    return count;
+}
+
+/**
+ * \brief Reports the allocations between construction and destruction as the
+ * "allocs/op" counter of the benchmark (averaged over the iterations).
+ *
+ * Example:
+ *
+ *    static void BM_Function(benchmark::State& state) {
+ *        AllocationCounter allocations(state);
+ *        for (auto _ : state) function();
+ *    }
+ */
+class AllocationCounter {
+ public:
+    explicit AllocationCounter(benchmark::State& state)
+            : state(state), start(allocationCount().load()) {}
+    ~AllocationCounter() {
+        state.counters["allocs/op"] = benchmark::Counter(
+                double(allocationCount().load() - start),
+                benchmark::Counter::kAvgIterations);
+    }
+
+ private:
+    benchmark::State& state;
+    long long start;
+};
+
+} // namespace OpenSimRT
+
+void* operator new(std::size_t size) {
+    OpenSimRT::allocationCount().fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+void operator delete[](void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
@@ -0,0 +1,90 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkBuffers.cpp
+ *
+ * \brief Microbenchmarks of the CircularBuffer and the SyncManager, scaling
+ * over the size of the buffered frames and the number of synchronized packs.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "AllocationCounter.h"
+#include "CircularBuffer.h"
+#include "SyncManager.h"
+#include <SimTKcommon.h>
+
+using namespace std;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+static void BM_CircularBufferGet(benchmark::State& state) {
+    // producer and consumer in the same thread (the buffer never blocks)
+    CircularBuffer<16, Vector> buffer;
+    Vector x(state.range(0), 1.0);
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        buffer.add(x);
+        auto y = buffer.get(1)[0];
+        benchmark::DoNotOptimize(y);
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_CircularBufferGet)
+        ->RangeMultiplier(4)
+        ->Range(1, 1024)
+        ->Complexity();
+
+static void BM_CircularBufferGetLatest(benchmark::State& state) {
+    CircularBuffer<16, Vector> buffer;
+    Vector x(state.range(0), 1.0);
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        buffer.add(x);
+        auto y = buffer.getLatest();
+        benchmark::DoNotOptimize(y);
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_CircularBufferGetLatest)
+        ->RangeMultiplier(4)
+        ->Range(1, 1024)
+        ->Complexity();
+
+static void BM_SyncManager(benchmark::State& state) {
+    // n IMU quaternions per sample, appended and retrieved at the sampling
+    // rate of the manager
+    const int n = state.range(0);
+    const double samplingRate = 100;
+    SyncManager<double> manager(samplingRate, 1e-3);
+    vector<pair<double, Vec4>> pack(n);
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        const double t = i++ / samplingRate;
+        for (int j = 0; j < n; ++j)
+            pack[j] = {t, Quaternion(1, 0, 0, 0.001 * i).asVec4()};
+        manager.appendPack(pack);
+        auto output = manager.getPack();
+        benchmark::DoNotOptimize(output);
+    }
+    state.SetComplexityN(n);
+}
+BENCHMARK(BM_SyncManager)->RangeMultiplier(2)->Range(1, 32)->Complexity();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,121 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkSignalProcessing.cpp
+ *
+ * \brief Microbenchmarks of the LowPassSmoothFilter and ButterworthFilter with
+ * the gait1992 kinematics, scaling over the number of filtered signals.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "AllocationCounter.h"
+#include "INIReader.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include "SignalProcessing.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <OpenSim/Common/TimeSeriesTable.h>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+/**
+ * Frames of `n` signals taken from the gait1992 kinematics. The coordinates
+ * are repeated when n is larger than the number of coordinates.
+ */
+static vector<Vector> getSignals(int n) {
+    static const TimeSeriesTable qTable = []() {
+        INIReader ini(INI_FILE);
+        auto section = "TEST_LOW_PASS_SMOOTH_FILTER";
+        auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+        auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+        auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+        Object::RegisterType(Thelen2003Muscle());
+        Model model(modelFile);
+        model.initSystem();
+        return OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+                model, ikFile, 0.01);
+    }();
+
+    vector<Vector> signals;
+    for (int i = 0; i < qTable.getNumRows(); ++i) {
+        auto q = qTable.getRowAtIndex(i).getAsVector();
+        Vector x(n);
+        for (int j = 0; j < n; ++j) x[j] = q[j % q.size()];
+        signals.push_back(x);
+    }
+    return signals;
+}
+
+static void BM_LowPassSmoothFilter(benchmark::State& state) {
+    INIReader ini(INI_FILE);
+    auto section = "TEST_LOW_PASS_SMOOTH_FILTER";
+    LowPassSmoothFilter::Parameters parameters;
+    parameters.numSignals = state.range(0);
+    parameters.memory = ini.getInteger(section, "MEMORY", 0);
+    parameters.delay = ini.getInteger(section, "DELAY", 0);
+    parameters.cutoffFrequency = ini.getReal(section, "CUTOFF_FREQ", 0);
+    parameters.splineOrder = ini.getInteger(section, "SPLINE_ORDER", 0);
+    parameters.calculateDerivatives = ini.getBoolean(section, "CALC_DER", true);
+    LowPassSmoothFilter filter(parameters);
+    auto signals = getSignals(parameters.numSignals);
+
+    // the signals are repeated, while the time keeps increasing
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto output = filter.filter({0.01 * i, signals[i % signals.size()]});
+        benchmark::DoNotOptimize(output);
+        i++;
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_LowPassSmoothFilter)
+        ->RangeMultiplier(2)
+        ->Range(1, 128)
+        ->Complexity();
+
+static void BM_ButterworthFilter(benchmark::State& state) {
+    INIReader ini(INI_FILE);
+    auto section = "TEST_BUTTERWORTH_FILTER";
+    auto cutOffFreq = ini.getInteger(section, "CUTOFF_FREQ", 0);
+    auto filtOrder = ini.getInteger(section, "FILTER_ORDER", 0);
+    const int n = state.range(0);
+    ButterworthFilter filter(n, filtOrder, (2 * cutOffFreq) / 100.0,
+                             ButterworthFilter::FilterType::LowPass,
+                             IIRFilter::InitialValuePolicy::Signal);
+    auto signals = getSignals(n);
+
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto x = filter.filter(signals[i]);
+        benchmark::DoNotOptimize(x);
+        if (++i == signals.size()) i = 0;
+    }
+    state.SetComplexityN(n);
+}
+BENCHMARK(BM_ButterworthFilter)
+        ->RangeMultiplier(2)
+        ->Range(1, 128)
+        ->Complexity();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,169 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BinaryLogger.h
+ *
+ * \brief Asynchronous logging of time series to a binary file, as a constant
+ * memory replacement of TimeSeriesTable::appendRow in real-time loops.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <OpenSim/Common/TimeSeriesTable.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#    include <fstream>
+#endif
+
+namespace OpenSimRT {
+
+/**
+ * \brief Logs rows of a time series (time and a fixed number of columns) to a
+ * binary file. appendRow() copies the row in a preallocated single-producer
+ * single-consumer ring without locking or allocating, and a background thread
+ * writes the rows to the file, which is mapped in memory in fixed-size
+ * windows (on Windows it is written with a stream). Thus, the memory does not
+ * grow with the length of the session and the caller does not wait for the
+ * disk. If the ring is full, the row is dropped and counted.
+ *
+ * The binary format consists of a fixed 64-byte header, the column labels
+ * (null-terminated, padded to 8 bytes) and the rows, each holding the time and
+ * the values as doubles. The number of rows is stored in the header by the
+ * writing thread after each batch of rows (and on close()), thus the rows of a
+ * file that was not closed (e.g., crash) are recovered without the zero
+ * padding of the last mapped window. Binary logs are converted with
+ * readTable(), convertToSTO() and convertToCSV().
+ */
+class Common_API BinaryLogger {
+ public:
+    /**
+     * Binary file header.
+     */
+    struct Header {
+        char magic[8];            // "OSRTLOG"
+        std::uint32_t version;    // format version
+        std::uint32_t numColumns; // number of values in each row (w/o time)
+        std::uint64_t numRows;    // number of rows written so far
+        std::uint64_t labelsSize; // bytes of the column labels
+        char reserved[32];        // pad to 64 bytes (keeps rows aligned)
+    };
+
+    /**
+     * Counters of the logger. The queue size is the high watermark of the rows
+     * waiting to be written.
+     */
+    struct Statistics {
+        long long written;
+        long long dropped;
+        int maxQueueSize;
+    };
+
+    /**
+     * Create the binary file and start the writing thread. `capacity` is the
+     * number of rows that can wait to be written.
+     */
+    BinaryLogger(const std::string& fileName,
+                 const std::vector<std::string>& columnLabels,
+                 int capacity = 4096);
+    /**
+     * Same as above, with the column labels of a logger table (e.g., created
+     * by InverseKinematics::initializeLogger).
+     */
+    BinaryLogger(const std::string& fileName,
+                 const OpenSim::TimeSeriesTable& table, int capacity = 4096);
+    ~BinaryLogger();
+    BinaryLogger(const BinaryLogger&) = delete;
+    BinaryLogger& operator=(const BinaryLogger&) = delete;
+
+    /**
+     * Queue a row for writing (single producer thread). Returns false if the
+     * ring is full or the logger is closed, in which case the row is dropped.
+     */
+    bool appendRow(const double& t, const SimTK::Vector& values);
+    bool appendRow(const double& t, const double* values);
+
+    /**
+     * Write the queued rows, stop the writing thread and finalize the file.
+     * Called by the destructor.
+     */
+    void close();
+
+    Statistics getStatistics() const;
+    int getNumColumns() const { return columnLabels.size(); }
+
+    /**
+     * Read a binary log in a table.
+     */
+    static OpenSim::TimeSeriesTable readTable(const std::string& fileName);
+
+    /**
+     * Convert a binary log to a .sto or .csv file.
+     */
+    static void convertToSTO(const std::string& binaryFileName,
+                             const std::string& stoFileName);
+    static void convertToCSV(const std::string& binaryFileName,
+                             const std::string& csvFileName);
+
+ private:
+    void writing();
+    void write(const char* data, std::size_t size);
+    void storeNumRows(std::uint64_t numRows);
+    void openFile(const std::string& fileName);
+    void closeFile();
+
+    std::vector<std::string> columnLabels;
+    Header header;
+    int rowSize; // number of doubles per row (including time)
+    int capacity;
+
+    // ring of rows (producer advances tail, writing thread advances head)
+    std::vector<double> ring;
+    std::atomic<std::uint64_t> head, tail;
+    std::atomic<long long> dropped;
+    std::atomic<int> maxQueueSize;
+    std::atomic<long long> written;
+
+    // writing thread
+    std::thread writer;
+    std::atomic_bool closing;
+    bool closed;
+    std::mutex monitor;
+    std::condition_variable wakeUp;
+
+    // output file
+    std::uint64_t fileSize; // bytes written
+#ifdef _WIN32
+    std::ofstream file;
+#else
+    int fd;
+    char* window;              // mapped window of the file
+    std::uint64_t windowStart; // offset of the window in the file
+#endif
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,188 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BoundedQueue.h
+ *
+ * \brief Implementation of a thread-safe bounded FIFO queue with a selectable
+ * overflow policy.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "Exception.h"
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * Select the behavior of the producer when the queue is full.
+ *
+ * - DROP_OLDEST discards the oldest element, thus the producer never waits.
+ *
+ * - BLOCK waits until the consumer frees a slot (backpressure), thus no element
+ * is lost.
+ */
+enum class OverflowPolicy { DROP_OLDEST, BLOCK };
+
+/**
+ * \brief A thread-safe bounded FIFO queue. The slots are preallocated and
+ * reused: `push()` assigns (or, for an rvalue, swaps) the element into a slot
+ * and `pop()`/`tryPop()` swap the slot with the element of the caller, thus
+ * after the first elements of the same size no memory is allocated. `close()`
+ * unblocks both sides (e.g., on termination); afterwards `push()` is ignored
+ * and the consumer can still retrieve the remaining elements.
+ */
+template <typename T> class BoundedQueue {
+ public:
+    struct Statistics {
+        long long pushed;
+        long long popped;
+        long long dropped;       // oldest elements discarded (DROP_OLDEST)
+        long long producerWaits; // pushes that waited for a slot (BLOCK)
+        long long emptyPops;     // pops without an element
+        int maxSize;             // high watermark of the queue
+    };
+
+    BoundedQueue(int capacity = 1,
+                 OverflowPolicy policy = OverflowPolicy::DROP_OLDEST)
+            : policy(policy), head(0), size(0), closed(false),
+              statistics{0, 0, 0, 0, 0, 0} {
+        if (capacity < 1) THROW_EXCEPTION("capacity should be positive");
+        slots.resize(capacity);
+    }
+
+    /**
+     * Append an element. When the queue is full, the oldest element is
+     * discarded or the producer waits, depending on the overflow policy.
+     * Returns false if the queue has been closed.
+     */
+    bool push(const T& value) {
+        return insert([&](T& slot) { slot = value; });
+    }
+
+    /**
+     * Same as push(const T&), but swaps `value` with the slot instead of
+     * copying it, thus `value` is left with the previous content of the slot,
+     * whose storage can be reused by the producer. On a closed queue `value`
+     * is unchanged.
+     */
+    bool push(T&& value) {
+        return insert([&](T& slot) { std::swap(slot, value); });
+    }
+
+    /**
+     * Retrieve the oldest element by swapping it with `value`. Blocks until an
+     * element is available or the queue is closed. Returns false (`value` is
+     * unchanged) if the queue is closed and empty.
+     */
+    bool pop(T& value) {
+        {
+            std::unique_lock<std::mutex> lock(monitor);
+            notEmpty.wait(lock, [&]() { return closed || size > 0; });
+            if (!popLocked(value)) return false;
+        }
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * Same as pop() but does not block. Returns false (`value` is unchanged)
+     * if the queue is empty.
+     */
+    bool tryPop(T& value) {
+        {
+            std::lock_guard<std::mutex> lock(monitor);
+            if (!popLocked(value)) return false;
+        }
+        notFull.notify_one();
+        return true;
+    }
+
+    /**
+     * Close the queue and unblock the producer and the consumer.
+     */
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(monitor);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    int capacity() const { return slots.size(); }
+
+    Statistics getStatistics() {
+        std::lock_guard<std::mutex> lock(monitor);
+        return statistics;
+    }
+
+ private:
+    bool isFull() const { return size == capacity(); }
+
+    // common implementation of push(), `assign` moves the element into a slot
+    template <typename Assign> bool insert(Assign assign) {
+        {
+            std::unique_lock<std::mutex> lock(monitor);
+            if (policy == OverflowPolicy::BLOCK && isFull()) {
+                statistics.producerWaits++;
+                notFull.wait(lock, [&]() { return closed || !isFull(); });
+            }
+            if (closed) return false;
+            if (isFull()) { // DROP_OLDEST
+                head = (head + 1) % capacity();
+                size--;
+                statistics.dropped++;
+            }
+            assign(slots[(head + size) % capacity()]);
+            size++;
+            statistics.pushed++;
+            if (size > statistics.maxSize) statistics.maxSize = size;
+        }
+        notEmpty.notify_one();
+        return true;
+    }
+
+    bool popLocked(T& value) {
+        if (size == 0) {
+            statistics.emptyPops++;
+            return false;
+        }
+        std::swap(slots[head], value);
+        head = (head + 1) % capacity();
+        size--;
+        statistics.popped++;
+        return true;
+    }
+
+    OverflowPolicy policy;
+    std::vector<T> slots;
+    int head; // index of the oldest element
+    int size;
+    bool closed;
+    Statistics statistics;
+    std::mutex monitor;
+    std::condition_variable notEmpty, notFull;
+};
+
+} // namespace OpenSimRT
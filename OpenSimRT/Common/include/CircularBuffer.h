@@ -58,7 +58,9 @@ enum class DataRetrievalMode { CONTINUOUS, ON_ENTRY };
  * retrieve data from the buffer (and terminate the 'wait' state of the consumer
  * thread) even if no new data have been added, the user must change the
  * retrieval mode. The order of the elements in the retrieved vector can be from
- * new-to-old (default) or old-to-new.
+ * new-to-old (default) or old-to-new. When only the newest element is needed,
+ * `getLatest()` copies a single element instead of M, and `drain()` returns
+ * (without blocking) all elements added since the previous read.
  *
  *                         Producer Thread | Consumer Thread
  *                                         |
@@ -104,6 +106,7 @@ template <int history, typename T> class CircularBuffer {
  public:
     CircularBuffer() {
         current = 0;
+        unread = 0;
         startOver = false;
         newValue = false;
         continuousModeFlag = false;
@@ -127,14 +130,16 @@ template <int history, typename T> class CircularBuffer {
      * Set the mode for data retrieval from the buffer. Retrieval can occur
      * continuously by retrieving the latest data from the buffer, or only after
      * new data have been added to the buffer. Notifies the buffer on mode
-     * change, thus it can be called at any moment.
+     * change, thus it can be called at any moment. The mode is changed under
+     * the lock, so that a consumer that has just evaluated its wait condition
+     * cannot miss the notification (e.g., the last one at end of stream).
      */
     void setDataRetrievalMode(DataRetrievalMode mode) {
-        if (mode == DataRetrievalMode::CONTINUOUS)
-            continuousModeFlag = true;
-        else
-            continuousModeFlag = false;
-        bufferNotEmpty.notify_one();
+        {
+            std::lock_guard<std::mutex> lock(monitor);
+            continuousModeFlag = mode == DataRetrievalMode::CONTINUOUS;
+        }
+        bufferNotEmpty.notify_all();
     }
 
     /**
@@ -148,6 +153,7 @@ template <int history, typename T> class CircularBuffer {
             buffer[current] = value;
             current++;
             newValue = true;
+            if (unread < history) unread++;
             if (current == history) {
                 current = 0;
                 startOver = true;
@@ -180,6 +186,7 @@ template <int history, typename T> class CircularBuffer {
                           // is no longer in "wait" state, and the cosumer
                           // thread draws data from the buffer until the buffer
                           // is empty again.
+        unread = 0;
 
         // if not empty get data
         std::vector<T> result;
@@ -194,8 +201,46 @@ template <int history, typename T> class CircularBuffer {
         return result;
     }
 
+    /**
+     * Retrieve the newest element of the buffer. Equivalent to get(1)[0] with
+     * the same blocking behavior, but copies a single element and does not
+     * allocate.
+     */
+    T getLatest() {
+        std::unique_lock<std::mutex> lock(monitor);
+        bufferNotEmpty.wait(lock, [&]() {
+            return isSize(1) && (continuousModeFlag.load() || newValue);
+        });
+        newValue = false;
+        unread = 0;
+        return buffer[(current == 0) ? history - 1 : current - 1];
+    }
+
+    /**
+     * Retrieve all elements that have been added since the last read (get,
+     * getLatest or drain), ordered from old-to-new. Does not block; returns an
+     * empty vector if no new elements are present. At most `history` elements
+     * are returned, thus older unread elements are lost when the producer
+     * overruns the buffer.
+     */
+    std::vector<T> drain() {
+        std::vector<T> result;
+        std::lock_guard<std::mutex> lock(monitor);
+        result.reserve(unread);
+        int index = current - unread;
+        if (index < 0) index += history;
+        for (int i = 0; i < unread; ++i) {
+            result.push_back(buffer[index]);
+            if (++index == history) index = 0;
+        }
+        newValue = false;
+        unread = 0;
+        return result;
+    }
+
  private:
     int current;
+    int unread; // number of elements added since the last read
     bool startOver;
     bool newValue;
     std::atomic<bool> continuousModeFlag;
@@ -19,13 +19,18 @@
  *
  * @file Measure.h
  *
- * \brief Utilities for measuring time.
+ * \brief Utilities for measuring time and latency histograms.
  *
  * @author Dimitar Stanev <jimstanev@gmail.com>
  */
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 
 namespace OpenSimRT {
 
@@ -44,4 +49,144 @@ namespace OpenSimRT {
                          .count()                                              \
               << "ms" << std::endl;
 
+// Timestamps of the latency instrumentation, compiled only when the project is
+// configured with ENABLE_LATENCY_INSTRUMENTATION (no cost otherwise).
+#ifdef ENABLE_LATENCY_INSTRUMENTATION
+#    define LATENCY_TIMESTAMP(timestamp)                                       \
+        timestamp = OpenSimRT::monotonicNanoseconds()
+#else
+#    define LATENCY_TIMESTAMP(timestamp)
+#endif
+
+/**
+ * Monotonic time in nanoseconds (steady clock, arbitrary epoch).
+ */
+inline std::int64_t monotonicNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+/**
+ * \brief Histogram of latencies (in nanoseconds) with logarithmic buckets that
+ * are linearly subdivided (as in HdrHistogram), thus the percentiles have a
+ * relative error below 1/128 (< 1%) from 1 ns up to 2^46 ns (~19 hours).
+ * Recording is a few relaxed atomic increments (lock-free, wait-free), thus the
+ * histogram can be updated by a real-time thread while another thread reads
+ * the statistics, which are then approximate.
+ */
+class LatencyHistogram {
+ public:
+    struct Statistics {
+        long long count;
+        double mean; // ns
+        double p50;  // ns
+        double p99;  // ns
+        double p999; // ns
+        double max;  // ns
+    };
+
+    LatencyHistogram() { reset(); }
+
+    /**
+     * Record a latency (negative values are recorded as 0 and values beyond
+     * the range as the maximum value of the range).
+     */
+    void record(std::int64_t nanoseconds) {
+        auto value = std::min<std::uint64_t>(std::max<std::int64_t>(
+                                                     nanoseconds, 0),
+                                             MAX_VALUE);
+        counts[index(value)].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        auto previous = maximum.load(std::memory_order_relaxed);
+        while (value > previous &&
+               !maximum.compare_exchange_weak(previous, value,
+                                              std::memory_order_relaxed))
+            ;
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * The value below which a fraction p \in [0, 1] of the latencies lies (the
+     * upper bound of its bucket). Returns 0 if empty.
+     */
+    double getPercentile(double p) const {
+        auto total = count.load(std::memory_order_relaxed);
+        if (total == 0) return 0;
+        auto rank = std::max<std::uint64_t>(1, std::ceil(p * total));
+        std::uint64_t cumulative = 0;
+        for (int i = 0; i < SIZE; ++i) {
+            cumulative += counts[i].load(std::memory_order_relaxed);
+            if (cumulative >= rank)
+                return std::min(highestEquivalentValue(i),
+                                maximum.load(std::memory_order_relaxed));
+        }
+        return maximum.load(std::memory_order_relaxed);
+    }
+
+    Statistics getStatistics() const {
+        auto n = count.load(std::memory_order_relaxed);
+        return {(long long) n,
+                n ? double(sum.load(std::memory_order_relaxed)) / n : 0.0,
+                getPercentile(0.5),
+                getPercentile(0.99),
+                getPercentile(0.999),
+                double(maximum.load(std::memory_order_relaxed))};
+    }
+
+    /**
+     * Clear the histogram (not thread safe with respect to record()).
+     */
+    void reset() {
+        for (auto& c : counts) c.store(0, std::memory_order_relaxed);
+        count = 0;
+        sum = 0;
+        maximum = 0;
+    }
+
+ private:
+    // 128 linear sub-buckets per power of two, thus the width of a bucket is
+    // below 1/128 of its values
+    static constexpr int SUB_BUCKET_BITS = 8;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int HALF_SUB_BUCKETS = SUB_BUCKETS / 2;
+    static constexpr int MAX_MSB = 45; // most significant bit of MAX_VALUE
+    static constexpr std::uint64_t MAX_VALUE = (std::uint64_t(1) << 46) - 1;
+    static constexpr int SIZE =
+            SUB_BUCKETS + (MAX_MSB - SUB_BUCKET_BITS + 1) * HALF_SUB_BUCKETS;
+
+    static int mostSignificantBit(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return 63 - __builtin_clzll(value | 1);
+#else
+        int msb = 0;
+        while (value >>= 1) ++msb;
+        return msb;
+#endif
+    }
+
+    // values below SUB_BUCKETS are exact, above each power of two
+    // 2^(b + SUB_BUCKET_BITS - 1) is divided in HALF_SUB_BUCKETS buckets of
+    // width 2^b
+    static int index(std::uint64_t value) {
+        int shift =
+                std::max(0, mostSignificantBit(value) - SUB_BUCKET_BITS + 1);
+        if (shift == 0) return value;
+        int subBucket = value >> shift; // [HALF_SUB_BUCKETS, SUB_BUCKETS)
+        return SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + subBucket -
+               HALF_SUB_BUCKETS;
+    }
+
+    static std::uint64_t highestEquivalentValue(int index) {
+        if (index < SUB_BUCKETS) return index;
+        int shift = (index - SUB_BUCKETS) / HALF_SUB_BUCKETS + 1;
+        std::uint64_t subBucket =
+                (index - SUB_BUCKETS) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+        return (subBucket << shift) + (std::uint64_t(1) << shift) - 1;
+    }
+
+    std::array<std::atomic<std::uint64_t>, SIZE> counts;
+    std::atomic<std::uint64_t> count, sum, maximum;
+};
+
 } // namespace OpenSimRT
@@ -0,0 +1,60 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file MemoryMappedFile.h
+ *
+ * \brief Read-only memory mapping of binary files.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "internal/CommonExports.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Maps a file in memory for reading (mmap on POSIX systems). On Windows
+ * the file is read in a memory buffer. The mapping is released when the object
+ * is destructed, thus pointers to the data must not outlive the object.
+ */
+class Common_API MemoryMappedFile {
+ public:
+    MemoryMappedFile(const std::string& fileName);
+    ~MemoryMappedFile();
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+    // pointer to the beginning of the file
+    const char* data() const { return address; }
+    // size of the file in bytes
+    std::size_t size() const { return length; }
+
+ private:
+    const char* address;
+    std::size_t length;
+#ifdef _WIN32
+    std::vector<char> buffer;
+#endif
+};
+
+} // namespace OpenSimRT
@@ -71,6 +71,34 @@ struct Common_API OpenSimUtils {
     static void updateState(const OpenSim::Model& model, SimTK::State& state,
                             const SimTK::Vector& q, const SimTK::Vector& qDot);
 
+    /**
+     * Indices of the generalized coordinates and speeds in the state, for the
+     * coordinates of the model in multibody tree order.
+     */
+    struct Common_API StateIndices {
+        std::vector<SimTK::QIndex> q;
+        std::vector<SimTK::UIndex> u;
+    };
+
+    /**
+     * Compute the StateIndices of a model with an initialized system.
+     */
+    static StateIndices getStateIndices(const OpenSim::Model& model,
+                                        const SimTK::State& state);
+
+    /**
+     * Bulk version of updateState. Writes the `q` and `qDot` vectors (in
+     * multibody tree order) directly into the Q and U of the state, through
+     * the precomputed indices, invalidating the Position stage once. Setting
+     * each coordinate instead realizes the position (or assembles the model if
+     * constrained) on every call. Equivalent to updateState for models without
+     * constraints. The constraints of the model are not enforced, thus for a
+     * constrained model the given `q` and `qDot` must already satisfy them
+     * (e.g., coupled coordinates from an IK solution of the same model).
+     */
+    static void updateState(const StateIndices& indices, SimTK::State& state,
+                            const SimTK::Vector& q, const SimTK::Vector& qDot);
+
     /**
      * Compare two OpenSim::Datatables or any of the derived types (as long as
      * they share the same data types). Comparison is performed by computing the
@@ -0,0 +1,118 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file PerformanceGate.h
+ *
+ * \brief Performance regression gate of the file-based tests: per-frame latency
+ * percentiles and throughput compared with stored baselines.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "Measure.h"
+#include "internal/CommonExports.h"
+#include <iosfwd>
+#include <string>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Per-frame latency percentiles and throughput of a replayed test,
+ * stored as a flat JSON object.
+ */
+struct Common_API PerformanceReport {
+    std::string name;
+    long long frames;
+    double throughput; // frames/s
+    double mean;       // ms
+    double p50;        // ms
+    double p99;        // ms
+    double p999;       // ms
+    double max;        // ms
+
+    /**
+     * Create a report from the latency statistics of the frames and the wall
+     * time of the replay (s).
+     */
+    static PerformanceReport
+    fromLatencies(const std::string& name,
+                  const LatencyHistogram::Statistics& latencies,
+                  double duration);
+
+    void write(const std::string& fileName) const;
+    static PerformanceReport read(const std::string& fileName);
+};
+
+/**
+ * \brief Checks the performance of a test against its baseline. The mode is
+ * selected from the command line of the test:
+ *
+ * --performance: replay as fast as possible, write the report to the output
+ *   directory and fail if the p99 latency or the throughput regressed with
+ *   respect to the baseline beyond the tolerances. A missing baseline fails
+ *   the gate unless ALLOW_MISSING_BASELINE is set.
+ *
+ * --update-baseline: replay as fast as possible and store the report as the
+ *   new baseline (to be committed after a verified change).
+ *
+ * The baseline directory (relative to the data directory) and the tolerances
+ * are read from the PERFORMANCE_GATE section of the .ini file. Baselines are
+ * machine specific, thus they should be recorded on the machine that runs the
+ * gate.
+ */
+class Common_API PerformanceGate {
+ public:
+    enum class Mode { DISABLED, CHECK, UPDATE_BASELINE };
+
+    struct Tolerances {
+        double p99;         // allowed relative increase of the p99 latency
+        double p99Absolute; // allowed absolute increase of the p99 (ms)
+        double throughput;  // allowed relative decrease of the throughput
+    };
+
+    PerformanceGate(int argc, char* argv[], const std::string& iniFile,
+                    const std::string& dataDir, const std::string& outputDir);
+
+    Mode getMode() const { return mode; }
+    bool isEnabled() const { return mode != Mode::DISABLED; }
+
+    /**
+     * Write the report and compare it with the baseline (or store it as the
+     * baseline). Throws with a readable diff if performance regressed.
+     */
+    void submit(const PerformanceReport& report) const;
+
+    /**
+     * Write a table with the baseline and measured metrics to `diff`. Returns
+     * false if the p99 latency or the throughput regressed.
+     */
+    static bool compare(const PerformanceReport& measured,
+                        const PerformanceReport& baseline,
+                        const Tolerances& tolerances, std::ostream& diff);
+
+ private:
+    Mode mode;
+    Tolerances tolerances;
+    bool allowMissingBaseline;
+    std::string baselineDir;
+    std::string outputDir;
+};
+
+} // namespace OpenSimRT
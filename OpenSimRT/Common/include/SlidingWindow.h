@@ -22,15 +22,14 @@
  * \brief Basic implementation of a sliding window. Computes the mean value of a
  * fixed n-sized buffer.
  *
- * TODO: This implementation is very primitive and should be upgraded later on.
- *
  * @author Filip Konstantinos <filip.k@ece.upatras.gr>
  */
 #pragma once
 
 #include "internal/CommonExports.h"
 #include <SimTKcommon.h>
-#include <numeric>
+#include <stdexcept>
+#include <type_traits>
 
 namespace OpenSimRT {
 
@@ -38,59 +37,146 @@ namespace OpenSimRT {
  * a fixed sized buffer, and old data are discarded. The size of the window is
  * determined from the number of elements passed in 'init()' member function or
  * by explicitely setting the size with 'setSize()' member function. The mean
- * value can be computed using the 'mean()' member function. */
-template <typename T> struct SlidingWindow {
-    SimTK::Array_<T> data; // sliding window data
-    std::size_t capacity;  // sliding window size
+ * value can be computed using the 'mean()' member function.
+ *
+ * The elements are stored in a circular array, thus insertion does not move
+ * the elements of the window. A running sum is updated on insertion with
+ * compensated (Kahan) summation, so that the round-off error does not grow
+ * with the number of insertions, and consecutive equal elements are tracked as
+ * runs, thus 'insert()', 'mean()', 'equal()', 'nFirstEqual()' and
+ * 'nLastEqual()' are O(1). The sum is not maintained for enumerations. A
+ * window of size zero does not store any element. The elements and the size
+ * are read through 'getData()' (or 'operator[]') and 'getCapacity()', since
+ * modifying them directly would invalidate the running sum and the runs. */
+template <typename T> class SlidingWindow {
+ public:
+    SlidingWindow() : capacity(0) { clear(); }
 
     // set initial values
     void init(SimTK::Array_<T>&& aData) {
-        data = std::forward<SimTK::Array_<T>>(aData);
-        capacity = data.size();
+        setSize(aData.size());
+        for (const auto& x : aData) insert(x);
     }
 
     // insert element
     void insert(const T& x) {
-        if (data.size() == capacity) data.erase(data.begin());
-        data.push_back(x);
+        if (capacity == 0) return;
+        if (count == capacity) pop();
+
+        // append element
+        data[(first + count) % capacity] = x;
+        count++;
+
+        // extend the last run or start a new one
+        if (runCount > 0 && runs[lastRun()].value == x) {
+            runs[lastRun()].length++;
+        } else {
+            runs[(firstRun + runCount) % capacity] = {x, 1};
+            runCount++;
+        }
+
+        // update running sum
+        if constexpr (hasSum) accumulate(x);
     }
 
-    // reserve space in memory
+    // reserve space in memory (clears the window)
     void setSize(const std::size_t& size) {
         capacity = size;
-        data.reserve(size);
+        data.resize(size);
+        runs.resize(size);
+        clear();
     }
 
-    // compute mean value of the window
-    T mean() {
-        return 1.0 * std::accumulate(data.begin(), data.end(), T()) /
-               int(data.size());
+    // sliding window size
+    std::size_t getCapacity() const { return capacity; }
+
+    // number of elements in the window
+    std::size_t size() const { return count; }
+
+    // copy of the elements in window order (0 is the oldest)
+    SimTK::Array_<T> getData() const {
+        SimTK::Array_<T> elements;
+        elements.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) elements.push_back((*this)[i]);
+        return elements;
+    }
+
+    // i-th element of the window (0 is the oldest)
+    const T& operator[](const std::size_t& i) const {
+        if (i >= count) throw std::out_of_range("Index out of range");
+        return data[(first + i) % capacity];
     }
+
+    // oldest element
+    const T& front() const { return (*this)[0]; }
+
+    // newest element
+    const T& back() const { return (*this)[count - 1]; }
+
+    // compute mean value of the window
+    T mean() const { return 1.0 * sum / int(count); }
+
     // Determine if all elements in the window are equal to input value
-    bool equal(const T& x) {
-        for (const auto& e : data) {
-            if (e != x) return false;
-        }
-        return true;
+    bool equal(const T& x) const {
+        return runCount == 0 || (runCount == 1 && runs[firstRun].value == x);
     }
 
     // Determine if the n first elements are equal to input value.
     bool nFirstEqual(const T& x, const size_t& n) const {
-        if (n > data.size()) throw std::runtime_error("Wrong input size");
-        for (size_t i = 0; i < n; ++i) {
-            if (data[i] != x) return false;
-        }
-        return true;
+        if (n > count) throw std::runtime_error("Wrong input size");
+        return n == 0 ||
+               (runs[firstRun].value == x && runs[firstRun].length >= n);
     }
 
     // Determine if the last n elements are equal to input value.
     bool nLastEqual(const T& x, const size_t& n) const {
-        if (n > data.size()) throw std::runtime_error("Wrong input size");
-        for (size_t i = 0; i < n; ++i) {
-            if (data[data.size() - i - 1] != x) return false;
+        if (n > count) throw std::runtime_error("Wrong input size");
+        return n == 0 ||
+               (runs[lastRun()].value == x && runs[lastRun()].length >= n);
+    }
+
+ private:
+    // consecutive equal elements
+    struct Run {
+        T value;
+        std::size_t length;
+    };
+
+    static constexpr bool hasSum = !std::is_enum<T>::value;
+
+    void clear() {
+        first = count = 0;
+        firstRun = runCount = 0;
+        sum = compensation = T(0);
+    }
+
+    std::size_t lastRun() const { return (firstRun + runCount - 1) % capacity; }
+
+    // discard the oldest element
+    void pop() {
+        if constexpr (hasSum) accumulate(-data[first]);
+        first = (first + 1) % capacity;
+        count--;
+        if (--runs[firstRun].length == 0) {
+            firstRun = (firstRun + 1) % capacity;
+            runCount--;
         }
-        return true;
     }
+
+    // add x to the running sum, keeping the low-order bits that are lost in
+    // the addition in the compensation term (Kahan summation)
+    void accumulate(const T& x) {
+        T y = x - compensation;
+        T t = sum + y;
+        compensation = (t - sum) - y;
+        sum = t;
+    }
+
+    SimTK::Array_<T> data;   // circular array of the elements
+    SimTK::Array_<Run> runs; // circular array of the runs of the elements
+    std::size_t capacity;    // sliding window size
+    std::size_t first, count, firstRun, runCount;
+    T sum, compensation;
 };
 
 } // namespace OpenSimRT
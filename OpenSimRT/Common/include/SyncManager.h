@@ -27,6 +27,7 @@
 #pragma once
 
 #include "Exception.h"
+#include "Tracer.h"
 #include "TypeHelpers.h"
 #include "Utils.h"
 #include "internal/CommonExports.h"
@@ -77,6 +78,7 @@ template <typename ETX = double> class SyncManager {
      * @param delay - Delay in number of samples of the output entry. Default=1.
      */
     std::pair<ETX, std::vector<SimTK::Vector_<ETX>>> getPack(size_t delay = 1) {
+        TRACE_SPAN("SyncManager::getPack");
         const auto& v = _table.getIndependentColumn();
         if (!_isCurrentTimeSet) {
             interpolateNanValues();
@@ -146,6 +148,7 @@ template <typename ETX = double> class SyncManager {
      * Measurments can be of double type or SimTK::Vec of SimTK::Vector type.
      */
     template <typename... Args> void appendPack(Args&&... args) {
+        TRACE_SPAN("SyncManager::appendPack");
         // create tuple from args to allow different types
         using ArgsTuple = std::tuple<Args...>;
         ArgsTuple argTuple = {std::forward<Args>(args)...};
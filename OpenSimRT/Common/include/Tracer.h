@@ -0,0 +1,121 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file Tracer.h
+ *
+ * \brief Lightweight span tracer with per-thread ring buffers and export to the
+ * Chrome trace-event format (chrome://tracing, https://ui.perfetto.dev).
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "Measure.h"
+#include "internal/CommonExports.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+// Spans of the tracer, compiled only when the project is configured with
+// ENABLE_TRACING (no cost otherwise). The name must be a string literal.
+#ifdef ENABLE_TRACING
+#    define TRACE_CONCATENATE_(a, b) a##b
+#    define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_(a, b)
+#    define TRACE_SPAN(name)                                                   \
+        OpenSimRT::TraceSpan TRACE_CONCATENATE(traceSpan, __LINE__)(name)
+#    define TRACE_THREAD_NAME(name) OpenSimRT::Tracer::setThreadName(name)
+#else
+#    define TRACE_SPAN(name)
+#    define TRACE_THREAD_NAME(name)
+#endif
+
+/**
+ * \brief Records spans (name, start and end time) of the calling thread in a
+ * fixed-size ring buffer that is allocated on the first span of the thread.
+ * Recording does not lock or allocate; when the ring is full the oldest spans
+ * are overwritten, thus the tracer keeps the most recent history of each
+ * thread. The rings of all threads are exported on demand as Chrome trace-event
+ * JSON, optionally restricted to the last seconds of the session, e.g., right
+ * after a latency spike.
+ */
+class Common_API Tracer {
+ public:
+    // number of spans per thread (power of 2)
+    static constexpr int capacity = 1 << 14;
+
+    /**
+     * A completed span. The name points to a string literal.
+     */
+    struct Event {
+        const char* name;
+        std::int64_t start; // ns (monotonicNanoseconds)
+        std::int64_t end;   // ns
+        int thread;         // thread id assigned by the tracer
+    };
+
+    /**
+     * Record a span of the calling thread (see TraceSpan).
+     */
+    static void record(const char* name, std::int64_t start, std::int64_t end);
+
+    /**
+     * Name the calling thread in the exported trace.
+     */
+    static void setThreadName(const std::string& name);
+
+    /**
+     * Consistent copy of the spans of all threads that ended in the last
+     * `window` seconds (all spans if window <= 0), ordered by start time. Spans
+     * that are overwritten while copying are skipped.
+     */
+    static std::vector<Event> getEvents(double window = 0);
+
+    /**
+     * Write the spans of the last `window` seconds (all spans if window <= 0)
+     * in Chrome trace-event JSON. Returns the number of exported spans.
+     */
+    static int exportChromeTrace(const std::string& fileName,
+                                 double window = 0);
+
+    /**
+     * Discard the recorded spans of all threads.
+     */
+    static void clear();
+};
+
+/**
+ * \brief RAII span: measures the lifetime of the object and records it in the
+ * tracer. Use through the TRACE_SPAN macro.
+ */
+class TraceSpan {
+ public:
+    explicit TraceSpan(const char* name)
+            : name(name), start(monotonicNanoseconds()) {}
+    ~TraceSpan() { Tracer::record(name, start, monotonicNanoseconds()); }
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+    const char* name;
+    std::int64_t start;
+};
+
+} // namespace OpenSimRT
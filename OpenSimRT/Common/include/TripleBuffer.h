@@ -0,0 +1,114 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TripleBuffer.h
+ *
+ * \brief Implementation of a lock-free triple buffer for publishing the latest
+ * result of a producer thread to a consumer thread.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <utility>
+
+namespace OpenSimRT {
+
+/**
+ * \brief A single-producer single-consumer triple buffer. The producer writes
+ * into a private back slot (`write()`) and `publish()`es it by exchanging it
+ * with the middle slot. The consumer `acquire()`s the latest published slot by
+ * exchanging its private front slot with the middle slot and then reads it
+ * (`read()`) or swaps its content out (`swap()`). Neither side waits for the
+ * other: the exchanges are single atomic operations on the index of the middle
+ * slot, and the slots are preallocated and reused, thus after the first
+ * results of the same size no memory is allocated.
+ *
+ * The buffer counts the publications, the overwrites (a published slot that
+ * was replaced before the consumer acquired it) and the stale reads (an
+ * acquire without a new publication).
+ *
+ *          Producer Thread         |         Consumer Thread
+ *                                  |
+ *  write() --> [back] --publish()--> [middle] --acquire()--> [front] -> read()
+ */
+template <typename T> class TripleBuffer {
+ public:
+    TripleBuffer()
+            : back(0), middle(1), front(2), published(0), overwrites(0),
+              staleReads(0) {}
+
+    /**
+     * The slot that the producer writes into (producer thread only).
+     */
+    T& write() { return slots[back]; }
+
+    /**
+     * Make the written slot the latest result (producer thread only).
+     */
+    void publish() {
+        int previous = middle.exchange(back | FRESH);
+        back = previous & INDEX;
+        published++;
+        if (previous & FRESH) overwrites++;
+    }
+
+    /**
+     * Make the latest published result readable (consumer thread only).
+     * Returns false if nothing was published since the previous acquire, in
+     * which case the previous result remains readable.
+     */
+    bool acquire() {
+        if (!(middle.load() & FRESH)) {
+            staleReads++;
+            return false;
+        }
+        front = middle.exchange(front) & INDEX;
+        return true;
+    }
+
+    /**
+     * The acquired result (consumer thread only).
+     */
+    const T& read() const { return slots[front]; }
+
+    /**
+     * Exchange the acquired result with `other`, whose storage is then reused
+     * by the producer (consumer thread only).
+     */
+    void swap(T& other) { std::swap(slots[front], other); }
+
+    long long getPublished() const { return published.load(); }
+    long long getOverwrites() const { return overwrites.load(); }
+    long long getStaleReads() const { return staleReads.load(); }
+
+ private:
+    static constexpr int INDEX = 3;
+    static constexpr int FRESH = 4;
+
+    std::array<T, 3> slots;
+    int back;                // producer slot
+    std::atomic<int> middle; // index of the middle slot | FRESH
+    int front;               // consumer slot
+    std::atomic<long long> published, overwrites, staleReads;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,308 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "BinaryLogger.h"
+#include "Exception.h"
+#include "MemoryMappedFile.h"
+#include <OpenSim/Common/CSVFileAdapter.h>
+#include <OpenSim/Common/STOFileAdapter.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#ifndef _WIN32
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+
+using namespace OpenSimRT;
+using namespace SimTK;
+using namespace std;
+
+#define BINARY_FORMAT_MAGIC "OSRTLOG"
+#define BINARY_FORMAT_VERSION 1
+
+static_assert(sizeof(BinaryLogger::Header) == 64,
+              "Binary header must be 64 bytes.");
+
+// size of the mapped window of the file (multiple of the page size)
+static const uint64_t WINDOW_SIZE = 1 << 22;
+
+// the writing thread checks for new rows at this period when idle
+static const chrono::milliseconds WRITING_PERIOD(10);
+
+/*******************************************************************************/
+
+BinaryLogger::BinaryLogger(const string& fileName,
+                           const vector<string>& columnLabels,
+                           int capacity)
+        : columnLabels(columnLabels), rowSize(columnLabels.size() + 1),
+          capacity(capacity), head(0), tail(0), dropped(0), maxQueueSize(0),
+          written(0), closing(false), closed(false), fileSize(0) {
+    if (capacity < 1) THROW_EXCEPTION("capacity should be positive");
+    ring.resize(capacity * rowSize);
+
+    // header followed by the null-terminated labels (padded to 8 bytes)
+    string labels;
+    for (const auto& label : columnLabels) labels += label + '\0';
+    labels.resize((labels.size() + 7) / 8 * 8, '\0');
+    memset(&header, 0, sizeof(Header));
+    strncpy(header.magic, BINARY_FORMAT_MAGIC, sizeof(header.magic));
+    header.version = BINARY_FORMAT_VERSION;
+    header.numColumns = columnLabels.size();
+    header.numRows = 0;
+    header.labelsSize = labels.size();
+
+    openFile(fileName);
+    write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    write(labels.data(), labels.size());
+
+    writer = thread(&BinaryLogger::writing, this);
+}
+
+BinaryLogger::BinaryLogger(const string& fileName,
+                           const OpenSim::TimeSeriesTable& table, int capacity)
+        : BinaryLogger(fileName, table.getColumnLabels(), capacity) {}
+
+BinaryLogger::~BinaryLogger() {
+    try {
+        close();
+    } catch (exception& e) { cout << e.what() << endl; }
+}
+
+bool BinaryLogger::appendRow(const double& t, const Vector& values) {
+    if (values.size() != getNumColumns())
+        THROW_EXCEPTION("row size does not match the number of columns");
+    if (values.hasContiguousData()) return appendRow(t, &values[0]);
+    Vector copy(values); // e.g., a strided view
+    return appendRow(t, &copy[0]);
+}
+
+bool BinaryLogger::appendRow(const double& t, const double* values) {
+    // only the producer advances the tail
+    const auto last = tail.load(memory_order_relaxed);
+    const auto first = head.load(memory_order_acquire);
+    if (closing.load(memory_order_relaxed) || last - first >= capacity) {
+        dropped++;
+        return false;
+    }
+    double* row = &ring[(last % capacity) * rowSize];
+    row[0] = t;
+    copy(values, values + rowSize - 1, row + 1);
+    tail.store(last + 1, memory_order_release);
+
+    const int size = last + 1 - first;
+    if (size > maxQueueSize.load(memory_order_relaxed)) maxQueueSize = size;
+    return true;
+}
+
+void BinaryLogger::close() {
+    if (closed) return;
+    closed = true;
+    {
+        lock_guard<mutex> lock(monitor);
+        closing = true;
+    }
+    wakeUp.notify_one();
+    writer.join();
+
+    header.numRows = written;
+    closeFile();
+}
+
+BinaryLogger::Statistics BinaryLogger::getStatistics() const {
+    return {written.load(), dropped.load(), maxQueueSize.load()};
+}
+
+void BinaryLogger::writing() {
+    try {
+        while (true) {
+            // the flag is read before the tail, thus no row appended before
+            // closing is missed
+            const bool finished = closing;
+            const auto first = head.load(memory_order_relaxed);
+            const auto last = tail.load(memory_order_acquire);
+            if (first == last) {
+                if (finished) break;
+                unique_lock<mutex> lock(monitor);
+                wakeUp.wait_for(lock, WRITING_PERIOD,
+                                [&]() { return closing.load(); });
+                continue;
+            }
+
+            // the queued rows are at most two contiguous parts of the ring
+            const int start = first % capacity;
+            const int n = last - first;
+            const int contiguous = min(n, capacity - start);
+            const size_t bytes = rowSize * sizeof(double);
+            write(reinterpret_cast<const char*>(&ring[start * rowSize]),
+                  contiguous * bytes);
+            if (n > contiguous)
+                write(reinterpret_cast<const char*>(&ring[0]),
+                      (n - contiguous) * bytes);
+            written += n;
+            head.store(last, memory_order_release);
+
+            // commit the rows, after they have been written
+            storeNumRows(written);
+        }
+    } catch (exception& e) {
+        // the producer drops the rows from now on
+        cout << e.what() << endl;
+    }
+}
+
+#ifdef _WIN32
+
+void BinaryLogger::openFile(const string& fileName) {
+    file.open(fileName, ios::binary | ios::trunc);
+    if (!file) THROW_EXCEPTION("Unable to open file: " + fileName);
+}
+
+void BinaryLogger::write(const char* data, size_t size) {
+    file.write(data, size);
+    if (!file) THROW_EXCEPTION("Unable to write log file");
+    fileSize += size;
+}
+
+void BinaryLogger::storeNumRows(uint64_t numRows) {
+    // the file is not padded, thus the rows are deduced from its size
+}
+
+void BinaryLogger::closeFile() {
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    file.close();
+}
+
+#else
+
+void BinaryLogger::openFile(const string& fileName) {
+    fd = open(fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) THROW_EXCEPTION("Unable to open file: " + fileName);
+    windowStart = 0;
+    window = nullptr;
+}
+
+void BinaryLogger::write(const char* data, size_t size) {
+    const char* bytes = data;
+    while (size > 0) {
+        // map the next window of the file when the current one is full
+        if (!window || fileSize == windowStart + WINDOW_SIZE) {
+            if (window) {
+                munmap(window, WINDOW_SIZE);
+                windowStart += WINDOW_SIZE;
+            }
+            window = nullptr;
+            if (ftruncate(fd, windowStart + WINDOW_SIZE) < 0)
+                THROW_EXCEPTION("Unable to resize log file");
+            void* p = mmap(nullptr, WINDOW_SIZE, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fd, windowStart);
+            if (p == MAP_FAILED) THROW_EXCEPTION("Unable to map log file");
+            window = static_cast<char*>(p);
+        }
+        const size_t offset = fileSize - windowStart;
+        const size_t n = min<size_t>(size, WINDOW_SIZE - offset);
+        memcpy(window + offset, bytes, n);
+        bytes += n;
+        size -= n;
+        fileSize += n;
+    }
+}
+
+void BinaryLogger::storeNumRows(uint64_t numRows) {
+    // the header is written through the file descriptor, since the first
+    // window may be unmapped (same page cache as the mapped windows)
+    const auto offset = offsetof(Header, numRows);
+    if (pwrite(fd, &numRows, sizeof(numRows), offset) != sizeof(numRows))
+        THROW_EXCEPTION("Unable to write log file");
+}
+
+void BinaryLogger::closeFile() {
+    if (window) munmap(window, WINDOW_SIZE);
+    window = nullptr;
+    // remove the unused part of the last window and store the number of rows
+    bool failed = ftruncate(fd, fileSize) < 0 ||
+                  pwrite(fd, &header, sizeof(Header), 0) != sizeof(Header);
+    ::close(fd);
+    if (failed) THROW_EXCEPTION("Unable to finalize log file");
+}
+
+#endif
+
+/*******************************************************************************/
+
+OpenSim::TimeSeriesTable BinaryLogger::readTable(const string& fileName) {
+    MemoryMappedFile file(fileName);
+    if (file.size() < sizeof(Header))
+        THROW_EXCEPTION("Invalid binary log file: " + fileName);
+    Header header;
+    memcpy(&header, file.data(), sizeof(Header));
+    if (strncmp(header.magic, BINARY_FORMAT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BINARY_FORMAT_VERSION ||
+        file.size() < sizeof(Header) + header.labelsSize)
+        THROW_EXCEPTION("Invalid binary log file: " + fileName);
+
+    // labels
+    vector<string> labels;
+    const char* label = file.data() + sizeof(Header);
+    for (int i = 0; i < header.numColumns; ++i) {
+        labels.push_back(label);
+        label += labels.back().size() + 1;
+    }
+
+    // rows (bounded by the file size if the logger was not closed)
+    const int rowSize = header.numColumns + 1;
+    const size_t offset = sizeof(Header) + header.labelsSize;
+    size_t numRows = (file.size() - offset) / (rowSize * sizeof(double));
+    const double* rows = reinterpret_cast<const double*>(file.data() + offset);
+    if (header.numRows > 0) {
+        numRows = min<size_t>(numRows, header.numRows);
+    } else {
+        // no committed rows (e.g., crash before the first batch was
+        // committed), thus drop the zero padding of the last mapped window
+        auto isZero = [&](size_t i) {
+            const double* row = rows + i * rowSize;
+            return all_of(row, row + rowSize, [](double x) { return x == 0; });
+        };
+        while (numRows > 0 && isZero(numRows - 1)) numRows--;
+    }
+    vector<double> times(numRows);
+    Matrix values(numRows, header.numColumns);
+    for (size_t i = 0; i < numRows; ++i) {
+        const double* row = rows + i * rowSize;
+        times[i] = row[0];
+        for (int j = 0; j < header.numColumns; ++j) values(i, j) = row[j + 1];
+    }
+    return OpenSim::TimeSeriesTable(times, values, labels);
+}
+
+void BinaryLogger::convertToSTO(const string& binaryFileName,
+                                const string& stoFileName) {
+    OpenSim::STOFileAdapter::write(readTable(binaryFileName), stoFileName);
+}
+
+void BinaryLogger::convertToCSV(const string& binaryFileName,
+                                const string& csvFileName) {
+    OpenSim::CSVFileAdapter::write(readTable(binaryFileName), csvFileName);
+}
+
+/*******************************************************************************/
@@ -0,0 +1,77 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "MemoryMappedFile.h"
+#include "Exception.h"
+
+#ifdef _WIN32
+#    include <fstream>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+using namespace OpenSimRT;
+
+#ifdef _WIN32
+
+MemoryMappedFile::MemoryMappedFile(const std::string& fileName) {
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file) THROW_EXCEPTION("Unable to open file: " + fileName);
+    length = file.tellg();
+    buffer.resize(length);
+    file.seekg(0);
+    file.read(buffer.data(), length);
+    address = buffer.data();
+}
+
+MemoryMappedFile::~MemoryMappedFile() {}
+
+#else
+
+MemoryMappedFile::MemoryMappedFile(const std::string& fileName) {
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) THROW_EXCEPTION("Unable to open file: " + fileName);
+    struct stat info;
+    if (fstat(fd, &info) < 0) {
+        close(fd);
+        THROW_EXCEPTION("Unable to stat file: " + fileName);
+    }
+    length = info.st_size;
+    address = nullptr;
+    if (length > 0) {
+        void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            THROW_EXCEPTION("Unable to map file: " + fileName);
+        }
+        // data are read sequentially during replay
+        madvise(p, length, MADV_SEQUENTIAL);
+        address = static_cast<const char*>(p);
+    }
+    close(fd); // the mapping remains valid after closing the descriptor
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+    if (address) munmap(const_cast<char*>(address), length);
+}
+
+#endif
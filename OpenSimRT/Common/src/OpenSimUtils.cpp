@@ -20,6 +20,7 @@
 #include "OpenSimUtils.h"
 #include "DynamicLibraryLoader.h"
 #include <Common/TimeSeriesTable.h>
+#include <iostream>
 
 using OpenSim::Actuator;
 using OpenSim::Model;
@@ -177,3 +178,32 @@ void OpenSimUtils::updateState(const OpenSim::Model& model, SimTK::State& state,
         coordinateSet[i]->setSpeedValue(state, qDot[i]);
     }
 }
+
+OpenSimUtils::StateIndices
+OpenSimUtils::getStateIndices(const OpenSim::Model& model,
+                              const SimTK::State& state) {
+    StateIndices indices;
+    const auto& matter = model.getMatterSubsystem();
+    for (const auto& coordinate : model.getCoordinatesInMultibodyTreeOrder()) {
+        // same as Coordinate::setValue/setSpeedValue
+        const auto& mobod = matter.getMobilizedBody(coordinate->getBodyIndex());
+        indices.q.push_back(SimTK::QIndex(mobod.getFirstQIndex(state) +
+                                          coordinate->getMobilizerQIndex()));
+        indices.u.push_back(SimTK::UIndex(mobod.getFirstUIndex(state) +
+                                          coordinate->getMobilizerQIndex()));
+    }
+    return indices;
+}
+
+void OpenSimUtils::updateState(const StateIndices& indices, SimTK::State& state,
+                               const SimTK::Vector& q,
+                               const SimTK::Vector& qDot) {
+    if (indices.q.size() != q.size() || indices.u.size() != qDot.size())
+        THROW_EXCEPTION("Wrong dimensions");
+    auto& Q = state.updQ();
+    auto& U = state.updU();
+    for (size_t i = 0; i < indices.q.size(); ++i) {
+        Q[indices.q[i]] = q[i];
+        U[indices.u[i]] = qDot[i];
+    }
+}
@@ -0,0 +1,218 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "PerformanceGate.h"
+#include "Exception.h"
+#include "INIReader.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace OpenSimRT;
+using namespace std;
+
+namespace {
+
+/**
+ * Value of a number field of a flat JSON object (no nesting, as written by
+ * PerformanceReport::write).
+ */
+double getNumber(const string& json, const string& key,
+                 const string& fileName) {
+    auto position = json.find("\"" + key + "\"");
+    if (position != string::npos) position = json.find(':', position);
+    if (position == string::npos)
+        THROW_EXCEPTION("Missing field '" + key + "' in: " + fileName);
+    const char* begin = json.c_str() + position + 1;
+    char* end;
+    double value = strtod(begin, &end);
+    if (end == begin)
+        THROW_EXCEPTION("Invalid field '" + key + "' in: " + fileName);
+    return value;
+}
+
+string getString(const string& json, const string& key,
+                 const string& fileName) {
+    auto position = json.find("\"" + key + "\"");
+    if (position != string::npos) position = json.find(':', position);
+    if (position != string::npos) position = json.find('"', position);
+    auto end = position == string::npos ? position
+                                        : json.find('"', position + 1);
+    if (end == string::npos)
+        THROW_EXCEPTION("Missing field '" + key + "' in: " + fileName);
+    return json.substr(position + 1, end - position - 1);
+}
+
+/**
+ * A row of the diff table. Returns false if the metric regressed beyond the
+ * allowed limit.
+ */
+bool compareRow(ostream& diff, const string& metric, double baseline,
+                double measured, double limit, bool higherIsWorse,
+                bool checked) {
+    double change = baseline != 0 ? 100 * (measured - baseline) / baseline : 0;
+    bool ok = !checked ||
+              (higherIsWorse ? measured <= limit : measured >= limit);
+    ostringstream limitText;
+    if (checked)
+        limitText << (higherIsWorse ? "<= " : ">= ") << fixed
+                  << setprecision(3) << limit;
+    diff << left << setw(18) << metric << right << fixed << setprecision(3)
+         << setw(14) << baseline << setw(14) << measured << setw(9)
+         << setprecision(1) << showpos << change << noshowpos << "%"
+         << setw(16) << limitText.str();
+    if (checked) diff << "  " << (ok ? "ok" : "REGRESSION");
+    diff << endl;
+    return ok;
+}
+
+} // namespace
+
+/******************************************************************************/
+
+PerformanceReport
+PerformanceReport::fromLatencies(const string& name,
+                                 const LatencyHistogram::Statistics& latencies,
+                                 double duration) {
+    return {name,
+            latencies.count,
+            duration > 0 ? latencies.count / duration : 0.0,
+            latencies.mean * 1e-6,
+            latencies.p50 * 1e-6,
+            latencies.p99 * 1e-6,
+            latencies.p999 * 1e-6,
+            latencies.max * 1e-6};
+}
+
+void PerformanceReport::write(const string& fileName) const {
+    ofstream file(fileName);
+    if (!file) THROW_EXCEPTION("Unable to open file: " + fileName);
+    file << fixed << setprecision(6) << "{\n"
+         << "  \"name\": \"" << name << "\",\n"
+         << "  \"frames\": " << frames << ",\n"
+         << "  \"throughput\": " << throughput << ",\n"
+         << "  \"mean\": " << mean << ",\n"
+         << "  \"p50\": " << p50 << ",\n"
+         << "  \"p99\": " << p99 << ",\n"
+         << "  \"p999\": " << p999 << ",\n"
+         << "  \"max\": " << max << "\n"
+         << "}\n";
+}
+
+PerformanceReport PerformanceReport::read(const string& fileName) {
+    ifstream file(fileName);
+    if (!file) THROW_EXCEPTION("Unable to open file: " + fileName);
+    stringstream buffer;
+    buffer << file.rdbuf();
+    auto json = buffer.str();
+    return {getString(json, "name", fileName),
+            (long long) getNumber(json, "frames", fileName),
+            getNumber(json, "throughput", fileName),
+            getNumber(json, "mean", fileName),
+            getNumber(json, "p50", fileName),
+            getNumber(json, "p99", fileName),
+            getNumber(json, "p999", fileName),
+            getNumber(json, "max", fileName)};
+}
+
+/******************************************************************************/
+
+PerformanceGate::PerformanceGate(int argc, char* argv[], const string& iniFile,
+                                 const string& dataDir,
+                                 const string& outputDir)
+        : mode(Mode::DISABLED), outputDir(outputDir) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--performance") == 0)
+            mode = Mode::CHECK;
+        else if (strcmp(argv[i], "--update-baseline") == 0)
+            mode = Mode::UPDATE_BASELINE;
+    }
+
+    INIReader ini(iniFile);
+    auto section = "PERFORMANCE_GATE";
+    baselineDir = dataDir + ini.getString(section, "BASELINE_DIR", "");
+    tolerances.p99 = ini.getReal(section, "P99_TOLERANCE", 0.25);
+    tolerances.p99Absolute = ini.getReal(section, "P99_ABSOLUTE_TOLERANCE", 0);
+    tolerances.throughput = ini.getReal(section, "THROUGHPUT_TOLERANCE", 0.2);
+    allowMissingBaseline =
+            ini.getBoolean(section, "ALLOW_MISSING_BASELINE", false);
+}
+
+void PerformanceGate::submit(const PerformanceReport& report) const {
+    if (mode == Mode::DISABLED) return;
+    if (report.frames == 0)
+        THROW_EXCEPTION("No latencies were recorded for " + report.name +
+                        " (the real-time analysis tests require "
+                        "ENABLE_LATENCY_INSTRUMENTATION)");
+
+    auto reportFile = outputDir + "/" + report.name + "_performance.json";
+    report.write(reportFile);
+    cout << "Performance report: " << reportFile << endl;
+
+    auto baselineFile = baselineDir + report.name + ".json";
+    if (mode == Mode::UPDATE_BASELINE) {
+        report.write(baselineFile);
+        cout << "Updated baseline: " << baselineFile << endl;
+        return;
+    }
+
+    if (!ifstream(baselineFile)) {
+        string message = "No baseline for " + report.name + " (" +
+                         baselineFile +
+                         "), run with --update-baseline to record it.";
+        if (!allowMissingBaseline) THROW_EXCEPTION(message);
+        cout << message << endl;
+        return;
+    }
+    auto baseline = PerformanceReport::read(baselineFile);
+    ostringstream diff;
+    bool ok = compare(report, baseline, tolerances, diff);
+    cout << diff.str();
+    if (!ok)
+        THROW_EXCEPTION("Performance regression of " + report.name +
+                        " with respect to " + baselineFile + ":\n" +
+                        diff.str());
+}
+
+bool PerformanceGate::compare(const PerformanceReport& measured,
+                              const PerformanceReport& baseline,
+                              const Tolerances& tolerances, ostream& diff) {
+    double p99Limit = baseline.p99 * (1 + tolerances.p99) +
+                      tolerances.p99Absolute;
+    double throughputLimit = baseline.throughput * (1 - tolerances.throughput);
+
+    diff << left << setw(18) << "metric" << right << setw(14) << "baseline"
+         << setw(14) << "measured" << setw(10) << "change" << setw(16)
+         << "limit" << endl;
+    bool ok = true;
+    ok &= compareRow(diff, "throughput (1/s)", baseline.throughput,
+                     measured.throughput, throughputLimit, false, true);
+    compareRow(diff, "mean (ms)", baseline.mean, measured.mean, 0, true,
+               false);
+    compareRow(diff, "p50 (ms)", baseline.p50, measured.p50, 0, true, false);
+    ok &= compareRow(diff, "p99 (ms)", baseline.p99, measured.p99, p99Limit,
+                     true, true);
+    compareRow(diff, "p999 (ms)", baseline.p999, measured.p999, 0, true,
+               false);
+    compareRow(diff, "max (ms)", baseline.max, measured.max, 0, true, false);
+    return ok;
+}
@@ -19,6 +19,7 @@
  */
 #include "SignalProcessing.h"
 #include "Exception.h"
+#include "Tracer.h"
 #include "Utils.h"
 #include <SimTKcommon/Scalar.h>
 #include <SimTKcommon/internal/BigMatrix.h>
@@ -115,6 +116,7 @@ LowPassSmoothFilter::LowPassSmoothFilter(const Parameters& parameters)
 
 LowPassSmoothFilter::Output
 LowPassSmoothFilter::filter(const LowPassSmoothFilter::Input& input) {
+    TRACE_SPAN("LowPassSmoothFilter::filter");
     // shift data column left and set last column as the new data
     shiftColumnsLeft(Vector(1, input.t), time);
     shiftColumnsLeft(input.x, data);
@@ -0,0 +1,205 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "Tracer.h"
+#include "Exception.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+using namespace OpenSimRT;
+using namespace std;
+
+static_assert((Tracer::capacity & (Tracer::capacity - 1)) == 0,
+              "Tracer capacity must be a power of 2.");
+
+namespace {
+
+/**
+ * Ring of the spans of a thread. Only the owning thread writes; the slots are
+ * atomics (relaxed) so that a concurrent export can detect the slots that are
+ * overwritten while copying (as in a sequence lock).
+ */
+struct ThreadRing {
+    struct Slot {
+        atomic<const char*> name;
+        atomic<int64_t> start;
+        atomic<int64_t> end;
+    };
+
+    explicit ThreadRing(int thread)
+            : thread(thread), slots(new Slot[Tracer::capacity]), head(0),
+              reserved(0), begin(0) {}
+
+    int thread;
+    string name; // guarded by the registry mutex
+    unique_ptr<Slot[]> slots;
+    atomic<uint64_t> head;     // number of recorded spans
+    atomic<uint64_t> reserved; // number of spans whose slot is being written
+    atomic<uint64_t> begin;    // first span after clear()
+};
+
+/**
+ * Rings of all threads that recorded a span. They are shared with the threads,
+ * thus the spans of finished threads are still exported.
+ */
+struct Registry {
+    mutex monitor;
+    vector<shared_ptr<ThreadRing>> rings;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+ThreadRing& localRing() {
+    thread_local shared_ptr<ThreadRing> ring;
+    if (!ring) {
+        auto& r = registry();
+        lock_guard<mutex> lock(r.monitor);
+        ring = make_shared<ThreadRing>(r.rings.size() + 1);
+        r.rings.push_back(ring);
+    }
+    return *ring;
+}
+
+void writeEscaped(ostream& stream, const string& s) {
+    for (const auto& c : s) {
+        if (c == '"' || c == '\\')
+            stream << '\\' << c;
+        else if (static_cast<unsigned char>(c) >= 0x20)
+            stream << c;
+    }
+}
+
+} // namespace
+
+/*******************************************************************************/
+
+void Tracer::record(const char* name, int64_t start, int64_t end) {
+    auto& ring = localRing();
+    const auto i = ring.head.load(memory_order_relaxed);
+
+    // announce the slot before writing, thus a reader that observes any of the
+    // new values also observes that the old span is lost
+    ring.reserved.store(i + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    auto& slot = ring.slots[i & (capacity - 1)];
+    slot.name.store(name, memory_order_relaxed);
+    slot.start.store(start, memory_order_relaxed);
+    slot.end.store(end, memory_order_relaxed);
+    ring.head.store(i + 1, memory_order_release);
+}
+
+void Tracer::setThreadName(const string& name) {
+    auto& ring = localRing();
+    lock_guard<mutex> lock(registry().monitor);
+    ring.name = name;
+}
+
+vector<Tracer::Event> Tracer::getEvents(double window) {
+    vector<shared_ptr<ThreadRing>> rings;
+    {
+        lock_guard<mutex> lock(registry().monitor);
+        rings = registry().rings;
+    }
+
+    const int64_t from =
+            window > 0 ? monotonicNanoseconds() - int64_t(window * 1e9)
+                       : numeric_limits<int64_t>::min();
+    vector<Event> events;
+    vector<Event> copied;
+    for (const auto& ring : rings) {
+        const uint64_t last = ring->head.load(memory_order_acquire);
+        const uint64_t first =
+                max(ring->begin.load(), last > capacity ? last - capacity : 0);
+        copied.clear();
+        for (uint64_t i = first; i < last; ++i) {
+            const auto& slot = ring->slots[i & (capacity - 1)];
+            copied.push_back({slot.name.load(memory_order_relaxed),
+                              slot.start.load(memory_order_relaxed),
+                              slot.end.load(memory_order_relaxed),
+                              ring->thread});
+        }
+
+        // discard the spans whose slot was reused while copying
+        atomic_thread_fence(memory_order_acquire);
+        const uint64_t reserved = ring->reserved.load(memory_order_relaxed);
+        for (uint64_t i = first; i < last; ++i) {
+            if (i + capacity < reserved) continue;
+            const auto& event = copied[i - first];
+            if (event.end >= from) events.push_back(event);
+        }
+    }
+    sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        return a.start < b.start;
+    });
+    return events;
+}
+
+int Tracer::exportChromeTrace(const string& fileName, double window) {
+    auto events = getEvents(window);
+    vector<pair<int, string>> names;
+    {
+        lock_guard<mutex> lock(registry().monitor);
+        for (const auto& ring : registry().rings) {
+            if (!ring->name.empty())
+                names.push_back({ring->thread, ring->name});
+        }
+    }
+
+    ofstream stream(fileName);
+    if (!stream) THROW_EXCEPTION("Unable to open file: " + fileName);
+
+    // complete events ("X") with time in us relative to the first span
+    const int64_t origin = events.empty() ? 0 : events.front().start;
+    stream << fixed << setprecision(3) << "{\"traceEvents\":[";
+    bool first = true;
+    for (const auto& name : names) {
+        stream << (first ? "\n" : ",\n")
+               << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+               << name.first << ",\"args\":{\"name\":\"";
+        writeEscaped(stream, name.second);
+        stream << "\"}}";
+        first = false;
+    }
+    for (const auto& event : events) {
+        stream << (first ? "\n" : ",\n") << "{\"name\":\"";
+        writeEscaped(stream, event.name);
+        stream << "\",\"ph\":\"X\",\"ts\":" << (event.start - origin) / 1e3
+               << ",\"dur\":" << (event.end - event.start) / 1e3
+               << ",\"pid\":1,\"tid\":" << event.thread << "}";
+        first = false;
+    }
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    if (!stream) THROW_EXCEPTION("Unable to write file: " + fileName);
+    return events.size();
+}
+
+void Tracer::clear() {
+    lock_guard<mutex> lock(registry().monitor);
+    for (const auto& ring : registry().rings) ring->begin = ring->head.load();
+}
+
+/*******************************************************************************/
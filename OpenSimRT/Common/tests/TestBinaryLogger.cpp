@@ -0,0 +1,140 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestBinaryLogger.cpp
+ *
+ * \brief Logs rows with the binary logger and a TimeSeriesTable, compares the
+ * cost of appending a row, and checks that the binary log is read back (and
+ * converted to .sto) without loss, also before the logger is closed (as after
+ * a crash).
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "BinaryLogger.h"
+#include "Exception.h"
+#include "Settings.h"
+#include <OpenSim/Common/TimeSeriesTable.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+/**
+ * The rows of a logger that was not closed are read without the zero padding
+ * of the mapped file.
+ */
+void testUnclosed() {
+    const int n = 10;
+    auto binaryFile = LIBRARY_OUTPUT_PATH + "/binary_logger_unclosed.bin";
+    BinaryLogger logger(binaryFile, vector<string>{"a", "b"});
+    for (int i = 0; i < n; ++i) logger.appendRow(1 + i, Vector(2, double(i)));
+
+    // wait for the writing thread
+    for (int k = 0; k < 1000 && logger.getStatistics().written < n; ++k)
+        this_thread::sleep_for(1ms);
+    if (logger.getStatistics().written != n)
+        THROW_EXCEPTION("rows were not written");
+
+    auto logged = BinaryLogger::readTable(binaryFile);
+    if (logged.getNumRows() != n)
+        THROW_EXCEPTION("unclosed log has " + to_string(logged.getNumRows()) +
+                        " rows instead of " + to_string(n));
+    for (int i = 0; i < n; ++i) {
+        if (logged.getIndependentColumn()[i] != 1 + i ||
+            logged.getRowAtIndex(i)[1] != i)
+            THROW_EXCEPTION("row " + to_string(i) + " of unclosed log");
+    }
+}
+
+void run() {
+    testUnclosed();
+
+    const int n = 20000;
+    const int m = 100;
+    auto binaryFile = LIBRARY_OUTPUT_PATH + "/binary_logger.bin";
+    auto stoFile = LIBRARY_OUTPUT_PATH + "/binary_logger.sto";
+
+    vector<string> labels;
+    for (int j = 0; j < m; ++j) labels.push_back("column_" + to_string(j));
+    TimeSeriesTable table;
+    table.setColumnLabels(labels);
+
+    // log the same rows in both loggers and measure the worst append
+    double binaryMax = 0, tableMax = 0;
+    Vector row(m);
+    {
+        BinaryLogger logger(binaryFile, labels);
+        for (int i = 0; i < n; ++i) {
+            double t = 0.01 * i;
+            for (int j = 0; j < m; ++j) row[j] = i + 0.001 * j;
+
+            auto t1 = chrono::steady_clock::now();
+            if (!logger.appendRow(t, row))
+                THROW_EXCEPTION("row " + to_string(i) + " was dropped");
+            auto t2 = chrono::steady_clock::now();
+            table.appendRow(t, ~row);
+            auto t3 = chrono::steady_clock::now();
+            binaryMax = max(binaryMax,
+                            chrono::duration<double, micro>(t2 - t1).count());
+            tableMax = max(tableMax,
+                           chrono::duration<double, micro>(t3 - t2).count());
+
+            // bursts of rows as in a real-time loop
+            if (i % 100 == 99) this_thread::sleep_for(1ms);
+        }
+        logger.close();
+        auto statistics = logger.getStatistics();
+        cout << "written: " << statistics.written
+             << ", dropped: " << statistics.dropped
+             << ", max queue size: " << statistics.maxQueueSize << endl;
+    }
+    cout << "max appendRow (us) binary: " << binaryMax
+         << ", TimeSeriesTable: " << tableMax << endl;
+
+    // read back and compare
+    auto logged = BinaryLogger::readTable(binaryFile);
+    if (logged.getNumRows() != n || logged.getColumnLabels() != labels)
+        THROW_EXCEPTION("binary log does not match the logged rows");
+    for (int i = 0; i < n; ++i) {
+        if (logged.getIndependentColumn()[i] !=
+                    table.getIndependentColumn()[i] ||
+            (logged.getRowAtIndex(i) - table.getRowAtIndex(i)).normInf() > 0)
+            THROW_EXCEPTION("row " + to_string(i) + " does not match");
+    }
+
+    // conversion
+    BinaryLogger::convertToSTO(binaryFile, stoFile);
+    if (TimeSeriesTable(stoFile).getNumRows() != n)
+        THROW_EXCEPTION("converted .sto does not match the logged rows");
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestBoundedQueue.cpp
+ *
+ * \brief Tests the overflow policies of the bounded queue: no element is lost
+ * with BLOCK, while DROP_OLDEST keeps the newest elements in order. Also tests
+ * that an rvalue push swaps the storage with the slot instead of copying.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "BoundedQueue.h"
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace OpenSimRT;
+
+void testDropOldest() {
+    BoundedQueue<int> queue(4, OverflowPolicy::DROP_OLDEST);
+    for (int i = 1; i <= 10; ++i) queue.push(i);
+    int value = 0;
+    for (int i = 7; i <= 10; ++i) {
+        if (!queue.tryPop(value) || value != i)
+            THROW_EXCEPTION("DROP_OLDEST should keep the newest elements");
+    }
+    if (queue.tryPop(value)) THROW_EXCEPTION("queue should be empty");
+    auto statistics = queue.getStatistics();
+    if (statistics.dropped != 6 || statistics.maxSize != 4)
+        THROW_EXCEPTION("wrong DROP_OLDEST statistics");
+    cout << "DROP_OLDEST dropped: " << statistics.dropped << endl;
+}
+
+void testBlock() {
+    const int n = 10000;
+    BoundedQueue<vector<int>> queue(8, OverflowPolicy::BLOCK);
+
+    // fast producer, slow consumer
+    thread producer([&]() {
+        vector<int> value(16);
+        for (int i = 0; i < n; ++i) {
+            value.assign(16, i);
+            queue.push(value);
+        }
+        queue.close();
+    });
+
+    vector<int> value;
+    int expected = 0;
+    while (queue.pop(value)) {
+        if (value.size() != 16 || value.front() != expected ||
+            value.back() != expected)
+            THROW_EXCEPTION("BLOCK lost or reordered an element");
+        expected++;
+        if (expected % 1000 == 0) this_thread::sleep_for(1ms);
+    }
+    producer.join();
+    if (expected != n) THROW_EXCEPTION("BLOCK lost elements");
+    auto statistics = queue.getStatistics();
+    if (statistics.dropped != 0 || statistics.maxSize > 8)
+        THROW_EXCEPTION("wrong BLOCK statistics");
+    cout << "BLOCK popped: " << statistics.popped
+         << ", producer waits: " << statistics.producerWaits << endl;
+}
+
+void testClose() {
+    BoundedQueue<int> queue(2, OverflowPolicy::BLOCK);
+    queue.push(1);
+    queue.push(2);
+    // a producer that waits on a full queue is released by close()
+    bool pushed = true;
+    thread producer([&]() { pushed = queue.push(3); });
+    this_thread::sleep_for(10ms);
+    queue.close();
+    producer.join();
+    if (pushed) THROW_EXCEPTION("push() should fail after close()");
+    int value = 0;
+    if (!queue.pop(value) || value != 1 || !queue.pop(value) || value != 2 ||
+        queue.pop(value))
+        THROW_EXCEPTION("remaining elements should be retrieved after close()");
+}
+
+void testSwapPush() {
+    BoundedQueue<vector<int>> queue(1, OverflowPolicy::DROP_OLDEST);
+    vector<int> value(16, 1);
+    const int* storage = value.data();
+    queue.push(move(value));
+    if (!value.empty()) THROW_EXCEPTION("an empty slot should be swapped");
+
+    // the popped element has the storage of the pushed one
+    vector<int> popped(16, 0);
+    const int* poppedStorage = popped.data();
+    if (!queue.pop(popped) || popped.data() != storage ||
+        popped != vector<int>(16, 1))
+        THROW_EXCEPTION("the rvalue push should not copy the element");
+
+    // the producer reuses the storage that the consumer left in the slot
+    value.assign(16, 2);
+    queue.push(move(value));
+    if (value.data() != poppedStorage)
+        THROW_EXCEPTION("the previous content of the slot should be swapped");
+}
+
+void run() {
+    testDropOldest();
+    testBlock();
+    testClose();
+    testSwapPush();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
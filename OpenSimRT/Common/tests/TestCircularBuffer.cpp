@@ -51,7 +51,22 @@ void consumerFunction(int M) {
     }
 }
 
+void testLatestAndDrain() {
+    CircularBuffer<4, int> b;
+    b.add(1);
+    b.add(2);
+    if (b.getLatest() != 2) THROW_EXCEPTION("getLatest() failed");
+    for (int i = 3; i <= 8; ++i) b.add(i); // overrun history
+    auto drained = b.drain();
+    if (drained != vector<int>{5, 6, 7, 8}) THROW_EXCEPTION("drain() failed");
+    if (!b.drain().empty()) THROW_EXCEPTION("drain() should be empty");
+    b.add(9);
+    if (b.drain() != vector<int>{9}) THROW_EXCEPTION("drain() failed");
+}
+
 void run() {
+    testLatestAndDrain();
+
     thread producer(producerFunction);
     thread consumer1(consumerFunction, 5);
     thread consumer2(consumerFunction, 100);
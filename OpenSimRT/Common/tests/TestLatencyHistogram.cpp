@@ -0,0 +1,94 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestLatencyHistogram.cpp
+ *
+ * \brief Tests the accuracy of the latency histogram percentiles and the
+ * concurrent recording from multiple threads.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "Exception.h"
+#include "Measure.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+void expectNear(double value, double expected, const string& name) {
+    cout << name << ": " << value << " (expected: " << expected << ")" << endl;
+    if (value < expected || value > (1 + 1.0 / 128) * expected + 1)
+        THROW_EXCEPTION(name + " is not within 1/128 of the expected value");
+}
+
+void run() {
+    // uniform latencies from 1 us to 100 ms
+    LatencyHistogram histogram;
+    const int n = 100000;
+    for (int i = 1; i <= n; ++i) histogram.record(i * 1000LL);
+    auto statistics = histogram.getStatistics();
+    if (statistics.count != n) THROW_EXCEPTION("wrong count");
+    expectNear(statistics.mean, (n + 1) * 500.0, "mean");
+    expectNear(statistics.p50, n * 0.5 * 1000, "p50");
+    expectNear(statistics.p99, n * 0.99 * 1000, "p99");
+    expectNear(statistics.p999, n * 0.999 * 1000, "p99.9");
+    if (statistics.max != n * 1000.0) THROW_EXCEPTION("wrong max");
+
+    // the widest bucket relative to its values starts at each power of two
+    // (the larger value keeps the maximum from clamping the percentile)
+    for (int b = 7; b < 45; ++b) {
+        LatencyHistogram pair;
+        pair.record(1LL << b);
+        pair.record(1LL << (b + 1));
+        expectNear(pair.getStatistics().p50, double(1LL << b),
+                   "p50 of 2^" + to_string(b));
+    }
+
+    // concurrent recording
+    LatencyHistogram shared;
+    vector<thread> threads;
+    for (int k = 0; k < 4; ++k) {
+        threads.emplace_back([&, k]() {
+            for (int i = 0; i < n; ++i) shared.record(1000 * (k + 1));
+        });
+    }
+    for (auto& t : threads) t.join();
+    statistics = shared.getStatistics();
+    if (statistics.count != 4 * n || statistics.max != 4000)
+        THROW_EXCEPTION("concurrent recording lost values");
+    expectNear(statistics.p50, 2000, "concurrent p50");
+
+    // timing
+    auto t1 = monotonicNanoseconds();
+    for (int i = 0; i < n; ++i) histogram.record(i);
+    auto t2 = monotonicNanoseconds();
+    cout << "record: " << double(t2 - t1) / n << " ns" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
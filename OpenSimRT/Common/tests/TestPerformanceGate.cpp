@@ -0,0 +1,120 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ *
+ * @file TestPerformanceGate.cpp
+ *
+ * \brief Tests the roundtrip of the performance reports and the detection of
+ * p99 latency and throughput regressions against a baseline.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "Exception.h"
+#include "PerformanceGate.h"
+#include "Settings.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+using namespace OpenSimRT;
+
+void run() {
+    // 1000 frames of 1 ms to 10 ms in 2 s
+    LatencyHistogram histogram;
+    for (int i = 1; i <= 1000; ++i) histogram.record(1000000 + i * 9000LL);
+    auto baseline = PerformanceReport::fromLatencies(
+            "TestPerformanceGate", histogram.getStatistics(), 2.0);
+    if (baseline.frames != 1000 || baseline.throughput != 500)
+        THROW_EXCEPTION("wrong frames or throughput");
+
+    // roundtrip
+    auto fileName = LIBRARY_OUTPUT_PATH + "/TestPerformanceGate.json";
+    baseline.write(fileName);
+    auto stored = PerformanceReport::read(fileName);
+    if (stored.name != baseline.name || stored.frames != baseline.frames ||
+        abs(stored.throughput - baseline.throughput) > 1e-6 ||
+        abs(stored.p99 - baseline.p99) > 1e-6 ||
+        abs(stored.max - baseline.max) > 1e-6)
+        THROW_EXCEPTION("report roundtrip failed");
+
+    PerformanceGate::Tolerances tolerances{0.25, 0.0, 0.2};
+
+    // within tolerances
+    auto measured = baseline;
+    measured.p99 *= 1.2;
+    measured.throughput *= 0.85;
+    ostringstream diff;
+    if (!PerformanceGate::compare(measured, baseline, tolerances, diff))
+        THROW_EXCEPTION("false regression:\n" + diff.str());
+    cout << diff.str() << endl;
+
+    // p99 regression
+    measured = baseline;
+    measured.p99 *= 1.3;
+    diff.str("");
+    if (PerformanceGate::compare(measured, baseline, tolerances, diff))
+        THROW_EXCEPTION("p99 regression was not detected");
+    cout << diff.str() << endl;
+
+    // p99 regression absorbed by the absolute tolerance (timer noise)
+    tolerances.p99Absolute = baseline.p99;
+    if (!PerformanceGate::compare(measured, baseline, tolerances, diff))
+        THROW_EXCEPTION("absolute p99 tolerance was not applied");
+    tolerances.p99Absolute = 0;
+
+    // throughput regression
+    measured = baseline;
+    measured.throughput *= 0.7;
+    diff.str("");
+    if (PerformanceGate::compare(measured, baseline, tolerances, diff))
+        THROW_EXCEPTION("throughput regression was not detected");
+    cout << diff.str() << endl;
+
+    // a missing baseline fails the gate unless it is explicitly allowed
+    auto iniFile = LIBRARY_OUTPUT_PATH + "/TestPerformanceGate.ini";
+    char program[] = "TestPerformanceGate", option[] = "--performance";
+    char* argv[] = {program, option};
+    for (bool allow : {false, true}) {
+        ofstream ini(iniFile);
+        ini << "[PERFORMANCE_GATE]\nBASELINE_DIR = /missing_baseline/\n"
+            << "ALLOW_MISSING_BASELINE = " << (allow ? "true" : "false")
+            << endl;
+        ini.close();
+        PerformanceGate gate(2, argv, iniFile, LIBRARY_OUTPUT_PATH,
+                             LIBRARY_OUTPUT_PATH);
+        bool failed = false;
+        try {
+            gate.submit(baseline);
+        } catch (exception&) { failed = true; }
+        if (failed == allow)
+            THROW_EXCEPTION("missing baseline was not handled as configured");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
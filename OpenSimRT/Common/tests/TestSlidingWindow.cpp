@@ -0,0 +1,247 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestSlidingWindow.cpp
+ *
+ * \brief Compares the sliding window with the previous (array-based)
+ * implementation on random data, checks the initialization, the round-off of
+ * the running sum, enumerations and empty windows, and benchmarks the insertion
+ * and queries for different window sizes.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "SlidingWindow.h"
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+using namespace std;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+/**
+ * Previous implementation, where insertion shifts the elements of the window
+ * and the queries iterate the window.
+ */
+template <typename T> struct ReferenceSlidingWindow {
+    Array_<T> data;
+    size_t capacity;
+
+    void setSize(const size_t& size) {
+        capacity = size;
+        data.reserve(size);
+    }
+    void insert(const T& x) {
+        if (data.size() == capacity) data.erase(data.begin());
+        data.push_back(x);
+    }
+    T mean() {
+        return 1.0 * accumulate(data.begin(), data.end(), T(0)) /
+               int(data.size());
+    }
+    bool equal(const T& x) const {
+        for (const auto& e : data) {
+            if (e != x) return false;
+        }
+        return true;
+    }
+    bool nFirstEqual(const T& x, const size_t& n) const {
+        for (size_t i = 0; i < n; ++i) {
+            if (data[i] != x) return false;
+        }
+        return true;
+    }
+    bool nLastEqual(const T& x, const size_t& n) const {
+        for (size_t i = 0; i < n; ++i) {
+            if (data[data.size() - i - 1] != x) return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * Insert the same random values (few distinct values, thus long runs) in both
+ * windows and compare the queries.
+ */
+void testEquivalence(const int& size) {
+    SlidingWindow<Vec3> window;
+    ReferenceSlidingWindow<Vec3> reference;
+    window.setSize(size);
+    reference.setSize(size);
+    mt19937 generator(0);
+    uniform_int_distribution<int> distribution(0, 2);
+    for (int i = 0; i < 20 * size; ++i) {
+        Vec3 x(distribution(generator));
+        window.insert(x);
+        reference.insert(x);
+        if (window.size() != reference.data.size() ||
+            window.getCapacity() != reference.capacity)
+            THROW_EXCEPTION("size() or getCapacity() does not match");
+        if (window.getData() != reference.data)
+            THROW_EXCEPTION("getData() does not match");
+        if ((window.mean() - reference.mean()).norm() > 1e-10)
+            THROW_EXCEPTION("mean() does not match");
+        for (int v = 0; v <= 2; ++v) {
+            if (window.equal(Vec3(v)) != reference.equal(Vec3(v)))
+                THROW_EXCEPTION("equal() does not match");
+        }
+        for (size_t n = 0; n <= window.size(); ++n) {
+            if (window.nFirstEqual(x, n) != reference.nFirstEqual(x, n) ||
+                window.nLastEqual(x, n) != reference.nLastEqual(x, n))
+                THROW_EXCEPTION("nFirstEqual()/nLastEqual() does not match");
+        }
+    }
+}
+
+/**
+ * The window size and the initial elements are given by init().
+ */
+void testInit() {
+    SlidingWindow<Vec3> window;
+    window.init(Array_<Vec3>(vector<Vec3>{Vec3(1), Vec3(2), Vec3(3)}));
+    if (window.size() != 3 || window.front() != Vec3(1) ||
+        window.back() != Vec3(3) || window.mean() != Vec3(2))
+        THROW_EXCEPTION("init() does not set the elements");
+    window.insert(Vec3(4));
+    if (window.size() != 3 || window.front() != Vec3(2) ||
+        window.mean() != Vec3(3))
+        THROW_EXCEPTION("insert() after init() does not discard the oldest");
+
+    // init() replaces the previous elements
+    window.init(Array_<Vec3>(2, Vec3(5)));
+    if (window.size() != 2 || !window.equal(Vec3(5)))
+        THROW_EXCEPTION("init() does not reset the window");
+}
+
+/**
+ * The running sum must not drift from the sum of the window elements after
+ * many insertions of values with a large offset.
+ */
+void testRoundOff() {
+    const int size = 10;
+    SlidingWindow<double> window;
+    window.setSize(size);
+    mt19937 generator(0);
+    uniform_real_distribution<double> distribution(0, 1);
+    for (int i = 0; i < 1000000; ++i)
+        window.insert(1e6 + distribution(generator));
+    double sum = 0;
+    for (int i = 0; i < size; ++i) sum += window[i] - 1e6;
+    if (abs(window.mean() - 1e6 - sum / size) > 1e-9)
+        THROW_EXCEPTION("the running sum drifted");
+}
+
+/**
+ * Enumerations (no running sum), as used for the leg phase in the gait phase
+ * detector (GaitPhaseState::LegPhase), including the detection of the heel
+ * strike (SWING in the first n - 1 elements followed by STANCE).
+ */
+enum class LegPhase { INVALID, SWING, STANCE };
+
+void testEnumeration() {
+    const int size = 4;
+    SlidingWindow<LegPhase> window;
+    window.init(Array_<LegPhase>(size, LegPhase::INVALID));
+    auto detectHS = [](const SlidingWindow<LegPhase>& w) {
+        return w.nFirstEqual(LegPhase::SWING, w.size() - 1) &&
+               w.back() == LegPhase::STANCE;
+    };
+    if (!window.equal(LegPhase::INVALID) || detectHS(window))
+        THROW_EXCEPTION("invalid initial leg phase");
+
+    vector<LegPhase> phases = {LegPhase::SWING, LegPhase::SWING,
+                               LegPhase::SWING, LegPhase::STANCE,
+                               LegPhase::STANCE};
+    vector<bool> expected = {false, false, false, true, false};
+    for (int i = 0; i < phases.size(); ++i) {
+        window.insert(phases[i]);
+        if (detectHS(window) != expected[i])
+            THROW_EXCEPTION("heel strike detection at sample " + to_string(i));
+    }
+    if (!window.nLastEqual(LegPhase::STANCE, 2) ||
+        window.nLastEqual(LegPhase::STANCE, 3))
+        THROW_EXCEPTION("nLastEqual() does not match");
+}
+
+/**
+ * A window of size zero does not store any element.
+ */
+void testEmpty() {
+    SlidingWindow<Vec3> window;
+    window.insert(Vec3(1));
+    window.setSize(0);
+    window.insert(Vec3(1));
+    if (window.size() != 0 || !window.equal(Vec3(1)) ||
+        !window.nFirstEqual(Vec3(1), 0) || !window.nLastEqual(Vec3(1), 0))
+        THROW_EXCEPTION("empty window is not empty");
+    try {
+        window.back();
+    } catch (exception&) { return; }
+    THROW_EXCEPTION("access to an element of an empty window");
+}
+
+/**
+ * Mean time (ns) of an insertion followed by mean() and nFirstEqual() of half
+ * of the window.
+ */
+template <typename Window> double benchmark(const int& size, const int& n) {
+    Window window;
+    window.setSize(size);
+    for (int i = 0; i < size; ++i) window.insert(Vec3(i));
+    Vec3 sum(0);
+    int equal = 0;
+    auto t1 = chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        window.insert(Vec3(i % 3));
+        sum += window.mean();
+        equal += window.nFirstEqual(Vec3(0), size / 2);
+    }
+    auto t2 = chrono::steady_clock::now();
+    // use the results, so that the loop is not optimized away
+    if (!sum.isFinite() || equal > n) THROW_EXCEPTION("invalid results");
+    return chrono::duration<double, nano>(t2 - t1).count() / n;
+}
+
+void run() {
+    for (int size : {1, 2, 5, 50}) testEquivalence(size);
+    testInit();
+    testRoundOff();
+    testEnumeration();
+    testEmpty();
+
+    const int n = 100000;
+    for (int size : {10, 100, 1000}) {
+        cout << "window size " << size << ": "
+             << benchmark<SlidingWindow<Vec3>>(size, n) << " ns (reference: "
+             << benchmark<ReferenceSlidingWindow<Vec3>>(size, n) << " ns)"
+             << endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
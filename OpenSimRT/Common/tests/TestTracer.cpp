@@ -0,0 +1,127 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestTracer.cpp
+ *
+ * \brief Records spans from multiple threads while exporting concurrently and
+ * checks that no torn span is exported, the time window and the Chrome trace
+ * output.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "Exception.h"
+#include "Settings.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+static const char* names[] = {"stage 0", "stage 1", "stage 2"};
+
+void checkEvents(const vector<Tracer::Event>& events) {
+    // each worker records spans of a single name with end = start + 1
+    map<int, const char*> threadNames;
+    for (const auto& event : events) {
+        auto name = threadNames.insert({event.thread, event.name}).first;
+        if (event.end != event.start + 1 || event.name != name->second ||
+            find(begin(names), end(names), event.name) == end(names))
+            THROW_EXCEPTION("torn span exported");
+    }
+}
+
+void run() {
+    // concurrent recording (the rings wrap around) and export
+    const int n = 4 * Tracer::capacity;
+    atomic_bool done(false);
+    vector<thread> threads;
+    for (int k = 0; k < 3; ++k) {
+        threads.emplace_back([&, k]() {
+            Tracer::setThreadName("worker " + to_string(k));
+            for (int i = 0; i < n; ++i) {
+                auto t = monotonicNanoseconds();
+                Tracer::record(names[k], t, t + 1);
+            }
+        });
+    }
+    threads.emplace_back([&]() {
+        while (!done) checkEvents(Tracer::getEvents());
+    });
+    for (int k = 0; k < 3; ++k) threads[k].join();
+    done = true;
+    threads.back().join();
+
+    auto events = Tracer::getEvents();
+    checkEvents(events);
+    cout << "events: " << events.size() << endl;
+    if (events.size() > 3 * Tracer::capacity)
+        THROW_EXCEPTION("more events than the capacity of the rings");
+
+    // time window and export
+    Tracer::clear();
+    {
+        TraceSpan span("old");
+    }
+    this_thread::sleep_for(200ms);
+    {
+        TraceSpan span("recent");
+        this_thread::sleep_for(1ms);
+    }
+    events = Tracer::getEvents(0.1);
+    if (events.size() != 1 || strcmp(events[0].name, "recent") != 0)
+        THROW_EXCEPTION("wrong events in time window");
+    if (events[0].end - events[0].start < 1000000)
+        THROW_EXCEPTION("wrong span duration");
+
+    auto fileName = LIBRARY_OUTPUT_PATH + "/trace.json";
+    if (Tracer::exportChromeTrace(fileName) != 2)
+        THROW_EXCEPTION("wrong number of exported spans");
+    ifstream file(fileName);
+    stringstream json;
+    json << file.rdbuf();
+    if (json.str().find("\"name\":\"recent\",\"ph\":\"X\"") ==
+                string::npos ||
+        json.str().find("\"thread_name\"") == string::npos)
+        THROW_EXCEPTION("wrong Chrome trace output");
+
+    // cost of a span
+    const int m = 100000;
+    auto t1 = monotonicNanoseconds();
+    for (int i = 0; i < m; ++i) TraceSpan span("cost");
+    auto t2 = monotonicNanoseconds();
+    cout << "span: " << double(t2 - t1) / m << " ns" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
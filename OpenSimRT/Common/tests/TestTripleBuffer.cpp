@@ -0,0 +1,108 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestTripleBuffer.cpp
+ *
+ * \brief Tests the lock-free triple buffer with a producer that publishes
+ * faster than the consumer reads, checking that the consumer always reads
+ * complete and increasingly newer results. The producer keeps publishing until
+ * the consumer has read a minimum number of results, so that the reads are
+ * concurrent with the writes regardless of the scheduling.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "Exception.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace OpenSimRT;
+
+struct Result {
+    long long id = -1;
+    vector<long long> data; // all elements equal to id
+};
+
+void run() {
+    const long long n = 200000;      // minimum number of publications
+    const long long minReads = 1000; // minimum number of concurrent reads
+    const int size = 64;
+    TripleBuffer<Result> buffer;
+    atomic_bool done(false);
+    atomic<long long> reads(0);
+    long long published = 0;
+
+    thread producer([&]() {
+        long long i = 0;
+        for (; i < n || reads < minReads; ++i) {
+            auto& result = buffer.write();
+            result.id = i;
+            result.data.assign(size, i);
+            buffer.publish();
+            // let the consumer run if it has not read enough results
+            if (i >= n) this_thread::yield();
+        }
+        published = i;
+        done = true;
+    });
+
+    long long previous = -1;
+    Result swapped;
+    while (true) {
+        // stop when nothing was published after the producer finished
+        bool finished = done;
+        if (!buffer.acquire()) {
+            if (finished) break;
+            this_thread::yield();
+            continue;
+        }
+        const auto& result = buffer.read();
+        if (result.id <= previous) THROW_EXCEPTION("older result acquired");
+        for (const auto& d : result.data)
+            if (d != result.id) THROW_EXCEPTION("torn result");
+        previous = result.id;
+        reads++;
+
+        // exchange the storage every other read
+        if (reads % 2) buffer.swap(swapped);
+    }
+    producer.join();
+
+    // the last publication is always acquired
+    if (previous != published - 1) THROW_EXCEPTION("last result not acquired");
+    if (buffer.getPublished() != published)
+        THROW_EXCEPTION("wrong publications");
+    if (reads < minReads) THROW_EXCEPTION("too few concurrent reads");
+    cout << "published: " << buffer.getPublished()
+         << ", overwrites: " << buffer.getOverwrites() << ", reads: " << reads
+         << ", stale reads: " << buffer.getStaleReads() << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
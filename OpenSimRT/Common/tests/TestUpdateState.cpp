@@ -0,0 +1,100 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestUpdateState.cpp
+ *
+ * \brief Tests that the bulk OpenSimUtils::updateState sets the same
+ * generalized coordinates and speeds as the per-coordinate update, and
+ * compares their execution time.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "INIReader.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+void run() {
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_UPDATE_STATE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+
+    // setup model
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+    auto state = model.initSystem();
+    auto bulkState = state;
+    if (model.getConstraintSet().getSize() > 0)
+        THROW_EXCEPTION("the equivalence holds for models without constraints");
+    auto indices = OpenSimUtils::getStateIndices(model, bulkState);
+
+    // get kinematics as a table with ordered coordinates
+    auto qTable = OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+            model, ikFile, 0.01);
+
+    double sumDelayUS = 0, sumBulkDelayUS = 0;
+    for (int i = 1; i < qTable.getNumRows(); ++i) {
+        auto q = qTable.getRowAtIndex(i).getAsVector();
+        Vector qDot = (q - qTable.getRowAtIndex(i - 1).getAsVector()) / 0.01;
+
+        // per-coordinate update
+        auto t1 = chrono::high_resolution_clock::now();
+        OpenSimUtils::updateState(model, state, q, qDot);
+        model.realizePosition(state);
+        auto t2 = chrono::high_resolution_clock::now();
+        sumDelayUS += chrono::duration<double, micro>(t2 - t1).count();
+
+        // bulk update
+        t1 = chrono::high_resolution_clock::now();
+        OpenSimUtils::updateState(indices, bulkState, q, qDot);
+        model.realizePosition(bulkState);
+        t2 = chrono::high_resolution_clock::now();
+        sumBulkDelayUS += chrono::duration<double, micro>(t2 - t1).count();
+
+        // both must write the same values in the same slots
+        if ((state.getQ() - bulkState.getQ()).normInf() != 0 ||
+            (state.getU() - bulkState.getU()).normInf() != 0)
+            THROW_EXCEPTION("bulk state update differs at frame " +
+                            to_string(i));
+    }
+
+    cout << "Mean update and realize position (per-coordinate/bulk): "
+         << sumDelayUS / (qTable.getNumRows() - 1) << " / "
+         << sumBulkDelayUS / (qTable.getNumRows() - 1) << " us" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
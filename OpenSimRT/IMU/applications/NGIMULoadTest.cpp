@@ -0,0 +1,126 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file NGIMULoadTest.cpp
+ *
+ * @brief Load test of the NGIMU ingestion path (NGIMUListener and
+ * NGIMUInputDriver) with virtual NGIMU units streaming on the loopback
+ * interface. Reports packet loss, end-to-end latency and throughput.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "INIReader.h"
+#include "NGIMUInputDriver.h"
+#include "NGIMULoadGenerator.h"
+#include "Settings.h"
+#include <chrono>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+using namespace OpenSimRT;
+
+void run() {
+    INIReader ini(INI_FILE);
+    auto section = "NGIMU_LOAD_TEST";
+
+    // generator settings
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto dataFile = ini.getString(section, "NGIMU_DATA_CSV", "");
+    auto ip = ini.getString(section, "IP", "127.0.0.1");
+    auto basePort = ini.getInteger(section, "BASE_PORT", 8000);
+    auto numIMUs = ini.getInteger(section, "NUM_IMUS", 1);
+    auto rate = ini.getReal(section, "RATE", 100);
+    auto streamDuration = ini.getReal(section, "DURATION", 10);
+
+    // receiver settings
+    auto receiverMode = ini.getString(section, "RECEIVER_MODE", "MULTIPLEXER");
+    auto numShards = ini.getInteger(section, "NUM_SHARDS", 1);
+    auto cpuAffinity = ini.getVector(section, "CPU_AFFINITY", vector<int>());
+
+    NGIMULoadGenerator::Parameters parameters;
+    parameters.ip = ip;
+    parameters.rate = rate;
+    parameters.duration = streamDuration;
+    vector<string> labels;
+    for (int i = 0; i < numIMUs; ++i) {
+        parameters.ports.push_back(basePort + i);
+        labels.push_back("imu_" + to_string(i));
+    }
+
+    // driver listening on the generator ports
+    NGIMUInputDriver driver;
+    driver.setupInput(labels, vector<string>(numIMUs, ip), parameters.ports);
+    if (receiverMode == "BATCHED") {
+        driver.setReceiverMode(NGIMUInputDriver::ReceiverMode::BATCHED);
+    } else if (receiverMode == "SHARDED") {
+        driver.setReceiverMode(NGIMUInputDriver::ReceiverMode::SHARDED);
+        driver.setShards(numShards, cpuAffinity);
+    }
+    thread listen(&NGIMUInputDriver::startListening, &driver);
+    this_thread::sleep_for(milliseconds(200)); // wait for sockets to bind
+
+    // generator
+    NGIMULoadGenerator generator(parameters);
+    if (!dataFile.empty()) generator.setDataFromFile(subjectDir + dataFile);
+    thread send(&NGIMULoadGenerator::run, &generator);
+
+    // consume all samples and compute their end-to-end latency from the send
+    // time (bundle time tag) to the receive time stamp of the sample, thus the
+    // latency does not depend on how often the samples are drained
+    vector<double> latencies;
+    latencies.reserve(size_t(numIMUs * rate * (streamDuration + 1)));
+    auto consume = [&]() {
+        for (const auto& samples : driver.getDataSinceLastRead())
+            for (const auto& sample : samples)
+                latencies.push_back(sample.receiveTimeStamp -
+                                    sample.quaternion.timeStamp);
+    };
+    const auto start = steady_clock::now();
+    while (generator.getNumSent() == 0 ||
+           steady_clock::now() - start < duration<double>(streamDuration)) {
+        consume();
+        this_thread::sleep_for(microseconds(500));
+    }
+    send.join();
+    this_thread::sleep_for(milliseconds(100)); // receive in-flight packets
+    consume();
+    const auto elapsed =
+            duration<double>(steady_clock::now() - start).count();
+
+    driver.stopListening();
+    listen.join();
+
+    cout << "NGIMU load test: " << numIMUs << " IMUs at " << rate << " Hz ("
+         << receiverMode << ")" << endl;
+    auto parse = driver.getParseStatistics();
+    NGIMULoadGenerator::Report::compute(generator.getNumSent(), latencies,
+                                        elapsed, parse.packets, parse.time)
+            .print(cout);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
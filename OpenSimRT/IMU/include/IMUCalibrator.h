@@ -25,12 +25,16 @@
  */
 #pragma once
 
+#include "Exception.h"
 #include "InputDriver.h"
 #include "InverseKinematics.h"
 #include "NGIMUInputDriver.h"
 #include "Utils.h"
 #include "internal/IMUExports.h"
 #include <Simulation/Model/Model.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <string>
 #include <type_traits>
 
@@ -99,6 +103,28 @@ class IMU_API IMUCalibrator {
      */
     void recordNumOfSamples(const size_t& numSamples);
 
+    /**
+     * Record the static phase until the average pose converges, i.e., the
+     * maximum angular change (in radians) of the average orientation of all
+     * IMUs between successive checks is smaller than `tolerance`, or until
+     * `timeout` (in seconds) has elapsed. Returns true if converged.
+     */
+    bool recordUntilConvergence(const double& tolerance,
+                                const double& timeout);
+
+    /**
+     * Maximum angular change (in radians) of the average orientation between
+     * the two last convergence checks during recording.
+     */
+    double getConvergence() const { return impl->getConvergence(); }
+
+    /**
+     * Average orientation of each IMU during the static phase.
+     */
+    const std::vector<SimTK::Quaternion>& getStaticPoseQuaternions() const {
+        return staticPoseQuaternions;
+    }
+
     /**
      * Calibrate NGIMU data acquired from stream and create the IK input.
      */
@@ -114,6 +140,30 @@ class IMU_API IMUCalibrator {
     }
 
  private:
+    /**
+     * Online average of 3D rotations for each IMU using constant memory. Each
+     * sample q is accumulated in a 4x4 matrix M += q * q^T, and the average
+     * quaternion is the eigenvector of M with the largest eigenvalue (computed
+     * with power iteration). The result does not depend on the sign of the
+     * quaternions.
+     *
+     * Source: F. L. Markley et al., "Averaging Quaternions", Journal of
+     * Guidance, Control, and Dynamics, 30(4), 2007.
+     */
+    class QuaternionAverage {
+     public:
+        void reset(const size_t& numIMUs);
+        void add(const size_t& imu, const SimTK::Quaternion& q);
+        std::vector<SimTK::Quaternion> compute();
+        size_t getNumSamples() const { return numSamples; }
+        size_t getNumIMUs() const { return accumulators.size(); }
+
+     private:
+        std::vector<SimTK::Mat44> accumulators;
+        std::vector<SimTK::Vec4> estimates; // initial guess of power iteration
+        size_t numSamples = 0;
+    };
+
     /**
      * Type erasure on imu InputDriver types. Base class. Provides an interface
      * for the functionality of derived classes.
@@ -124,13 +174,43 @@ class IMU_API IMUCalibrator {
 
         virtual void recordTime(const double& timeout) = 0;
         virtual void recordNumOfSamples(const size_t& numSamples) = 0;
+        virtual bool recordUntilConvergence(const double& tolerance,
+                                            const double& timeout) = 0;
         virtual std::vector<SimTK::Quaternion> computeAvgStaticPose() = 0;
+        double getConvergence() const { return convergence; }
+
+     protected:
+        /**
+         * Update the convergence metric with the current average and return
+         * it.
+         */
+        double updateConvergence() {
+            auto current = average.compute();
+            convergence = SimTK::Infinity;
+            if (current.size() == previous.size()) {
+                convergence = 0;
+                for (size_t i = 0; i < current.size(); ++i) {
+                    double d = std::abs(~current[i].asVec4() *
+                                        previous[i].asVec4());
+                    convergence = std::max(
+                            convergence, 2 * std::acos(std::min(d, 1.0)));
+                }
+            }
+            previous = std::move(current);
+            return convergence;
+        }
+
+        QuaternionAverage average;
+        std::vector<SimTK::Quaternion> previous;
+        double convergence = SimTK::Infinity;
     };
 
     /**
      * Type erasure on imu InputDriver types. Erasure class. Automatic type
      * deduction of the driver's IMUData type <T>, allows any Input driver to be
-     * passed in the constructor.
+     * passed in the constructor. Samples are folded into the running average
+     * as they arrive, thus memory does not grow with the recording duration.
+     * `getData()` of the drivers blocks until new data are available.
      */
     template <typename T> class DriverErasure : public DriverErasureBase {
      public:
@@ -139,75 +219,74 @@ class IMU_API IMUCalibrator {
         virtual void recordTime(const double& timeout) override {
             std::cout << "Recording Static Pose..." << std::endl;
             const auto start = std::chrono::steady_clock::now();
-            while (std::chrono::duration_cast<std::chrono::seconds>(
+            reset();
+            while (std::chrono::duration<double>(
                            std::chrono::steady_clock::now() - start)
                            .count() < timeout) {
-                // get frame measurements. `getData()` is common to all input
-                // drivers
-                initIMUDataTable.push_back(m_driver->getData());
+                if (!addSample()) break;
             }
         }
 
         virtual void recordNumOfSamples(const size_t& numSamples) override {
             std::cout << "Recording Static Pose..." << std::endl;
-            size_t i = 0;
-            while (i < numSamples) {
-                // get frame measurements. `getData()` is common to all input
-                // drivers
-                initIMUDataTable.push_back(m_driver->getData());
-                ++i;
+            reset();
+            for (size_t i = 0; i < numSamples; ++i) {
+                if (!addSample()) break;
             }
         }
 
-        /**
-         * Compute average of 3D rotations. Given a list of IMUData containing
-         * the quaternion measurements, computes the average quaternion error
-         * from the first sample and adds it back to the first sample to return
-         * the average quaternions.
-         *
-         * Source:
-         * https://math.stackexchange.com/questions/1984608/average-of-3d-rotations
-         */
+        virtual bool recordUntilConvergence(const double& tolerance,
+                                            const double& timeout) override {
+            std::cout << "Recording Static Pose..." << std::endl;
+            const auto start = std::chrono::steady_clock::now();
+            reset();
+            while (std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count() < timeout) {
+                if (!addSample()) break;
+                if (average.getNumSamples() % CONVERGENCE_CHECK_INTERVAL == 0 &&
+                    updateConvergence() < tolerance)
+                    return true;
+            }
+            return false;
+        }
+
         virtual std::vector<SimTK::Quaternion> computeAvgStaticPose() override {
-            int n = initIMUDataTable.size();    // num of recorded frames
-            int m = initIMUDataTable[0].size(); // num of imu devices
-
-            auto avgQuaternionErrors =
-                    std::vector<SimTK::Quaternion>(m, SimTK::Quaternion());
-
-            // Quaternion product for each imu
-            for (int j = 0; j < m; ++j)
-                for (int i = 0; i < n; ++i) {
-                    // NOTE: requires `.getQuaternion()` function of the IMUData
-                    // type.
-                    const auto& q = initIMUDataTable[i][j].getQuaternion();
-                    avgQuaternionErrors[j] = avgQuaternionErrors[j] * (~q * q);
-                }
+            if (average.getNumSamples() == 0)
+                THROW_EXCEPTION("No samples were recorded.");
+            return average.compute();
+        }
 
-            // convet to axis angle, devide with n, and convert back to
-            // quaternions
-            for (auto& q : avgQuaternionErrors) {
-                q.setQuaternionFromAngleAxis(
-                        q.convertQuaternionToAngleAxis().scalarDivide(
-                                double(n)));
-            }
+     private:
+        // number of samples between successive convergence checks
+        static constexpr size_t CONVERGENCE_CHECK_INTERVAL = 10;
+
+        void reset() {
+            average.reset(0);
+            previous.clear();
+            convergence = SimTK::Infinity;
+        }
 
-            // add the error back to the first sample
-            auto avgQuaternions(avgQuaternionErrors);
-            for (int i = 0; i < m; ++i) {
+        /**
+         * Get a frame from the driver and add it to the average. Returns false
+         * if the driver did not provide any data (e.g., end of stream).
+         */
+        bool addSample() {
+            // get frame measurements. `getData()` is common to all input
+            // drivers
+            const auto frame = m_driver->getData();
+            if (frame.empty()) return false;
+            if (average.getNumIMUs() != frame.size())
+                average.reset(frame.size());
+            for (size_t j = 0; j < frame.size(); ++j) {
                 // NOTE: requires `.getQuaternion()` function of the IMUData
                 // type.
-                const auto& q0 = initIMUDataTable[0][i].getQuaternion();
-                const auto& qe = avgQuaternionErrors[i];
-                avgQuaternions[i] = qe * q0;
+                average.add(j, frame[j].getQuaternion());
             }
-
-            return avgQuaternions;
+            return true;
         }
 
-     private:
         SimTK::ReferencePtr<const InputDriver<T>> m_driver;
-        std::vector<std::vector<T>> initIMUDataTable;
     };
 
     /**
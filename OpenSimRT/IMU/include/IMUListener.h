@@ -52,6 +52,7 @@ template <typename T> class ListenerAdapter {
      */
     void pushDataToManagerBuffer(const int& port, const T& input) {
         driver->buffer[port]->add(input);
+        driver->notifyDataAvailable();
     }
 };
 
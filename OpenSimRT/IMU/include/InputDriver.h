@@ -30,12 +30,15 @@
 
 #include "CircularBuffer.h"
 #include "internal/IMUExports.h"
+#include <functional>
 #include <map>
 #include <vector>
 
-// The size of buffer is 1, since in stream-like applications we need to pass
-// the most recent data continuously from the producer to the consumer thread.
-#define CIRCULAR_BUFFER_SIZE 1
+// In stream-like applications we need to pass the most recent data continuously
+// from the producer to the consumer thread, which is retrieved in O(1) with
+// `getLatest()`. A short history is kept so that consumers can also `drain()`
+// all the samples received since their last read.
+#define CIRCULAR_BUFFER_SIZE 16
 
 namespace OpenSimRT {
 
@@ -72,12 +75,29 @@ template <typename T> class IMU_API InputDriver {
      */
     virtual IMUDataList getData() const = 0;
 
+    /**
+     * Register a function that is called by the receiving thread each time
+     * new data are stored (e.g., RealTimeAnalysis::notifyDataAvailable), so
+     * that the consumer can wait for data instead of polling getData(). Must
+     * be set before startListening().
+     */
+    void setDataAvailableCallback(std::function<void()> callback) {
+        dataAvailableCallback = callback;
+    }
+
  protected:
     InputDriver() noexcept {};                           // ctor
     InputDriver& operator=(const InputDriver&) = delete; // deleted assign ctor
     InputDriver(const InputDriver&) = delete;            // deleted copy ctor
     virtual ~InputDriver() = default;                    // dtor
 
+    /**
+     * Notify the consumer that new data are available (producer thread).
+     */
+    void notifyDataAvailable() const {
+        if (dataAvailableCallback) dataAvailableCallback();
+    }
+
     /**
      * List of pointers to generic listeners using the adapter interface class.
      */
@@ -89,6 +109,8 @@ template <typename T> class IMU_API InputDriver {
     mutable std::map<int,
                      std::unique_ptr<CircularBuffer<CIRCULAR_BUFFER_SIZE, T>>>
             buffer;
+
+    std::function<void()> dataAvailableCallback;
 };
 
 } // namespace OpenSimRT
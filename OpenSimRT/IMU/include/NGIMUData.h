@@ -67,6 +67,10 @@ struct IMU_API NGIMUData {
     Quaternion quaternion;
     LinearAcceleration linear;
     Altitude altitude;
+    double receiveTimeStamp = 0; // host receive time (in seconds since Unix
+                                 // epoch), zero if not provided by the
+                                 // receiver. Not part of the vector/pack
+                                 // representation.
 
     /**
      * Total size in bytes of the NGIMUData object.
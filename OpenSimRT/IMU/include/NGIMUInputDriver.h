@@ -27,8 +27,12 @@
 #pragma once
 #include "InputDriver.h"
 #include "NGIMUData.h"
+#include "OrientationFilter.h"
+#include "UdpBatchReceiver.h"
 #include "ip/UdpSocket.h"
 #include <Common/TimeSeriesTable.h>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace OpenSimRT {
@@ -43,6 +47,24 @@ class IMU_API NGIMUInputDriver : public InputDriver<NGIMUData> {
     typedef std::vector<std::pair<double, SimTK::Vector>> DataPack;
 
  public:
+    /**
+     * Select how packets are received from the sockets. MULTIPLEXER uses the
+     * oscpack SocketReceiveMultiplexer (one datagram per system call), whereas
+     * BATCHED uses the UdpBatchReceiver (recvmmsg with kernel receive
+     * timestamps, Linux only). SHARDED distributes the sockets over multiple
+     * UdpBatchReceivers, each running on its own thread (Linux only).
+     */
+    enum class ReceiverMode { MULTIPLEXER, BATCHED, SHARDED };
+
+    /**
+     * Packets parsed by all the listeners and the total time (in seconds)
+     * spent to parse and dispatch them.
+     */
+    struct ParseStatistics {
+        std::size_t packets;
+        double time;
+    };
+
     NGIMUInputDriver() = default; // default ctor
     /**
      * Setup the listening sockets in the constructor.
@@ -67,15 +89,44 @@ class IMU_API NGIMUInputDriver : public InputDriver<NGIMUData> {
                            const std::string& localIP,
                            const std::vector<int>& localPorts);
 
+    /**
+     * Set the receiver mode (default MULTIPLEXER). Must be called before
+     * startListening().
+     */
+    void setReceiverMode(const ReceiverMode& mode);
+
+    /**
+     * Configure the SHARDED receiver mode. The i-th socket is handled by the
+     * shard (i % numShards) and each shard runs on its own thread. If
+     * `cpuAffinity` is not empty, the thread of the j-th shard is pinned to
+     * the CPU cpuAffinity[j % cpuAffinity.size()]. Must be called before
+     * startListening().
+     */
+    void setShards(const int& numShards,
+                   const std::vector<int>& cpuAffinity = {});
+
+    /**
+     * Estimate the orientation of the IMUs on the host from the raw sensor
+     * data, instead of using the quaternion computed on the device. When set,
+     * getData() updates the filter with all the samples received since the
+     * last read and returns the latest samples with the estimated quaternion.
+     * Pass nullptr to use the device quaternion (default).
+     */
+    void setOrientationFilter(std::shared_ptr<OrientationFilter> filter);
+
     /**
      * Attaches sockets to listeners. (Implements the startListening function
-     * of the base class.)
+     * of the base class.) Blocks until stopListening() is called. In SHARDED
+     * mode the shard threads are joined before returning and the first
+     * exception raised by any shard is rethrown.
      */
     virtual void startListening() override;
 
     /**
      * Terminate IMU data acquisition. (Implements the startListening function
-     * of the base class.)
+     * of the base class.) Thread-safe. A request issued before
+     * startListening() is latched, thus the next startListening() returns
+     * immediately.
      */
     virtual void stopListening() override;
 
@@ -85,6 +136,19 @@ class IMU_API NGIMUInputDriver : public InputDriver<NGIMUData> {
      */
     virtual IMUDataList getData() const override;
 
+    /**
+     * Receive all the NGIMU data that have been stored in the driver's buffer
+     * since the last read, ordered from old-to-new, for each IMU (i.e.,
+     * result[i] contains the samples of the i-th IMU). Does not block and at
+     * most CIRCULAR_BUFFER_SIZE samples per IMU are returned.
+     */
+    std::vector<IMUDataList> getDataSinceLastRead() const;
+
+    /**
+     * Thread-safe access to the parse statistics of the listeners.
+     */
+    ParseStatistics getParseStatistics() const;
+
     /**
      * Represent the list of NGIMUData as a SimTK::Vector.
      */
@@ -111,7 +175,18 @@ class IMU_API NGIMUInputDriver : public InputDriver<NGIMUData> {
     OpenSim::TimeSeriesTable initializeLogger() const;
 
  private:
+    ReceiverMode receiverMode = ReceiverMode::MULTIPLEXER;
+    int numShards = 1;
+    std::vector<int> shardAffinity;
+    std::shared_ptr<OrientationFilter> orientationFilter;
     SocketReceiveMultiplexer mux; // multipler for polling listener sockets
     std::vector<std::unique_ptr<UdpSocket>> udpSockets; // upd sockets
+#ifdef __linux__
+    std::vector<std::unique_ptr<UdpBatchReceiver>> receivers; // one per shard
+#endif
+    // guards the receivers and the stop request between the listening thread
+    // and the thread that calls stopListening()
+    std::mutex listeningMutex;
+    bool stopRequested = false;
 };
 } // namespace OpenSimRT
@@ -0,0 +1,150 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file NGIMUInputFromBinaryFileDriver.h
+ *
+ * @brief Replays NGIMU recordings stored in a memory-mapped binary file. In
+ * contrast to the NGIMUInputFromFileDriver, no replay thread is used. Frames
+ * are paced in the consumer thread against absolute deadlines of a monotonic
+ * clock, or are returned as fast as possible.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+#include "InputDriver.h"
+#include "MemoryMappedFile.h"
+#include "NGIMUData.h"
+#include "OrientationFilter.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace OpenSimRT {
+
+/**
+ * @brief NGIMU driver that replays a binary recording. The binary format
+ * consists of a fixed 64-byte header followed by the frames. Each frame holds
+ * the time and the NGIMUData::size() values of each IMU as doubles, in the
+ * same order as the NGIMU csv files (see NGIMUInputDriver::initializeLogger).
+ * Binary recordings are created from csv files with `convertFromCSV`.
+ */
+class IMU_API NGIMUInputFromBinaryFileDriver : public InputDriver<NGIMUData> {
+ public: /* public data structures */
+    /**
+     * Zero-copy view of a frame. The values point in the mapped file and
+     * remain valid for the lifetime of the driver.
+     */
+    struct FrameView {
+        double time;
+        const double* values; // NGIMUData::size() values for each IMU
+        int size;             // number of values
+
+        /**
+         * Read-only SimTK::Vector that borrows the frame values (no copy).
+         */
+        SimTK::Vector asVector() const;
+    };
+
+    /**
+     * Binary file header.
+     */
+    struct Header {
+        char magic[8];           // "OSRTIMU"
+        std::uint32_t version;   // format version
+        std::uint32_t numIMUs;   // number of IMUs in each frame
+        std::uint64_t numFrames; // number of frames
+        char reserved[40];       // pad to 64 bytes (keeps frames aligned)
+    };
+
+ public:
+    /**
+     * Create a driver that replays the binary file at `speed` times the
+     * recorded rate (e.g., 1 for real-time, 10 for 10x). If speed is not
+     * positive, frames are replayed as fast as possible.
+     */
+    NGIMUInputFromBinaryFileDriver(const std::string& fileName,
+                                   const double& speed = 1.0);
+    ~NGIMUInputFromBinaryFileDriver() = default;
+
+    /**
+     * Convert a NGIMU csv file (e.g., ngimu_data.csv) to the binary format.
+     */
+    static void convertFromCSV(const std::string& csvFileName,
+                               const std::string& binaryFileName);
+
+    /**
+     * Start the replay clock. Implements the startListening of the base
+     * class. Does not block.
+     */
+    virtual void startListening() override;
+
+    /**
+     * Terminate the replay. Implements the stopListening of the base class.
+     */
+    virtual void stopListening() override;
+
+    /**
+     * Determine if the replay has ended.
+     */
+    bool shouldTerminate() const;
+
+    /**
+     * Estimate the orientation of the IMUs from the raw sensor data instead of
+     * using the recorded quaternion (see NGIMUInputDriver). Applies to
+     * getData(). Pass nullptr to use the recorded quaternion (default).
+     */
+    void setOrientationFilter(std::shared_ptr<OrientationFilter> filter);
+
+    /**
+     * Get the next frame as a zero-copy view. Blocks until the frame deadline
+     * is reached (unless replay is as fast as possible). Returns false when
+     * the replay has ended.
+     */
+    bool getFrameView(FrameView& view) const;
+
+    /**
+     * Get the next frame as a list of NGIMUData. Implements the getData of
+     * the base class. Returns an empty list when the replay has ended.
+     */
+    virtual IMUDataList getData() const override;
+
+    /**
+     * Get the next frame as a std::pair containing the time and all the sensor
+     * values as a SimTK::Vector (copy).
+     */
+    std::pair<double, SimTK::Vector> getFrameAsVector() const;
+
+    int getNumIMUs() const { return numIMUs; }
+    std::size_t getNumFrames() const { return numFrames; }
+
+ private:
+    MemoryMappedFile file;
+    const double* frames; // first frame in mapped file
+    int numIMUs;
+    std::size_t numFrames;
+    int frameSize; // number of doubles per frame (including time)
+    double speed;
+    std::shared_ptr<OrientationFilter> orientationFilter;
+
+    std::chrono::steady_clock::time_point startTime;
+    mutable std::atomic<std::size_t> nextFrame;
+    mutable std::atomic_bool terminationFlag;
+};
+} // namespace OpenSimRT
@@ -27,8 +27,10 @@
 #pragma once
 #include "InputDriver.h"
 #include "NGIMUData.h"
+#include "OrientationFilter.h"
 #include <Common/TimeSeriesTable.h>
 #include <condition_variable>
+#include <memory>
 #include <thread>
 
 namespace OpenSimRT {
@@ -40,6 +42,8 @@ class IMU_API NGIMUInputFromFileDriver : public InputDriver<NGIMUData> {
  public:
     /**
      * Create a NGIMU driver that streams data from file at a constant rate.
+     * If the rate is not positive, the rows are streamed as fast as they are
+     * consumed (each row is sent after the previous row was fetched).
      */
     NGIMUInputFromFileDriver(const std::string& fileName,
                              const double& sendRate);
@@ -61,6 +65,14 @@ class IMU_API NGIMUInputFromFileDriver : public InputDriver<NGIMUData> {
      */
     void shouldTerminate(bool flag);
 
+    /**
+     * Estimate the orientation of the IMUs from the raw sensor data instead of
+     * using the recorded quaternion (see NGIMUInputDriver). Applies to
+     * getData() and getFrame(). Pass nullptr to use the recorded quaternion
+     * (default).
+     */
+    void setOrientationFilter(std::shared_ptr<OrientationFilter> filter);
+
     /**
      * Get data from file as a list of NGIMUData. Implements the stopListening
      * of the base class.
@@ -86,12 +98,19 @@ class IMU_API NGIMUInputFromFileDriver : public InputDriver<NGIMUData> {
      */
     IMUDataList fromVector(const SimTK::Vector&) const;
 
+    /**
+     * Reconstruct a list of NGIMU from a frame (time and values) and apply the
+     * orientation filter, if any.
+     */
+    IMUDataList fromFrame(const std::pair<double, SimTK::Vector>& frame) const;
+
     // hide it from public since it does nothing
     void stopListening() override {}
 
  private:
     OpenSim::TimeSeriesTable table;
     double rate;
+    std::shared_ptr<OrientationFilter> orientationFilter;
 
     // buffers
     SimTK::RowVector frame;
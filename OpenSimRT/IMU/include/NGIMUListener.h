@@ -33,7 +33,10 @@
 #include "osc/OscPacketListener.h"
 #include "osc/OscReceivedElements.h"
 #include "osc/OscTypes.h"
+#include <array>
+#include <atomic>
 #include <bitset>
+#include <cstdint>
 
 namespace OpenSimRT {
 /**
@@ -47,6 +50,31 @@ class IMU_API NGIMUListener : public osc::OscPacketListener,
     ~NGIMUListener() = default; // dtor
     osc::uint64 timeTag;        // timeTag of the received bundle
 
+    /**
+     * Set the host receive time (in seconds since Unix epoch) of the packet
+     * that will be processed next. Used by receivers that provide kernel
+     * receive timestamps (e.g., UdpBatchReceiver). Otherwise, packets are
+     * stamped with the host time when their processing starts.
+     */
+    void setReceiveTime(const double& time) {
+        receiveTime = time;
+        hasReceiveTime = true;
+    }
+
+    /**
+     * Overrides the ProcessPacket function from the oscpack library. Stamps
+     * the packet and measures the time spent to parse and dispatch it.
+     */
+    void ProcessPacket(const char* data, int size,
+                       const IpEndpointName& remoteEndpoint) override;
+
+    /**
+     * Number of packets processed so far and the total time (in seconds)
+     * spent to parse and dispatch them. Thread-safe.
+     */
+    std::size_t getNumParsedPackets() const { return numParsedPackets.load(); }
+    double getParseTime() const { return parseNanoseconds.load() * 1e-9; }
+
  protected:
     /**
      * Overrides the ProcessBundle function from the oscpack library. Unpacks
@@ -64,7 +92,35 @@ class IMU_API NGIMUListener : public osc::OscPacketListener,
                         const IpEndpointName& remoteEndpoint) override;
 
  private:
+    /**
+     * Handler that decodes the arguments of a message with a known address
+     * pattern directly into the preallocated NGIMUData object.
+     */
+    typedef void (NGIMUListener::*MessageHandler)(const osc::ReceivedMessage&,
+                                                  const double& time);
+
+    /**
+     * Entry of the dispatch table. Messages are matched by the precomputed
+     * hash of their address pattern.
+     */
+    struct MessageDispatch {
+        std::uint32_t hash;
+        const char* address;
+        MessageHandler handler;
+    };
+    static const std::array<MessageDispatch, 5> dispatchTable;
+
+    void processQuaternion(const osc::ReceivedMessage& m, const double& time);
+    void processSensors(const osc::ReceivedMessage& m, const double& time);
+    void processLinear(const osc::ReceivedMessage& m, const double& time);
+    void processAltitude(const osc::ReceivedMessage& m, const double& time);
+    void processButton(const osc::ReceivedMessage& m, const double& time);
+
     NGIMUData data;
+    double receiveTime;              // host receive time of current packet
+    bool hasReceiveTime;             // receiveTime was set by the receiver
+    std::atomic<std::size_t> numParsedPackets;
+    std::atomic<std::int64_t> parseNanoseconds;
     std::bitset<4> bundleReadyFlags; // number of bitset flags equal to the
                                      // message addresses required to fill a
                                      // NGIMUData object
@@ -0,0 +1,132 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file NGIMULoadGenerator.h
+ *
+ * @brief Stand-in for NGIMU units. Emits OSC bundles with the same layout as
+ * the NGIMU (/quaternion, /sensors, /linear and /altitude) to local UDP ports,
+ * so that the ingestion path (NGIMUListener, NGIMUInputDriver) can be load
+ * tested without hardware.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "NGIMUData.h"
+#include "internal/IMUExports.h"
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * @brief Generates NGIMU OSC bundles for any number of virtual IMUs at a
+ * constant rate. Each virtual IMU sends to its own port. Data are either
+ * replayed from a recorded NGIMU csv file (e.g., ngimu_data.csv created by the
+ * online IMU applications) or synthesized. The time tag of each bundle is the
+ * send time, thus the end-to-end latency of a sample can be computed on the
+ * receiver side as the difference between its receive time stamp and the time
+ * stamp of the sample.
+ */
+class IMU_API NGIMULoadGenerator {
+ public: /* public data structures */
+    struct Parameters {
+        std::string ip = "127.0.0.1"; // destination IP
+        std::vector<int> ports;       // one virtual IMU per port
+        double rate = 100;            // bundles per second for each IMU
+        double duration = 10;         // streaming duration in seconds
+    };
+
+    /**
+     * Statistics of a load test.
+     */
+    struct Report {
+        std::size_t sent;       // number of sent bundles
+        std::size_t received;   // number of received samples
+        double packetLoss;      // percentage of lost bundles
+        double throughput;      // received samples per second
+        double latencyMean;     // end-to-end latency in ms
+        double latencyP50;      // median latency in ms
+        double latencyP99;      // 99th percentile latency in ms
+        double latencyMax;      // maximum latency in ms
+        double elapsed;         // elapsed time in seconds
+        std::size_t parsed;     // number of parsed packets
+        double parseThroughput; // parsed packets per second of parse time
+        double parseTime;       // mean parse time of a packet in us
+
+        /**
+         * Compute the report from the number of sent bundles, the latencies of
+         * the received samples (in seconds), the elapsed time, and the number
+         * of parsed packets with their total parse time (in seconds).
+         */
+        static Report compute(const std::size_t& sent,
+                              std::vector<double> latencies,
+                              const double& elapsed, const std::size_t& parsed,
+                              const double& parseTime);
+
+        /**
+         * Print the report.
+         */
+        void print(std::ostream& out) const;
+    };
+
+ public:
+    /**
+     * Create a generator with synthetic data.
+     */
+    NGIMULoadGenerator(const Parameters& parameters);
+
+    /**
+     * Replay data from a recorded NGIMU csv file instead of synthetic data.
+     * The i-th virtual IMU uses the (i % M)-th IMU of the file, where M is the
+     * number of IMUs in the file. The file is replayed in a loop.
+     */
+    void setDataFromFile(const std::string& fileName);
+
+    /**
+     * Send bundles to all ports at the configured rate until the duration has
+     * elapsed or stop() is called.
+     */
+    void run();
+
+    /**
+     * Terminate the generator. Thread-safe.
+     */
+    void stop();
+
+    /**
+     * Number of bundles sent so far (all IMUs).
+     */
+    std::size_t getNumSent() const { return numSent.load(); }
+
+ private:
+    /**
+     * Data of the i-th virtual IMU for the given frame.
+     */
+    NGIMUData generate(const int& imu, const std::size_t& frame) const;
+
+    Parameters parameters;
+    std::vector<std::vector<NGIMUData>> recorded; // [frame][imu]
+    std::atomic_bool running;
+    std::atomic<std::size_t> numSent;
+};
+
+} // namespace OpenSimRT
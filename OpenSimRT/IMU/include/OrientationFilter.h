@@ -0,0 +1,131 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file OrientationFilter.h
+ *
+ * @brief Host-side orientation estimation (AHRS) of multiple IMUs from raw
+ * gyroscope, accelerometer and magnetometer measurements.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+#include "NGIMUData.h"
+#include "internal/IMUExports.h"
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * @brief Estimates the orientation of N IMUs from the raw sensor data using the
+ * Madgwick or the Mahony filter, as an alternative to the quaternion computed
+ * on the device. The state of the IMUs is stored in a structure-of-arrays
+ * layout (one contiguous array per quaternion component), and each step
+ * updates all IMUs in branch-free loops, so that the compiler can process
+ * multiple IMUs per SIMD instruction.
+ *
+ * When attached to an NGIMU driver (setOrientationFilter), the quaternion of
+ * the acquired NGIMUData is replaced by the estimate of the filter, thus the
+ * IMUCalibrator and the InverseKinematics use the host-side estimates
+ * without further changes.
+ *
+ * Sources:
+ *
+ * [1] S. O. H. Madgwick et al., "Estimation of IMU and MARG orientation using
+ * a gradient descent algorithm", IEEE ICORR, 2011.
+ *
+ * [2] R. Mahony et al., "Nonlinear Complementary Filters on the Special
+ * Orthogonal Group", IEEE Transactions on Automatic Control, 53(5), 2008.
+ */
+class IMU_API OrientationFilter {
+ public:
+    enum class Algorithm { MADGWICK, MAHONY };
+    struct Parameters {
+        Algorithm algorithm = Algorithm::MADGWICK;
+        double beta = 0.1;           // Madgwick gain
+        double kp = 1.0;             // Mahony proportional gain
+        double ki = 0.0;             // Mahony integral gain
+        bool useMagnetometer = true; // Madgwick only (MARG)
+        double samplePeriod = 0;     // if positive, a fixed sample period is
+                                     // used instead of the sensor timestamps
+        double maxSamplePeriod = 0.1; // larger gaps are not integrated
+    };
+
+    OrientationFilter(const int& numIMUs, const Parameters& parameters);
+
+    /**
+     * Reset the filter. The state of each IMU is initialized from the device
+     * quaternion of its next sample.
+     */
+    void reset();
+
+    /**
+     * Update the filter with one sample per IMU and replace the quaternion of
+     * each sample with the estimated orientation. The sample period of each IMU
+     * is computed from the timestamps of its sensor data (unless a fixed
+     * sample period is provided). IMUs for which `valid[i]` is false are not
+     * updated (e.g., when no new sample was received).
+     */
+    void update(std::vector<NGIMUData>& frame,
+                const std::vector<bool>& valid = {});
+
+    /**
+     * Update the filter from sensor data in structure-of-arrays form. Each
+     * array holds one value per IMU. Gyroscope in rad/s, while accelerometer
+     * and magnetometer units are arbitrary (they are normalized). IMUs with
+     * dt[i] = 0 are not updated.
+     */
+    void update(const double* dt, const double* gx, const double* gy,
+                const double* gz, const double* ax, const double* ay,
+                const double* az, const double* mx, const double* my,
+                const double* mz);
+
+    /**
+     * Estimated orientation of the i-th IMU.
+     */
+    SimTK::Quaternion getQuaternion(const int& i) const;
+
+    int getNumIMUs() const { return numIMUs; }
+
+ private:
+    void updateMadgwickIMU(const double* dt, const double* gx, const double* gy,
+                           const double* gz, const double* ax, const double* ay,
+                           const double* az);
+    void updateMadgwickMARG(const double* dt, const double* gx,
+                            const double* gy, const double* gz,
+                            const double* ax, const double* ay,
+                            const double* az, const double* mx,
+                            const double* my, const double* mz);
+    void updateMahony(const double* dt, const double* gx, const double* gy,
+                      const double* gz, const double* ax, const double* ay,
+                      const double* az);
+
+    int numIMUs;
+    Parameters parameters;
+
+    // state (one element per IMU)
+    std::vector<double> q0, q1, q2, q3; // orientation
+    std::vector<double> ex, ey, ez;     // Mahony integral error
+    std::vector<double> lastTime;
+    std::vector<bool> initialized;
+
+    // sensor data of the current step
+    std::vector<double> dt, gx, gy, gz, ax, ay, az, mx, my, mz;
+};
+
+} // namespace OpenSimRT
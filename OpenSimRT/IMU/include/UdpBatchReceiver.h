@@ -0,0 +1,119 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file UdpBatchReceiver.h
+ *
+ * @brief Batched UDP receiver for the NGIMU listeners (Linux only). It is an
+ * alternative to the oscpack SocketReceiveMultiplexer that drains many
+ * datagrams per system call using recvmmsg and attaches the kernel receive
+ * timestamp (SO_TIMESTAMPNS) to each packet before it is passed to the
+ * listener.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#ifdef __linux__
+
+#    include "NGIMUListener.h"
+#    include "internal/IMUExports.h"
+#    include <atomic>
+#    include <netinet/in.h>
+#    include <string>
+#    include <sys/socket.h>
+#    include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * @brief Receives UDP datagrams from a set of sockets and forwards them to the
+ * attached NGIMUListener objects. The receiving loop (`run()`) blocks in poll
+ * until any of the sockets is readable and then drains up to `batchSize`
+ * datagrams per recvmmsg call. The loop is terminated by `stop()` from any
+ * thread.
+ */
+class IMU_API UdpBatchReceiver {
+ public:
+    /**
+     * Create a receiver that drains up to `batchSize` datagrams of at most
+     * `maxPacketSize` bytes per system call.
+     */
+    UdpBatchReceiver(int batchSize = 64, int maxPacketSize = 1536);
+    ~UdpBatchReceiver();
+    UdpBatchReceiver(const UdpBatchReceiver&) = delete;
+    UdpBatchReceiver& operator=(const UdpBatchReceiver&) = delete;
+
+    /**
+     * Create a UDP socket bound to the given ip and port, and attach the
+     * listener that processes its packets. An empty ip binds to all
+     * interfaces.
+     */
+    void attach(const std::string& ip, const int& port,
+                NGIMUListener* listener);
+
+    /**
+     * Receive and process packets until `stop()` is called.
+     */
+    void run();
+
+    /**
+     * Terminate the receiving loop. Thread-safe.
+     */
+    void stop();
+
+    /**
+     * Number of datagrams received so far.
+     */
+    std::size_t getNumPackets() const { return numPackets.load(); }
+
+    /**
+     * Number of recvmmsg calls that returned at least one datagram.
+     */
+    std::size_t getNumBatches() const { return numBatches.load(); }
+
+ private:
+    struct Endpoint {
+        int fd;
+        NGIMUListener* listener;
+    };
+
+    /**
+     * Drain all pending datagrams of the given endpoint.
+     */
+    void receive(const Endpoint& endpoint);
+
+    int batchSize;
+    int maxPacketSize;
+    int wakeFd; // eventfd used to interrupt poll on stop()
+    std::atomic_bool running;
+    std::atomic<std::size_t> numPackets;
+    std::atomic<std::size_t> numBatches;
+    std::vector<Endpoint> endpoints;
+
+    // preallocated recvmmsg buffers
+    std::vector<mmsghdr> messages;
+    std::vector<iovec> iovecs;
+    std::vector<sockaddr_in> addresses;
+    std::vector<char> packets;
+    std::vector<char> controls;
+};
+
+} // namespace OpenSimRT
+
+#endif // __linux__
@@ -157,3 +157,49 @@ void IMUCalibrator::recordTime(const double& timeout) {
     impl->recordTime(timeout);
     staticPoseQuaternions = impl->computeAvgStaticPose();
 }
+
+bool IMUCalibrator::recordUntilConvergence(const double& tolerance,
+                                           const double& timeout) {
+    bool converged = impl->recordUntilConvergence(tolerance, timeout);
+    staticPoseQuaternions = impl->computeAvgStaticPose();
+    return converged;
+}
+
+/*******************************************************************************/
+
+void IMUCalibrator::QuaternionAverage::reset(const size_t& numIMUs) {
+    accumulators.assign(numIMUs, Mat44(0));
+    estimates.assign(numIMUs, Vec4(0));
+    numSamples = 0;
+}
+
+void IMUCalibrator::QuaternionAverage::add(const size_t& imu,
+                                           const SimTK::Quaternion& q) {
+    const auto& v = q.asVec4();
+    accumulators[imu] += v * ~v;
+    if (estimates[imu].normSqr() == 0) estimates[imu] = v; // first sample
+    if (imu == 0) numSamples++;
+}
+
+std::vector<SimTK::Quaternion> IMUCalibrator::QuaternionAverage::compute() {
+    std::vector<SimTK::Quaternion> result;
+    result.reserve(accumulators.size());
+    for (size_t i = 0; i < accumulators.size(); ++i) {
+        // power iteration for the dominant eigenvector of the (positive
+        // semi-definite) accumulator, initialized from the previous estimate
+        // that is already close to the solution
+        Vec4 v = estimates[i];
+        for (int k = 0; k < 100; ++k) {
+            Vec4 w = accumulators[i] * v;
+            w /= w.norm();
+            const bool done = (w - v).norm() < 1e-12;
+            v = w;
+            if (done) break;
+        }
+        // keep the same hemisphere as the first sample for continuity
+        if (~v * estimates[i] < 0) v = -v;
+        estimates[i] = v;
+        result.push_back(SimTK::Quaternion(v));
+    }
+    return result;
+}
@@ -19,6 +19,15 @@
  */
 #include "NGIMUInputDriver.h"
 #include "NGIMUListener.h"
+#include "Exception.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#ifdef __linux__
+#    include <pthread.h>
+#endif
 
 using namespace std;
 using namespace osc;
@@ -72,8 +81,11 @@ void NGIMUInputDriver::setupInput(const std::vector<std::string>& imuLabels,
 
         // assign ports and manager to listeners
         listeners[i]->name = imuLabels[i];
+        listeners[i]->ip = ips[i];
         listeners[i]->port = ports[i];
-        listeners[i]->driver.reset(this);
+        // non-owning, the driver outlives its listeners
+        listeners[i]->driver = std::shared_ptr<InputDriver<NGIMUData>>(
+                this, [](InputDriver<NGIMUData>*) {});
 
         // initialize manager buffer
         buffer[ports[i]] =
@@ -106,7 +118,101 @@ void NGIMUInputDriver::setupTransmitters(
     }
 }
 
+void NGIMUInputDriver::setReceiverMode(const ReceiverMode& mode) {
+#ifndef __linux__
+    if (mode != ReceiverMode::MULTIPLEXER)
+        THROW_EXCEPTION("Batched receivers are only supported on Linux.");
+#endif
+    receiverMode = mode;
+}
+
+void NGIMUInputDriver::setShards(const int& shards,
+                                 const std::vector<int>& cpuAffinity) {
+    if (shards <= 0) THROW_EXCEPTION("Number of shards must be positive.");
+    numShards = shards;
+    shardAffinity = cpuAffinity;
+}
+
 void NGIMUInputDriver::startListening() {
+    TRACE_THREAD_NAME("IMU listener");
+#ifdef __linux__
+    if (receiverMode != ReceiverMode::MULTIPLEXER) {
+        // one receiver in BATCHED mode, no more shards than sockets
+        int n = 1;
+        if (receiverMode == ReceiverMode::SHARDED)
+            n = std::max(1, std::min(numShards, int(listeners.size())));
+
+        // the receivers are created under the lock, so that stopListening()
+        // either observes all of them (their stop is latched until run()) or
+        // none (the stop request is latched in stopRequested)
+        {
+            std::lock_guard<std::mutex> lock(listeningMutex);
+            if (stopRequested) {
+                stopRequested = false;
+                return;
+            }
+            std::vector<std::unique_ptr<UdpBatchReceiver>> newReceivers;
+            for (int j = 0; j < n; ++j)
+                newReceivers.push_back(make_unique<UdpBatchReceiver>());
+            for (int i = 0; i < listeners.size(); ++i) {
+                const auto& listener = listeners[i];
+                newReceivers[i % n]->attach(
+                        listener->ip, listener->port,
+                        dynamic_cast<NGIMUListener*>(listener.get()));
+                std::cout << "Start Listening on port: " << listener->port
+                          << std::endl;
+            }
+            receivers = std::move(newReceivers);
+        }
+
+        // start listening..
+        if (receiverMode == ReceiverMode::BATCHED) {
+            receivers[0]->run();
+            std::lock_guard<std::mutex> lock(listeningMutex);
+            stopRequested = false;
+            return;
+        }
+
+        std::mutex errorMutex;
+        std::exception_ptr error;
+        std::vector<std::thread> shards;
+        for (int j = 0; j < n; ++j) {
+            shards.emplace_back([&, j]() {
+                TRACE_THREAD_NAME("IMU listener " + std::to_string(j));
+                try {
+                    receivers[j]->run();
+                } catch (...) {
+                    {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!error) error = std::current_exception();
+                    }
+                    stopListening(); // terminate the remaining shards
+                }
+            });
+            if (!shardAffinity.empty()) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(shardAffinity[j % shardAffinity.size()], &cpus);
+                if (pthread_setaffinity_np(shards[j].native_handle(),
+                                           sizeof(cpu_set_t), &cpus) != 0)
+                    std::cout << "Unable to set CPU affinity of shard " << j
+                              << std::endl;
+            }
+        }
+        for (auto& shard : shards) shard.join();
+        {
+            std::lock_guard<std::mutex> lock(listeningMutex);
+            stopRequested = false;
+        }
+        if (error) std::rethrow_exception(error);
+        return;
+    }
+#endif
+    std::unique_lock<std::mutex> lock(listeningMutex);
+    if (stopRequested) {
+        stopRequested = false;
+        return;
+    }
     for (int i = 0; i < listeners.size(); ++i) {
         // get IP and port info from listener
         const auto& ip = listeners[i]->ip;
@@ -119,20 +225,87 @@ void NGIMUInputDriver::startListening() {
                 dynamic_cast<PacketListener*>(listeners[i].get()));
         std::cout << "Start Listening on port: " << port << std::endl;
     }
-    // start listening..
+    lock.unlock();
+
+    // start listening.. (the multiplexer resets its break flag when it starts,
+    // thus a stop issued between the check above and this call is lost)
     mux.RunUntilSigInt();
+    lock.lock();
+    stopRequested = false;
+}
+
+void NGIMUInputDriver::stopListening() {
+    std::lock_guard<std::mutex> lock(listeningMutex);
+    stopRequested = true;
+#ifdef __linux__
+    if (receiverMode != ReceiverMode::MULTIPLEXER) {
+        // the stop of a receiver is latched until its run() is called
+        for (auto& receiver : receivers) receiver->stop();
+        return;
+    }
+#endif
+    mux.Break();
 }
 
-void NGIMUInputDriver::stopListening() { mux.Break(); }
+void NGIMUInputDriver::setOrientationFilter(
+        std::shared_ptr<OrientationFilter> filter) {
+    if (filter && filter->getNumIMUs() != static_cast<int>(listeners.size()))
+        THROW_EXCEPTION("Number of IMUs does not match the filter.");
+    orientationFilter = filter;
+}
 
 NGIMUInputDriver::IMUDataList NGIMUInputDriver::getData() const {
     IMUDataList list;
-    for (const auto& listener : listeners) {
-        list.push_back(buffer[listener->port]->get(CIRCULAR_BUFFER_SIZE)[0]);
+    list.reserve(listeners.size());
+    if (!orientationFilter) {
+        for (const auto& listener : listeners) {
+            list.push_back(buffer[listener->port]->getLatest());
+        }
+        return list;
+    }
+
+    // update the filter with every sample received since the last read, so
+    // that it runs at the rate of the sensors. IMUs without new samples block
+    // until a sample is received.
+    auto samples = getDataSinceLastRead();
+    size_t numSteps = 0;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        if (samples[i].empty())
+            samples[i].push_back(buffer[listeners[i]->port]->getLatest());
+        numSteps = std::max(numSteps, samples[i].size());
+    }
+    list.resize(samples.size());
+    std::vector<bool> valid(samples.size());
+    for (size_t k = 0; k < numSteps; ++k) {
+        for (size_t i = 0; i < samples.size(); ++i) {
+            valid[i] = k < samples[i].size();
+            if (valid[i]) list[i] = samples[i][k];
+        }
+        orientationFilter->update(list, valid);
     }
     return list;
 }
 
+std::vector<NGIMUInputDriver::IMUDataList>
+NGIMUInputDriver::getDataSinceLastRead() const {
+    std::vector<IMUDataList> result;
+    result.reserve(listeners.size());
+    for (const auto& listener : listeners) {
+        result.push_back(buffer[listener->port]->drain());
+    }
+    return result;
+}
+
+NGIMUInputDriver::ParseStatistics NGIMUInputDriver::getParseStatistics() const {
+    ParseStatistics statistics{0, 0.0};
+    for (const auto& listener : listeners) {
+        auto ngimuListener = dynamic_cast<NGIMUListener*>(listener.get());
+        statistics.packets += ngimuListener->getNumParsedPackets();
+        statistics.time += ngimuListener->getParseTime();
+    }
+    return statistics;
+}
+
 // transform all imu dataFrames into a single vector
 SimTK::Vector NGIMUInputDriver::asVector(const IMUDataList& list) {
     int n = NGIMUData::size();
@@ -0,0 +1,156 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "NGIMUInputFromBinaryFileDriver.h"
+#include "Exception.h"
+#include <Common/TimeSeriesTable.h>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using namespace OpenSimRT;
+using namespace SimTK;
+using namespace std::chrono;
+
+#define BINARY_FORMAT_MAGIC "OSRTIMU"
+#define BINARY_FORMAT_VERSION 1
+
+static_assert(sizeof(NGIMUInputFromBinaryFileDriver::Header) == 64,
+              "Binary header must be 64 bytes.");
+
+Vector NGIMUInputFromBinaryFileDriver::FrameView::asVector() const {
+    return Vector(size, values, true); // borrowed (read-only) storage
+}
+
+/*******************************************************************************/
+
+NGIMUInputFromBinaryFileDriver::NGIMUInputFromBinaryFileDriver(
+        const std::string& fileName, const double& speed)
+        : file(fileName), speed(speed), nextFrame(0), terminationFlag(false) {
+    if (file.size() < sizeof(Header))
+        THROW_EXCEPTION("Invalid NGIMU binary file: " + fileName);
+    Header header;
+    memcpy(&header, file.data(), sizeof(Header));
+    if (strncmp(header.magic, BINARY_FORMAT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != BINARY_FORMAT_VERSION)
+        THROW_EXCEPTION("Invalid NGIMU binary file: " + fileName);
+
+    numIMUs = header.numIMUs;
+    numFrames = header.numFrames;
+    frameSize = 1 + numIMUs * NGIMUData::size();
+    if (file.size() < sizeof(Header) + numFrames * frameSize * sizeof(double))
+        THROW_EXCEPTION("Truncated NGIMU binary file: " + fileName);
+    frames = reinterpret_cast<const double*>(file.data() + sizeof(Header));
+}
+
+void NGIMUInputFromBinaryFileDriver::convertFromCSV(
+        const std::string& csvFileName, const std::string& binaryFileName) {
+    OpenSim::TimeSeriesTable table(csvFileName);
+    if (table.getNumColumns() % NGIMUData::size() != 0)
+        THROW_EXCEPTION("File does not contain NGIMU data: " + csvFileName);
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    strncpy(header.magic, BINARY_FORMAT_MAGIC, sizeof(header.magic));
+    header.version = BINARY_FORMAT_VERSION;
+    header.numIMUs = table.getNumColumns() / NGIMUData::size();
+    header.numFrames = table.getNumRows();
+
+    std::ofstream out(binaryFileName, std::ios::binary);
+    if (!out) THROW_EXCEPTION("Unable to open file: " + binaryFileName);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    const auto& times = table.getIndependentColumn();
+    const auto& matrix = table.getMatrix();
+    for (int i = 0; i < table.getNumRows(); ++i) {
+        out.write(reinterpret_cast<const char*>(&times[i]), sizeof(double));
+        for (int j = 0; j < table.getNumColumns(); ++j) {
+            const double value = matrix(i, j);
+            out.write(reinterpret_cast<const char*>(&value), sizeof(double));
+        }
+    }
+}
+
+void NGIMUInputFromBinaryFileDriver::startListening() {
+    nextFrame = 0;
+    terminationFlag = (numFrames == 0);
+    startTime = steady_clock::now();
+}
+
+void NGIMUInputFromBinaryFileDriver::stopListening() {
+    terminationFlag = true;
+}
+
+bool NGIMUInputFromBinaryFileDriver::shouldTerminate() const {
+    return terminationFlag.load();
+}
+
+bool NGIMUInputFromBinaryFileDriver::getFrameView(FrameView& view) const {
+    if (terminationFlag.load()) return false;
+    const auto i = nextFrame++;
+    if (i >= numFrames) {
+        terminationFlag = true;
+        return false;
+    }
+
+    const double* frame = frames + i * frameSize;
+    if (speed > 0) {
+        // absolute deadline relative to the first frame, so that the error
+        // of each sleep does not accumulate
+        const auto deadline =
+                startTime + duration_cast<steady_clock::duration>(
+                                    duration<double>((frame[0] - frames[0]) /
+                                                     speed));
+        std::this_thread::sleep_until(deadline);
+    }
+    view.time = frame[0];
+    view.values = frame + 1;
+    view.size = frameSize - 1;
+    return true;
+}
+
+void NGIMUInputFromBinaryFileDriver::setOrientationFilter(
+        std::shared_ptr<OrientationFilter> filter) {
+    if (filter && filter->getNumIMUs() != numIMUs)
+        THROW_EXCEPTION("Number of IMUs does not match the filter.");
+    orientationFilter = filter;
+}
+
+NGIMUInputFromBinaryFileDriver::IMUDataList
+NGIMUInputFromBinaryFileDriver::getData() const {
+    IMUDataList list;
+    FrameView view;
+    if (!getFrameView(view)) return list;
+    const int n = NGIMUData::size();
+    list.resize(numIMUs);
+    for (int i = 0; i < numIMUs; ++i) {
+        list[i].fromVector(Vector(n, view.values + i * n, true));
+        list[i].quaternion.timeStamp = list[i].sensors.timeStamp =
+                list[i].linear.timeStamp = list[i].altitude.timeStamp =
+                        view.time;
+    }
+    if (orientationFilter) orientationFilter->update(list);
+    return list;
+}
+
+std::pair<double, Vector>
+NGIMUInputFromBinaryFileDriver::getFrameAsVector() const {
+    FrameView view;
+    if (!getFrameView(view)) return std::make_pair(0.0, Vector());
+    return std::make_pair(view.time, Vector(view.asVector())); // deep copy
+}
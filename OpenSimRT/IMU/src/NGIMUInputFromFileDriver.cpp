@@ -37,25 +37,32 @@ void NGIMUInputFromFileDriver::startListening() {
                 if (shouldTerminate())
                     THROW_EXCEPTION("File stream terminated.");
                 {
-                    std::lock_guard<std::mutex> lock(mu);
+                    std::unique_lock<std::mutex> lock(mu);
+                    // lock-step: wait until the previous row is consumed
+                    if (rate <= 0)
+                        cond.wait(lock, [&]() {
+                            return !newRow || terminationFlag.load();
+                        });
                     time = table.getIndependentColumn()[i];
                     frame = table.getMatrix()[i];
                     newRow = true;
                 }
-                cond.notify_one();
+                cond.notify_all();
+                notifyDataAvailable();
 
                 // artificial delay
-                std::this_thread::sleep_for(std::chrono::milliseconds(
-                        static_cast<int>(1 / rate * 1000)));
+                if (rate > 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(
+                            static_cast<int>(1 / rate * 1000)));
             }
             terminationFlag = true;
-            cond.notify_one();
+            cond.notify_all();
 
         } catch (const std::exception& e) {
             std::cout << e.what() << std::endl;
 
             terminationFlag = true;
-            cond.notify_one();
+            cond.notify_all();
         }
     };
     t = std::thread(f);
@@ -67,7 +74,7 @@ bool NGIMUInputFromFileDriver::shouldTerminate() {
 
 void NGIMUInputFromFileDriver::shouldTerminate(bool flag) {
     terminationFlag = flag;
-    cond.notify_one();
+    cond.notify_all();
 }
 
 NGIMUInputFromFileDriver::IMUDataList
@@ -82,18 +89,32 @@ NGIMUInputFromFileDriver::fromVector(const Vector& v) const {
     return list;
 }
 
+void NGIMUInputFromFileDriver::setOrientationFilter(
+        std::shared_ptr<OrientationFilter> filter) {
+    if (filter && filter->getNumIMUs() * NGIMUData::size() !=
+                          static_cast<int>(table.getNumColumns()))
+        THROW_EXCEPTION("Number of IMUs does not match the filter.");
+    orientationFilter = filter;
+}
+
+NGIMUInputFromFileDriver::IMUDataList NGIMUInputFromFileDriver::fromFrame(
+        const std::pair<double, Vector>& frame) const {
+    auto list = fromVector(frame.second);
+    if (orientationFilter && !list.empty()) {
+        for (auto& data : list) data.sensors.timeStamp = frame.first;
+        orientationFilter->update(list);
+    }
+    return list;
+}
+
 NGIMUInputFromFileDriver::IMUDataList
 NGIMUInputFromFileDriver::getData() const {
-    std::unique_lock<std::mutex> lock(mu);
-    cond.wait(lock,
-              [&]() { return (newRow == true) || terminationFlag.load(); });
-    newRow = false;
-    return fromVector(frame.getAsVector());
+    return fromFrame(getFrameAsVector());
 }
 
 std::pair<double, std::vector<NGIMUData>> NGIMUInputFromFileDriver::getFrame() {
     auto temp = getFrameAsVector();
-    return std::make_pair(temp.first, fromVector(temp.second));
+    return std::make_pair(temp.first, fromFrame(temp));
 }
 
 std::pair<double, Vector> NGIMUInputFromFileDriver::getFrameAsVector() const {
@@ -101,5 +122,8 @@ std::pair<double, Vector> NGIMUInputFromFileDriver::getFrameAsVector() const {
     cond.wait(lock,
               [&]() { return (newRow == true) || terminationFlag.load(); });
     newRow = false;
-    return std::make_pair(time, frame.getAsVector());
+    auto result = std::make_pair(time, frame.getAsVector());
+    lock.unlock();
+    cond.notify_all(); // release the lock-step producer
+    return result;
 }
@@ -19,15 +19,83 @@
  */
 #include "NGIMUListener.h"
 #include "Exception.h"
+#include "Measure.h"
+#include "Tracer.h"
+#include <chrono>
+#include <cstring>
 
 using namespace std;
 using namespace osc;
 using namespace OpenSimRT;
 
-NGIMUListener::NGIMUListener() { bundleReadyFlags.reset(); }
+/**
+ * FNV-1a hash of an OSC address pattern. Evaluated at compile time for the
+ * entries of the dispatch table.
+ */
+static constexpr std::uint32_t hashAddress(const char* address) {
+    std::uint32_t hash = 2166136261u;
+    while (*address) {
+        hash ^= static_cast<std::uint8_t>(*address++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * Decode exactly n float arguments of a message. Avoids the construction of a
+ * ReceivedMessageArgumentStream for every message.
+ */
+static inline void readFloats(const ReceivedMessage& m, float* values,
+                              const int& n) {
+    if (m.ArgumentCount() < n) throw MissingArgumentException();
+    if (m.ArgumentCount() > n) throw ExcessArgumentException();
+    auto arg = m.ArgumentsBegin();
+    for (int i = 0; i < n; ++i, ++arg) values[i] = arg->AsFloat();
+}
+
+/*******************************************************************************/
+
+const std::array<NGIMUListener::MessageDispatch, 5>
+        NGIMUListener::dispatchTable = {{
+                {hashAddress("/quaternion"), "/quaternion",
+                 &NGIMUListener::processQuaternion},
+                {hashAddress("/sensors"), "/sensors",
+                 &NGIMUListener::processSensors},
+                {hashAddress("/linear"), "/linear",
+                 &NGIMUListener::processLinear},
+                {hashAddress("/altitude"), "/altitude",
+                 &NGIMUListener::processAltitude},
+                {hashAddress("/button"), "/button",
+                 &NGIMUListener::processButton},
+                // TODO add more patterns if necessary
+        }};
+
+NGIMUListener::NGIMUListener()
+        : receiveTime(0), hasReceiveTime(false), numParsedPackets(0),
+          parseNanoseconds(0) {
+    bundleReadyFlags.reset();
+}
+
+void NGIMUListener::ProcessPacket(const char* data, int size,
+                                  const IpEndpointName& remoteEndpoint) {
+    // packets without a kernel timestamp (e.g., from the oscpack multiplexer)
+    // are stamped on arrival
+    if (!hasReceiveTime)
+        receiveTime = chrono::duration<double>(
+                              chrono::system_clock::now().time_since_epoch())
+                              .count();
+    hasReceiveTime = false;
+
+    auto start = monotonicNanoseconds();
+    OscPacketListener::ProcessPacket(data, size, remoteEndpoint);
+    parseNanoseconds.fetch_add(monotonicNanoseconds() - start,
+                               memory_order_relaxed);
+    numParsedPackets.fetch_add(1, memory_order_relaxed);
+}
 
 void NGIMUListener::ProcessBundle(const ReceivedBundle& b,
                                   const IpEndpointName& remoteEndpoint) {
+    TRACE_SPAN("NGIMUListener::ProcessBundle");
     timeTag = b.TimeTag();
     for (ReceivedBundle::const_iterator i = b.ElementsBegin();
          i != b.ElementsEnd(); ++i) {
@@ -48,68 +116,74 @@ void NGIMUListener::ProcessMessage(const ReceivedMessage& m,
         // the NTP timeStamp.
         auto time = ntp2double(timeTag);
 
-        // get /quaternions
-        if (strcmp(m.AddressPattern(), "/quaternion") == 0) {
-            ReceivedMessageArgumentStream args = m.ArgumentStream();
-            float q1, q2, q3, q4;
-            args >> q1 >> q2 >> q3 >> q4 >> osc::EndMessage;
-            data.quaternion = NGIMUData::Quaternion{
-                    time, SimTK::Quaternion(q1, q2, q3, q4)};
-            bundleReadyFlags.set(0);
+        // dispatch message based on the hash of the address pattern (string
+        // comparison only on hash match to resolve collisions)
+        const char* address = m.AddressPattern();
+        const auto hash = hashAddress(address);
+        for (const auto& entry : dispatchTable) {
+            if (entry.hash == hash && strcmp(address, entry.address) == 0) {
+                (this->*entry.handler)(m, time);
+                break;
+            }
         }
 
-        // get /sensors
-        if (strcmp(m.AddressPattern(), "/sensors") == 0) {
-            ReceivedMessageArgumentStream args = m.ArgumentStream();
-            float gX, gY, gZ; // gyroscope
-            float aX, aY, aZ; // acceleration
-            float mX, mY, mZ; // magnetometer
-            float barometer;
-            args >> gX >> gY >> gZ >> aX >> aY >> aZ >> mX >> mY >> mZ >>
-                    barometer >> osc::EndMessage;
-            data.sensors.acceleration = SimTK::Vec3(aX, aY, aZ);
-            data.sensors.gyroscope = SimTK::Vec3(gX, gY, gZ);
-            data.sensors.magnetometer = SimTK::Vec3(mX, mY, mZ);
-            data.sensors.barometer = SimTK::Vec1(barometer);
-            data.sensors.timeStamp = time;
-            bundleReadyFlags.set(1);
+        // when all messages are processed, push IMU bundle to buffer (once per
+        // complete set of messages)
+        if (bundleReadyFlags.all()) {
+            data.receiveTimeStamp = receiveTime;
+            pushDataToManagerBuffer(port, data);
+            bundleReadyFlags.reset();
         }
 
-        // get linera acceleration
-        if (strcmp(m.AddressPattern(), "/linear") == 0) {
-            ReceivedMessageArgumentStream args = m.ArgumentStream();
-            float ax, ay, az; // linear acceleration
-            args >> ax >> ay >> az >> osc::EndMessage;
-            data.linear = NGIMUData::LinearAcceleration{
-                    time, SimTK::Vec3(ax, ay, az)};
-            bundleReadyFlags.set(2);
-        }
+    } catch (osc::Exception& e) {
+        cout << "Error while parsing message: " << m.AddressPattern() << ": "
+             << e.what() << "\n";
+    }
+}
 
-        // get altitude
-        if (strcmp(m.AddressPattern(), "/altitude") == 0) {
-            ReceivedMessageArgumentStream args = m.ArgumentStream();
-            float x;
-            args >> x >> osc::EndMessage;
-            data.altitude = NGIMUData::Altitude{time, SimTK::Vec1(x)};
-            bundleReadyFlags.set(3);
-        }
+void NGIMUListener::processQuaternion(const ReceivedMessage& m,
+                                      const double& time) {
+    float q[4];
+    readFloats(m, q, 4);
+    data.quaternion.timeStamp = time;
+    data.quaternion.q = SimTK::Quaternion(q[0], q[1], q[2], q[3]);
+    bundleReadyFlags.set(0);
+}
 
-        // TODO add more patterns if necessary
-        // ...
-        //
+void NGIMUListener::processSensors(const ReceivedMessage& m,
+                                   const double& time) {
+    // gyroscope, acceleration, magnetometer, barometer
+    float v[10];
+    readFloats(m, v, 10);
+    data.sensors.gyroscope = SimTK::Vec3(v[0], v[1], v[2]);
+    data.sensors.acceleration = SimTK::Vec3(v[3], v[4], v[5]);
+    data.sensors.magnetometer = SimTK::Vec3(v[6], v[7], v[8]);
+    data.sensors.barometer = SimTK::Vec1(v[9]);
+    data.sensors.timeStamp = time;
+    bundleReadyFlags.set(1);
+}
 
-        // stop dat transmition
-        if (strcmp(m.AddressPattern(), "/button") == 0) {
-            driver->stopListening();
-            THROW_EXCEPTION(
-                    "Destruction Button is Pressed! Goodbye cruel word!");
-        }
+void NGIMUListener::processLinear(const ReceivedMessage& m,
+                                  const double& time) {
+    float a[3]; // linear acceleration
+    readFloats(m, a, 3);
+    data.linear.timeStamp = time;
+    data.linear.acceleration = SimTK::Vec3(a[0], a[1], a[2]);
+    bundleReadyFlags.set(2);
+}
 
-        // when all messages are processed, push IMU bundle to buffer
-        if (bundleReadyFlags.all()) { pushDataToManagerBuffer(port, data); }
+void NGIMUListener::processAltitude(const ReceivedMessage& m,
+                                    const double& time) {
+    float x;
+    readFloats(m, &x, 1);
+    data.altitude.timeStamp = time;
+    data.altitude.measurement = SimTK::Vec1(x);
+    bundleReadyFlags.set(3);
+}
 
-    } catch (osc::Exception& e) {
-        cout << "Error while parsing message: " << m.AddressPattern() << ": "
-             << e.what() << "\n";
-    }
+void NGIMUListener::processButton(const ReceivedMessage& /*m*/,
+                                  const double& /*time*/) {
+    // stop data transmition
+    driver->stopListening();
+    THROW_EXCEPTION("Destruction Button is Pressed! Goodbye cruel word!");
 }
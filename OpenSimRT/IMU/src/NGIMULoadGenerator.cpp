@@ -0,0 +1,188 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "NGIMULoadGenerator.h"
+#include "Exception.h"
+#include "ip/UdpSocket.h"
+#include "osc/OscOutboundPacketStream.h"
+#include <Common/TimeSeriesTable.h>
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <numeric>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+using namespace OpenSimRT;
+
+// size of the bundle buffer
+#define BUNDLE_BUFFER_SIZE 512
+
+/*******************************************************************************/
+
+NGIMULoadGenerator::Report
+NGIMULoadGenerator::Report::compute(const size_t& sent,
+                                    vector<double> latencies,
+                                    const double& elapsed,
+                                    const size_t& parsed,
+                                    const double& parseTime) {
+    Report report;
+    report.sent = sent;
+    report.received = latencies.size();
+    report.packetLoss =
+            (sent > 0) ? 100.0 * (1.0 - double(report.received) / sent) : 0.0;
+    report.elapsed = elapsed;
+    report.throughput = (elapsed > 0) ? report.received / elapsed : 0.0;
+    report.parsed = parsed;
+    report.parseThroughput = (parseTime > 0) ? parsed / parseTime : 0.0;
+    report.parseTime = (parsed > 0) ? 1e6 * parseTime / parsed : 0.0;
+    report.latencyMean = report.latencyP50 = report.latencyP99 =
+            report.latencyMax = 0.0;
+    if (latencies.empty()) return report;
+
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](const double& p) {
+        size_t i = size_t(p * (latencies.size() - 1));
+        return 1000 * latencies[i];
+    };
+    report.latencyMean =
+            1000 * accumulate(latencies.begin(), latencies.end(), 0.0) /
+            latencies.size();
+    report.latencyP50 = percentile(0.5);
+    report.latencyP99 = percentile(0.99);
+    report.latencyMax = 1000 * latencies.back();
+    return report;
+}
+
+void NGIMULoadGenerator::Report::print(ostream& out) const {
+    out << fixed << setprecision(3) << "sent: " << sent
+        << "\treceived: " << received << "\tloss: " << packetLoss << "%"
+        << "\nthroughput: " << throughput << " samples/s"
+        << "\tin: " << elapsed << " s"
+        << "\nparse: " << parseThroughput << " packets/s (" << parseTime
+        << " us/packet, " << parsed << " packets)"
+        << "\nlatency (ms) mean: " << latencyMean << "\tp50: " << latencyP50
+        << "\tp99: " << latencyP99 << "\tmax: " << latencyMax << endl;
+}
+
+/*******************************************************************************/
+
+NGIMULoadGenerator::NGIMULoadGenerator(const Parameters& parameters)
+        : parameters(parameters), running(false), numSent(0) {
+    if (parameters.ports.empty()) THROW_EXCEPTION("No ports were given.");
+    if (parameters.rate <= 0) THROW_EXCEPTION("Rate must be positive.");
+}
+
+void NGIMULoadGenerator::setDataFromFile(const string& fileName) {
+    OpenSim::TimeSeriesTable table(fileName);
+    const int n = NGIMUData::size();
+    const int m = table.getNumColumns() / n; // number of IMUs in file
+    if (m == 0 || table.getNumRows() == 0)
+        THROW_EXCEPTION("File does not contain NGIMU data: " + fileName);
+
+    recorded.resize(table.getNumRows());
+    for (int i = 0; i < table.getNumRows(); ++i) {
+        const auto row = table.getRowAtIndex(i).getAsVector();
+        recorded[i].resize(m);
+        for (int j = 0; j < m; ++j) {
+            recorded[i][j].fromVector(row(j * n, n));
+        }
+    }
+}
+
+NGIMUData NGIMULoadGenerator::generate(const int& imu,
+                                       const size_t& frame) const {
+    if (!recorded.empty()) {
+        const auto& row = recorded[frame % recorded.size()];
+        return row[imu % row.size()];
+    }
+
+    // synthetic data: slow rotation about the vertical axis with a phase shift
+    // for each IMU
+    NGIMUData data;
+    double t = frame / parameters.rate;
+    double angle = 0.5 * sin(2 * SimTK::Pi * 0.5 * t + imu);
+    data.quaternion.q =
+            SimTK::Quaternion(cos(angle / 2), 0, 0, sin(angle / 2));
+    data.sensors.gyroscope = SimTK::Vec3(0, 0, SimTK::convertRadiansToDegrees(
+            0.5 * SimTK::Pi * cos(2 * SimTK::Pi * 0.5 * t + imu)));
+    data.sensors.acceleration = SimTK::Vec3(0, 0, 1);
+    data.sensors.magnetometer =
+            SimTK::Vec3(20 * cos(angle), 20 * sin(angle), -40);
+    data.sensors.barometer = SimTK::Vec1(1013.25);
+    data.linear.acceleration = SimTK::Vec3(0, 0, 0);
+    data.altitude.measurement = SimTK::Vec1(0);
+    return data;
+}
+
+void NGIMULoadGenerator::run() {
+    // one transmit socket per virtual IMU
+    vector<unique_ptr<UdpTransmitSocket>> sockets;
+    for (const auto& port : parameters.ports) {
+        sockets.push_back(make_unique<UdpTransmitSocket>(
+                IpEndpointName(parameters.ip.c_str(), port)));
+    }
+
+    char buffer[BUNDLE_BUFFER_SIZE];
+    osc::OutboundPacketStream p(buffer, BUNDLE_BUFFER_SIZE);
+
+    // absolute deadlines avoid accumulating the drift of sleep_for
+    const auto period = duration_cast<steady_clock::duration>(
+            duration<double>(1.0 / parameters.rate));
+    const auto start = steady_clock::now();
+    const auto end = start + duration_cast<steady_clock::duration>(
+                                     duration<double>(parameters.duration));
+    auto deadline = start;
+
+    running = true;
+    for (size_t frame = 0; running.load() && deadline < end; ++frame) {
+        for (int i = 0; i < sockets.size(); ++i) {
+            const auto data = generate(i, frame);
+            const auto& q = data.quaternion.q;
+            const auto& s = data.sensors;
+
+            p.Clear();
+            p << osc::BeginBundle(tp2ntp(system_clock::now()))
+              << osc::BeginMessage("/quaternion") << float(q[0])
+              << float(q[1]) << float(q[2]) << float(q[3]) << osc::EndMessage
+              << osc::BeginMessage("/sensors") << float(s.gyroscope[0])
+              << float(s.gyroscope[1]) << float(s.gyroscope[2])
+              << float(s.acceleration[0]) << float(s.acceleration[1])
+              << float(s.acceleration[2]) << float(s.magnetometer[0])
+              << float(s.magnetometer[1]) << float(s.magnetometer[2])
+              << float(s.barometer[0]) << osc::EndMessage
+              << osc::BeginMessage("/linear")
+              << float(data.linear.acceleration[0])
+              << float(data.linear.acceleration[1])
+              << float(data.linear.acceleration[2]) << osc::EndMessage
+              << osc::BeginMessage("/altitude")
+              << float(data.altitude.measurement[0]) << osc::EndMessage
+              << osc::EndBundle;
+            sockets[i]->Send(p.Data(), p.Size());
+            numSent++;
+        }
+        deadline += period;
+        this_thread::sleep_until(deadline);
+    }
+    running = false;
+}
+
+void NGIMULoadGenerator::stop() { running = false; }
@@ -0,0 +1,322 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "OrientationFilter.h"
+#include "Exception.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace OpenSimRT;
+using namespace SimTK;
+
+// The IMUs are independent, thus the iterations of the filter loops do not
+// depend on each other and the compiler can vectorize them without runtime
+// alias checks.
+#if defined(__clang__)
+#    define IMU_LOOP _Pragma("clang loop vectorize(assume_safety)")
+#elif defined(__GNUC__)
+#    define IMU_LOOP _Pragma("GCC ivdep")
+#else
+#    define IMU_LOOP
+#endif
+
+// inverse of the norm given its square, zero for zero vectors (branch-free)
+static inline double invNorm(const double& squaredNorm) {
+    return squaredNorm > 0 ? 1.0 / std::sqrt(squaredNorm) : 0.0;
+}
+
+OrientationFilter::OrientationFilter(const int& numIMUs,
+                                     const Parameters& parameters)
+        : numIMUs(numIMUs), parameters(parameters) {
+    if (numIMUs <= 0) THROW_EXCEPTION("The number of IMUs must be positive.");
+    for (auto v : {&q0, &q1, &q2, &q3, &ex, &ey, &ez, &lastTime, &dt, &gx, &gy,
+                   &gz, &ax, &ay, &az, &mx, &my, &mz})
+        v->resize(numIMUs);
+    reset();
+}
+
+void OrientationFilter::reset() {
+    std::fill(q0.begin(), q0.end(), 1.0);
+    for (auto v : {&q1, &q2, &q3, &ex, &ey, &ez, &lastTime})
+        std::fill(v->begin(), v->end(), 0.0);
+    initialized.assign(numIMUs, false);
+}
+
+SimTK::Quaternion OrientationFilter::getQuaternion(const int& i) const {
+    return SimTK::Quaternion(Vec4(q0[i], q1[i], q2[i], q3[i]), true);
+}
+
+void OrientationFilter::update(std::vector<NGIMUData>& frame,
+                               const std::vector<bool>& valid) {
+    if (frame.size() != static_cast<size_t>(numIMUs))
+        THROW_EXCEPTION("Number of IMUs does not match the filter.");
+
+    // gather the sensor data of all IMUs (array-of-structures to
+    // structure-of-arrays)
+    const double deg2rad = Pi / 180;
+    for (int i = 0; i < numIMUs; ++i) {
+        const auto& s = frame[i].sensors;
+        double h = 0;
+        if (valid.empty() || valid[i]) {
+            if (!initialized[i]) {
+                // start from the orientation estimated by the device
+                const auto& q = frame[i].quaternion.q;
+                q0[i] = q[0], q1[i] = q[1], q2[i] = q[2], q3[i] = q[3];
+                initialized[i] = true;
+            } else if (parameters.samplePeriod > 0) {
+                h = parameters.samplePeriod;
+            } else {
+                h = s.timeStamp - lastTime[i];
+                if (h < 0 || h > parameters.maxSamplePeriod) h = 0;
+            }
+            lastTime[i] = s.timeStamp;
+        }
+        dt[i] = h;
+        gx[i] = s.gyroscope[0] * deg2rad;
+        gy[i] = s.gyroscope[1] * deg2rad;
+        gz[i] = s.gyroscope[2] * deg2rad;
+        ax[i] = s.acceleration[0];
+        ay[i] = s.acceleration[1];
+        az[i] = s.acceleration[2];
+        mx[i] = s.magnetometer[0];
+        my[i] = s.magnetometer[1];
+        mz[i] = s.magnetometer[2];
+    }
+
+    update(dt.data(), gx.data(), gy.data(), gz.data(), ax.data(), ay.data(),
+           az.data(), mx.data(), my.data(), mz.data());
+
+    // scatter the estimates
+    for (int i = 0; i < numIMUs; ++i) frame[i].quaternion.q = getQuaternion(i);
+}
+
+void OrientationFilter::update(const double* dt, const double* gx,
+                               const double* gy, const double* gz,
+                               const double* ax, const double* ay,
+                               const double* az, const double* mx,
+                               const double* my, const double* mz) {
+    switch (parameters.algorithm) {
+    case Algorithm::MADGWICK:
+        if (parameters.useMagnetometer)
+            updateMadgwickMARG(dt, gx, gy, gz, ax, ay, az, mx, my, mz);
+        else
+            updateMadgwickIMU(dt, gx, gy, gz, ax, ay, az);
+        break;
+    case Algorithm::MAHONY:
+        updateMahony(dt, gx, gy, gz, ax, ay, az);
+        break;
+    default:
+        THROW_EXCEPTION("Unknown orientation filter algorithm.");
+    }
+}
+
+/*******************************************************************************/
+
+void OrientationFilter::updateMadgwickIMU(const double* dt, const double* gx,
+                                          const double* gy, const double* gz,
+                                          const double* ax, const double* ay,
+                                          const double* az) {
+    const double beta = parameters.beta;
+    double* w = q0.data();
+    double* x = q1.data();
+    double* y = q2.data();
+    double* z = q3.data();
+    IMU_LOOP for (int i = 0; i < numIMUs; ++i) {
+        // rate of change of quaternion from gyroscope
+        double qDot0 = 0.5 * (-x[i] * gx[i] - y[i] * gy[i] - z[i] * gz[i]);
+        double qDot1 = 0.5 * (w[i] * gx[i] + y[i] * gz[i] - z[i] * gy[i]);
+        double qDot2 = 0.5 * (w[i] * gy[i] - x[i] * gz[i] + z[i] * gx[i]);
+        double qDot3 = 0.5 * (w[i] * gz[i] + x[i] * gy[i] - y[i] * gx[i]);
+
+        // normalized accelerometer (zero if invalid, which disables the
+        // correction step)
+        const double an =
+                invNorm(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+        const double a0 = ax[i] * an, a1 = ay[i] * an, a2 = az[i] * an;
+
+        // gradient descent corrective step
+        const double _2q0 = 2 * w[i], _2q1 = 2 * x[i], _2q2 = 2 * y[i],
+                     _2q3 = 2 * z[i], _4q0 = 4 * w[i], _4q1 = 4 * x[i],
+                     _4q2 = 4 * y[i], _8q1 = 8 * x[i], _8q2 = 8 * y[i];
+        const double q0q0 = w[i] * w[i], q1q1 = x[i] * x[i],
+                     q2q2 = y[i] * y[i], q3q3 = z[i] * z[i];
+        double s0 = _4q0 * q2q2 + _2q2 * a0 + _4q0 * q1q1 - _2q1 * a1;
+        double s1 = _4q1 * q3q3 - _2q3 * a0 + 4 * q0q0 * x[i] - _2q0 * a1 -
+                    _4q1 + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * a2;
+        double s2 = 4 * q0q0 * y[i] + _2q0 * a0 + _4q2 * q3q3 - _2q3 * a1 -
+                    _4q2 + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * a2;
+        double s3 = 4 * q1q1 * z[i] - _2q1 * a0 + 4 * q2q2 * z[i] - _2q2 * a1;
+        const double sn = beta * (an > 0 ? 1.0 : 0.0) *
+                          invNorm(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        qDot0 -= sn * s0;
+        qDot1 -= sn * s1;
+        qDot2 -= sn * s2;
+        qDot3 -= sn * s3;
+
+        // integrate and normalize
+        const double q0n = w[i] + qDot0 * dt[i], q1n = x[i] + qDot1 * dt[i],
+                     q2n = y[i] + qDot2 * dt[i], q3n = z[i] + qDot3 * dt[i];
+        const double qn =
+                invNorm(q0n * q0n + q1n * q1n + q2n * q2n + q3n * q3n);
+        w[i] = q0n * qn;
+        x[i] = q1n * qn;
+        y[i] = q2n * qn;
+        z[i] = q3n * qn;
+    }
+}
+
+void OrientationFilter::updateMadgwickMARG(
+        const double* dt, const double* gx, const double* gy, const double* gz,
+        const double* ax, const double* ay, const double* az, const double* mx,
+        const double* my, const double* mz) {
+    const double beta = parameters.beta;
+    double* w = q0.data();
+    double* x = q1.data();
+    double* y = q2.data();
+    double* z = q3.data();
+    IMU_LOOP for (int i = 0; i < numIMUs; ++i) {
+        // rate of change of quaternion from gyroscope
+        double qDot0 = 0.5 * (-x[i] * gx[i] - y[i] * gy[i] - z[i] * gz[i]);
+        double qDot1 = 0.5 * (w[i] * gx[i] + y[i] * gz[i] - z[i] * gy[i]);
+        double qDot2 = 0.5 * (w[i] * gy[i] - x[i] * gz[i] + z[i] * gx[i]);
+        double qDot3 = 0.5 * (w[i] * gz[i] + x[i] * gy[i] - y[i] * gx[i]);
+
+        // normalized accelerometer and magnetometer measurements
+        const double an =
+                invNorm(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+        const double a0 = ax[i] * an, a1 = ay[i] * an, a2 = az[i] * an;
+        const double mn =
+                invNorm(mx[i] * mx[i] + my[i] * my[i] + mz[i] * mz[i]);
+        const double m0 = mx[i] * mn, m1 = my[i] * mn, m2 = mz[i] * mn;
+
+        // auxiliary variables
+        const double _2q0mx = 2 * w[i] * m0, _2q0my = 2 * w[i] * m1,
+                     _2q0mz = 2 * w[i] * m2, _2q1mx = 2 * x[i] * m0;
+        const double _2q0 = 2 * w[i], _2q1 = 2 * x[i], _2q2 = 2 * y[i],
+                     _2q3 = 2 * z[i], _2q0q2 = 2 * w[i] * y[i],
+                     _2q2q3 = 2 * y[i] * z[i];
+        const double q0q0 = w[i] * w[i], q0q1 = w[i] * x[i],
+                     q0q2 = w[i] * y[i], q0q3 = w[i] * z[i],
+                     q1q1 = x[i] * x[i], q1q2 = x[i] * y[i],
+                     q1q3 = x[i] * z[i], q2q2 = y[i] * y[i],
+                     q2q3 = y[i] * z[i], q3q3 = z[i] * z[i];
+
+        // reference direction of Earth's magnetic field
+        const double hx = m0 * q0q0 - _2q0my * z[i] + _2q0mz * y[i] +
+                          m0 * q1q1 + _2q1 * m1 * y[i] + _2q1 * m2 * z[i] -
+                          m0 * q2q2 - m0 * q3q3;
+        const double hy = _2q0mx * z[i] + m1 * q0q0 - _2q0mz * x[i] +
+                          _2q1mx * y[i] - m1 * q1q1 + m1 * q2q2 +
+                          _2q2 * m2 * z[i] - m1 * q3q3;
+        const double _2bx = std::sqrt(hx * hx + hy * hy);
+        const double _2bz = -_2q0mx * y[i] + _2q0my * x[i] + m2 * q0q0 +
+                            _2q1mx * z[i] - m2 * q1q1 + _2q2 * m1 * z[i] -
+                            m2 * q2q2 + m2 * q3q3;
+        const double _4bx = 2 * _2bx, _4bz = 2 * _2bz;
+
+        // gradient descent corrective step (objective function residuals)
+        const double fa0 = 2 * q1q3 - _2q0q2 - a0;
+        const double fa1 = 2 * q0q1 + _2q2q3 - a1;
+        const double fa2 = 1 - 2 * q1q1 - 2 * q2q2 - a2;
+        const double fm0 =
+                _2bx * (0.5 - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - m0;
+        const double fm1 = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - m1;
+        const double fm2 =
+                _2bx * (q0q2 + q1q3) + _2bz * (0.5 - q1q1 - q2q2) - m2;
+        double s0 = -_2q2 * fa0 + _2q1 * fa1 - _2bz * y[i] * fm0 +
+                    (-_2bx * z[i] + _2bz * x[i]) * fm1 + _2bx * y[i] * fm2;
+        double s1 = _2q3 * fa0 + _2q0 * fa1 - 4 * x[i] * fa2 +
+                    _2bz * z[i] * fm0 + (_2bx * y[i] + _2bz * w[i]) * fm1 +
+                    (_2bx * z[i] - _4bz * x[i]) * fm2;
+        double s2 = -_2q0 * fa0 + _2q3 * fa1 - 4 * y[i] * fa2 +
+                    (-_4bx * y[i] - _2bz * w[i]) * fm0 +
+                    (_2bx * x[i] + _2bz * z[i]) * fm1 +
+                    (_2bx * w[i] - _4bz * y[i]) * fm2;
+        double s3 = _2q1 * fa0 + _2q2 * fa1 +
+                    (-_4bx * z[i] + _2bz * x[i]) * fm0 +
+                    (-_2bx * w[i] + _2bz * y[i]) * fm1 + _2bx * x[i] * fm2;
+        const double sn = beta * (an > 0 && mn > 0 ? 1.0 : 0.0) *
+                          invNorm(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3);
+        qDot0 -= sn * s0;
+        qDot1 -= sn * s1;
+        qDot2 -= sn * s2;
+        qDot3 -= sn * s3;
+
+        // integrate and normalize
+        const double q0n = w[i] + qDot0 * dt[i], q1n = x[i] + qDot1 * dt[i],
+                     q2n = y[i] + qDot2 * dt[i], q3n = z[i] + qDot3 * dt[i];
+        const double qn =
+                invNorm(q0n * q0n + q1n * q1n + q2n * q2n + q3n * q3n);
+        w[i] = q0n * qn;
+        x[i] = q1n * qn;
+        y[i] = q2n * qn;
+        z[i] = q3n * qn;
+    }
+}
+
+void OrientationFilter::updateMahony(const double* dt, const double* gx,
+                                     const double* gy, const double* gz,
+                                     const double* ax, const double* ay,
+                                     const double* az) {
+    const double kp = parameters.kp, ki = parameters.ki;
+    double* w = q0.data();
+    double* x = q1.data();
+    double* y = q2.data();
+    double* z = q3.data();
+    double* ix = ex.data();
+    double* iy = ey.data();
+    double* iz = ez.data();
+    IMU_LOOP for (int i = 0; i < numIMUs; ++i) {
+        // normalized accelerometer (zero if invalid, which disables the
+        // feedback)
+        const double an =
+                invNorm(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+        const double a0 = ax[i] * an, a1 = ay[i] * an, a2 = az[i] * an;
+
+        // estimated direction of gravity (half)
+        const double vx = x[i] * z[i] - w[i] * y[i];
+        const double vy = w[i] * x[i] + y[i] * z[i];
+        const double vz = w[i] * w[i] - 0.5 + z[i] * z[i];
+
+        // error between estimated and measured direction of gravity (half)
+        const double e0 = a1 * vz - a2 * vy;
+        const double e1 = a2 * vx - a0 * vz;
+        const double e2 = a0 * vy - a1 * vx;
+
+        // integral and proportional feedback
+        ix[i] += 2 * ki * e0 * dt[i];
+        iy[i] += 2 * ki * e1 * dt[i];
+        iz[i] += 2 * ki * e2 * dt[i];
+        const double wx = (gx[i] + ix[i] + 2 * kp * e0) * 0.5 * dt[i];
+        const double wy = (gy[i] + iy[i] + 2 * kp * e1) * 0.5 * dt[i];
+        const double wz = (gz[i] + iz[i] + 2 * kp * e2) * 0.5 * dt[i];
+
+        // integrate and normalize
+        const double q0n = w[i] - x[i] * wx - y[i] * wy - z[i] * wz;
+        const double q1n = x[i] + w[i] * wx + y[i] * wz - z[i] * wy;
+        const double q2n = y[i] + w[i] * wy - x[i] * wz + z[i] * wx;
+        const double q3n = z[i] + w[i] * wz + x[i] * wy - y[i] * wx;
+        const double qn =
+                invNorm(q0n * q0n + q1n * q1n + q2n * q2n + q3n * q3n);
+        w[i] = q0n * qn;
+        x[i] = q1n * qn;
+        y[i] = q2n * qn;
+        z[i] = q3n * qn;
+    }
+}
@@ -0,0 +1,183 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#ifdef __linux__
+
+#    include "UdpBatchReceiver.h"
+#    include "Exception.h"
+#    include <arpa/inet.h>
+#    include <cerrno>
+#    include <cstring>
+#    include <iostream>
+#    include <poll.h>
+#    include <sys/eventfd.h>
+#    include <unistd.h>
+
+using namespace std;
+using namespace OpenSimRT;
+
+// size of the ancillary data buffer of each message (kernel timestamp)
+#    define CONTROL_BUFFER_SIZE CMSG_SPACE(sizeof(struct timespec))
+
+// requested socket receive buffer size (bytes)
+#    define SOCKET_RECEIVE_BUFFER_SIZE (1 << 20)
+
+UdpBatchReceiver::UdpBatchReceiver(int batchSize, int maxPacketSize)
+        : batchSize(batchSize), maxPacketSize(maxPacketSize), running(false),
+          numPackets(0), numBatches(0) {
+    if (batchSize <= 0 || maxPacketSize <= 0)
+        THROW_EXCEPTION("Batch and packet sizes must be positive.");
+
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+    if (wakeFd < 0) THROW_EXCEPTION("Unable to create eventfd.");
+
+    // preallocate message headers, they are reset before each recvmmsg
+    messages.resize(batchSize);
+    iovecs.resize(batchSize);
+    addresses.resize(batchSize);
+    packets.resize(batchSize * maxPacketSize);
+    controls.resize(batchSize * CONTROL_BUFFER_SIZE);
+    for (int i = 0; i < batchSize; ++i) {
+        iovecs[i].iov_base = &packets[i * maxPacketSize];
+        iovecs[i].iov_len = maxPacketSize;
+        memset(&messages[i], 0, sizeof(mmsghdr));
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_name = &addresses[i];
+        messages[i].msg_hdr.msg_control = &controls[i * CONTROL_BUFFER_SIZE];
+    }
+}
+
+UdpBatchReceiver::~UdpBatchReceiver() {
+    for (const auto& endpoint : endpoints) close(endpoint.fd);
+    close(wakeFd);
+}
+
+void UdpBatchReceiver::attach(const std::string& ip, const int& port,
+                              NGIMUListener* listener) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) THROW_EXCEPTION("Unable to create UDP socket.");
+
+    // request kernel receive timestamps and a larger receive buffer, so that
+    // bursts from many IMUs are not dropped while a batch is processed
+    int enable = 1;
+    int bufferSize = SOCKET_RECEIVE_BUFFER_SIZE;
+    setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (!ip.empty() &&
+        inet_pton(AF_INET, ip.c_str(), &address.sin_addr) != 1) {
+        close(fd);
+        THROW_EXCEPTION("Invalid IP address: " + ip);
+    }
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) <
+        0) {
+        close(fd);
+        THROW_EXCEPTION("Unable to bind UDP socket on port " +
+                        to_string(port) + ": " + strerror(errno));
+    }
+    endpoints.push_back(Endpoint{fd, listener});
+}
+
+void UdpBatchReceiver::run() {
+    vector<pollfd> fds(endpoints.size() + 1);
+    for (size_t i = 0; i < endpoints.size(); ++i) {
+        fds[i].fd = endpoints[i].fd;
+        fds[i].events = POLLIN;
+    }
+    fds.back().fd = wakeFd;
+    fds.back().events = POLLIN;
+
+    running = true;
+    while (running.load()) {
+        if (poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            THROW_EXCEPTION(string("poll failed: ") + strerror(errno));
+        }
+        if (fds.back().revents & POLLIN) break; // stop() was called
+        for (size_t i = 0; i < endpoints.size(); ++i) {
+            if (fds[i].revents & POLLIN) receive(endpoints[i]);
+        }
+    }
+    running = false;
+
+    // consume pending wake-up so the receiver can be restarted
+    eventfd_t value;
+    eventfd_read(wakeFd, &value);
+}
+
+void UdpBatchReceiver::stop() {
+    running = false;
+    eventfd_write(wakeFd, 1);
+}
+
+void UdpBatchReceiver::receive(const Endpoint& endpoint) {
+    while (true) {
+        // the kernel overwrites the lengths of the name and control buffers
+        for (int i = 0; i < batchSize; ++i) {
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            messages[i].msg_hdr.msg_controllen = CONTROL_BUFFER_SIZE;
+        }
+
+        int n = recvmmsg(endpoint.fd, messages.data(), batchSize, MSG_DONTWAIT,
+                         nullptr);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                errno != EINTR)
+                cout << "recvmmsg failed: " << strerror(errno) << endl;
+            return;
+        }
+        numBatches++;
+        numPackets += n;
+
+        for (int i = 0; i < n; ++i) {
+            auto& header = messages[i].msg_hdr;
+
+            // extract kernel receive timestamp
+            double receiveTime = 0;
+            for (cmsghdr* c = CMSG_FIRSTHDR(&header); c != nullptr;
+                 c = CMSG_NXTHDR(&header, c)) {
+                if (c->cmsg_level == SOL_SOCKET &&
+                    c->cmsg_type == SCM_TIMESTAMPNS) {
+                    timespec ts;
+                    memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                    receiveTime = ts.tv_sec + ts.tv_nsec * 1e-9;
+                }
+            }
+
+            const auto& address = addresses[i];
+            IpEndpointName remoteEndpoint(ntohl(address.sin_addr.s_addr),
+                                          ntohs(address.sin_port));
+            endpoint.listener->setReceiveTime(receiveTime);
+            endpoint.listener->ProcessPacket(
+                    static_cast<const char*>(iovecs[i].iov_base),
+                    messages[i].msg_len, remoteEndpoint);
+        }
+
+        // a partial batch means that the socket queue is empty
+        if (n < batchSize) return;
+    }
+}
+
+#endif // __linux__
@@ -0,0 +1,149 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestIMUCalibrator.cpp
+ *
+ * @brief Test the static pose averaging of the IMUCalibrator with noisy
+ * quaternions of known mean, and the termination of the recording when the
+ * average converges.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "IMUCalibrator.h"
+#include <cmath>
+#include <iostream>
+#include <random>
+
+using namespace std;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+/**
+ * Driver that provides noisy orientations of a static pose. Each sample is the
+ * true orientation perturbed by a rotation with normally distributed rotation
+ * vector. The sign of the quaternions is random, as the average must not
+ * depend on it.
+ */
+class NoisyPoseDriver : public InputDriver<NGIMUData> {
+ public:
+    NoisyPoseDriver(const vector<Rotation>& pose, const double& sigma)
+            : pose(pose), noise(0, sigma), numFrames(0) {}
+
+    void startListening() override {}
+    void stopListening() override {}
+
+    IMUDataList getData() const override {
+        IMUDataList list(pose.size());
+        for (size_t i = 0; i < pose.size(); ++i) {
+            Vec3 w(noise(generator), noise(generator), noise(generator));
+            Rotation R = pose[i];
+            if (w.norm() > 0) R = R * Rotation(w.norm(), UnitVec3(w));
+            Vec4 q = R.convertRotationToQuaternion().asVec4();
+            if (sign(generator)) q = -q;
+            list[i].quaternion.q = Quaternion(q);
+        }
+        numFrames++;
+        return list;
+    }
+
+    vector<Rotation> pose;
+    mutable mt19937 generator;
+    mutable normal_distribution<double> noise;
+    mutable bernoulli_distribution sign;
+    mutable size_t numFrames;
+};
+
+/**
+ * Angle (in radians) between the orientations of two quaternions.
+ */
+double angle(const Quaternion& q1, const Quaternion& q2) {
+    double d = abs(~q1.asVec4() * q2.asVec4());
+    return 2 * acos(min(d, 1.0));
+}
+
+void expectPose(const IMUCalibrator& calibrator, const vector<Rotation>& pose,
+                const double& tolerance) {
+    const auto& average = calibrator.getStaticPoseQuaternions();
+    if (average.size() != pose.size())
+        THROW_EXCEPTION("wrong number of averaged IMUs");
+    for (size_t i = 0; i < pose.size(); ++i) {
+        double error = angle(average[i], pose[i].convertRotationToQuaternion());
+        cout << "IMU " << i << " error: " << convertRadiansToDegrees(error)
+             << " deg" << endl;
+        if (error > tolerance)
+            THROW_EXCEPTION("average of IMU " + to_string(i) +
+                            " is not within the tolerance");
+    }
+}
+
+void run() {
+    // known static pose of two IMUs, noise of ~1.7 deg per axis
+    vector<Rotation> pose = {Rotation(Pi / 6, UnitVec3(1, 1, 0)),
+                             Rotation(2 * Pi / 3, ZAxis)};
+    const double sigma = 0.03;
+    OpenSim::Model model;
+
+    // average of a fixed number of samples
+    {
+        NoisyPoseDriver driver(pose, sigma);
+        IMUCalibrator calibrator(model, &driver, {});
+        calibrator.recordNumOfSamples(5000);
+        if (driver.numFrames != 5000)
+            THROW_EXCEPTION("wrong number of recorded samples");
+        // standard error of the mean is ~sigma / sqrt(n)
+        expectPose(calibrator, pose, 0.005);
+    }
+
+    // recording stops when the average converges, long before the timeout
+    {
+        NoisyPoseDriver driver(pose, sigma);
+        IMUCalibrator calibrator(model, &driver, {});
+        const double tolerance = 1e-3;
+        if (!calibrator.recordUntilConvergence(tolerance, 60))
+            THROW_EXCEPTION("recording did not converge");
+        cout << "converged after " << driver.numFrames << " samples ("
+             << calibrator.getConvergence() << " rad)" << endl;
+        if (calibrator.getConvergence() >= tolerance)
+            THROW_EXCEPTION("convergence metric is above the tolerance");
+        if (driver.numFrames > 10000)
+            THROW_EXCEPTION("convergence was detected too late");
+        expectPose(calibrator, pose, 0.01);
+    }
+
+    // an unreachable tolerance stops at the timeout
+    {
+        NoisyPoseDriver driver(pose, sigma);
+        IMUCalibrator calibrator(model, &driver, {});
+        if (calibrator.recordUntilConvergence(0, 0.2))
+            THROW_EXCEPTION("recording converged to an unreachable tolerance");
+        expectPose(calibrator, pose, 0.005);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
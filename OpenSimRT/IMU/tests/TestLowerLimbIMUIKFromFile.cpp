@@ -28,6 +28,7 @@
 #include "InverseKinematics.h"
 #include "NGIMUInputFromFileDriver.h"
 #include "OpenSimUtils.h"
+#include "PerformanceGate.h"
 #include "Settings.h"
 #include "Utils.h"
 #include "Visualization.h"
@@ -40,7 +41,7 @@ using namespace OpenSim;
 using namespace OpenSimRT;
 using namespace SimTK;
 
-void run() {
+void run(const PerformanceGate& gate) {
     INIReader ini(INI_FILE);
     auto section = "LOWER_LIMB_NGIMU_OFFLINE";
 
@@ -55,6 +56,8 @@ void run() {
 
     // driver send rate
     auto rate = ini.getInteger(section, "DRIVER_SEND_RATE", 0);
+    // replay as fast as possible for the performance gate
+    if (gate.isEnabled()) rate = 0;
 
     // subject data
     auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
@@ -93,6 +96,8 @@ void run() {
     // mean delay
     int sumDelayMS = 0;
     int numFrames = 0;
+    LatencyHistogram latencies;
+    auto start = monotonicNanoseconds();
 
     try { // main loop
         while (!(driver.shouldTerminate())) {
@@ -111,9 +116,12 @@ void run() {
             t2 = chrono::high_resolution_clock::now();
             sumDelayMS += chrono::duration_cast<chrono::milliseconds>(t2 - t1)
                                   .count();
+            latencies.record(
+                    chrono::duration_cast<chrono::nanoseconds>(t2 - t1)
+                            .count());
 
-            // visualize
-            visualizer.update(pose.q);
+            // visualize (not part of the throughput of the performance gate)
+            if (!gate.isEnabled()) visualizer.update(pose.q);
 
             // record
             qLogger.appendRow(pose.t, ~pose.q);
@@ -124,7 +132,11 @@ void run() {
         driver.shouldTerminate(true);
     }
 
+    auto duration = (monotonicNanoseconds() - start) * 1e-9;
+
     cout << "Mean delay: " << (double) sumDelayMS / numFrames << " ms" << endl;
+    gate.submit(PerformanceReport::fromLatencies(
+            "TestLowerLimbIMUIKFromFile", latencies.getStatistics(), duration));
 
     // // store results
     // STOFileAdapter::write(
@@ -133,7 +145,9 @@ void run() {
 
 int main(int argc, char* argv[]) {
     try {
-        run();
+        PerformanceGate gate(argc, argv, INI_FILE, DATA_DIR,
+                             LIBRARY_OUTPUT_PATH);
+        run(gate);
     } catch (exception& e) {
         cout << e.what() << endl;
         return -1;
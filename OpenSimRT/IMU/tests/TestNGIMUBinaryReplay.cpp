@@ -0,0 +1,106 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestNGIMUBinaryReplay.cpp
+ *
+ * @brief Test the replay of prerecorded NGIMU data from a binary file, as fast
+ * as possible and paced at N times the recorded rate.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "INIReader.h"
+#include "NGIMUInputFromBinaryFileDriver.h"
+#include "Settings.h"
+#include <Common/TimeSeriesTable.h>
+#include <chrono>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+void run() {
+    INIReader ini(INI_FILE);
+    auto section = "LOWER_LIMB_NGIMU_OFFLINE";
+
+    // subject data
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto ngimuDataFile =
+            subjectDir + ini.getString(section, "NGIMU_DATA_CSV", "");
+    auto binaryFile = LIBRARY_OUTPUT_PATH + "/ngimu_data.bin";
+
+    // convert the csv recording to binary
+    NGIMUInputFromBinaryFileDriver::convertFromCSV(ngimuDataFile, binaryFile);
+    TimeSeriesTable table(ngimuDataFile);
+
+    // replay as fast as possible and compare with the csv table
+    {
+        NGIMUInputFromBinaryFileDriver driver(binaryFile, 0);
+        driver.startListening();
+        NGIMUInputFromBinaryFileDriver::FrameView frame;
+        size_t i = 0;
+        auto t1 = chrono::steady_clock::now();
+        while (driver.getFrameView(frame)) {
+            const auto& row = table.getRowAtIndex(i).getAsVector();
+            if (frame.time != table.getIndependentColumn()[i] ||
+                (frame.asVector() - row).normInf() > 0)
+                THROW_EXCEPTION("Frame " + to_string(i) + " does not match.");
+            ++i;
+        }
+        auto t2 = chrono::steady_clock::now();
+        if (i != table.getNumRows())
+            THROW_EXCEPTION("Number of replayed frames does not match.");
+        cout << "Replayed " << i << " frames in "
+             << chrono::duration<double, milli>(t2 - t1).count() << " ms"
+             << endl;
+    }
+
+    // replay 50 frames at 4x, frames must not be delivered before their
+    // deadline
+    {
+        const double speed = 4;
+        const int n = 50;
+        NGIMUInputFromBinaryFileDriver driver(binaryFile, speed);
+        // the pacing starts with the replay, thus the clock starts before it
+        auto t1 = chrono::steady_clock::now();
+        driver.startListening();
+        pair<double, Vector> frame;
+        for (int i = 0; i < n; ++i) frame = driver.getFrameAsVector();
+        auto elapsed = chrono::duration<double>(chrono::steady_clock::now() -
+                                                t1)
+                               .count();
+        auto expected = (table.getIndependentColumn()[n - 1] -
+                         table.getIndependentColumn()[0]) /
+                        speed;
+        cout << "Paced replay: " << elapsed << " s (expected: " << expected
+             << " s)" << endl;
+        if (elapsed < expected) THROW_EXCEPTION("Replay is not paced.");
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
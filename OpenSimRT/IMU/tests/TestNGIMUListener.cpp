@@ -0,0 +1,197 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestNGIMUListener.cpp
+ *
+ * @brief Test the decoding of synthetic NGIMU OSC bundles by the dispatch table
+ * of the NGIMUListener, received through the oscpack multiplexer and the
+ * batched (recvmmsg) receiver on loopback.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "NGIMUInputDriver.h"
+#include "TimeConversion.h"
+#include "UdpBatchReceiver.h"
+#include "ip/UdpSocket.h"
+#include "osc/OscOutboundPacketStream.h"
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+using namespace OpenSimRT;
+
+// number of bundles sent to each IMU (less than the driver's buffer size, so
+// that all samples can be drained at the end)
+#define NUM_FRAMES 10
+
+/**
+ * Known sample of the i-th IMU at the k-th frame.
+ */
+NGIMUData makeSample(int i, int k) {
+    NGIMUData data;
+    double angle = 0.1 * k + i;
+    data.quaternion.q =
+            SimTK::Quaternion(cos(angle / 2), 0, 0, sin(angle / 2));
+    data.sensors.gyroscope = SimTK::Vec3(i, k, 0.5);
+    data.sensors.acceleration = SimTK::Vec3(0.1 * k, -9.81, i);
+    data.sensors.magnetometer = SimTK::Vec3(20, -5, 0.25 * k);
+    data.sensors.barometer = SimTK::Vec1(1013 + k);
+    data.linear.acceleration = SimTK::Vec3(0.01 * k, 0.02 * i, -0.5);
+    data.altitude.measurement = SimTK::Vec1(100 + 0.5 * k);
+    return data;
+}
+
+/**
+ * Send a sample as an NGIMU bundle. The messages are not in the order of the
+ * dispatch table, the linear acceleration and altitude are nested in a bundle
+ * and an unknown message is included, which must be ignored.
+ */
+void sendSample(UdpTransmitSocket& socket, const NGIMUData& data,
+                const std::uint64_t& timeTag) {
+    char buffer[1024];
+    osc::OutboundPacketStream p(buffer, sizeof(buffer));
+    const auto& q = data.quaternion.q;
+    const auto& s = data.sensors;
+    p << osc::BeginBundle(timeTag) << osc::BeginMessage("/battery")
+      << 95.0f << osc::EndMessage << osc::BeginMessage("/sensors")
+      << float(s.gyroscope[0]) << float(s.gyroscope[1])
+      << float(s.gyroscope[2]) << float(s.acceleration[0])
+      << float(s.acceleration[1]) << float(s.acceleration[2])
+      << float(s.magnetometer[0]) << float(s.magnetometer[1])
+      << float(s.magnetometer[2]) << float(s.barometer[0]) << osc::EndMessage
+      << osc::BeginBundle(timeTag) << osc::BeginMessage("/altitude")
+      << float(data.altitude.measurement[0]) << osc::EndMessage
+      << osc::BeginMessage("/linear") << float(data.linear.acceleration[0])
+      << float(data.linear.acceleration[1])
+      << float(data.linear.acceleration[2]) << osc::EndMessage
+      << osc::EndBundle << osc::BeginMessage("/quaternion") << float(q[0])
+      << float(q[1]) << float(q[2]) << float(q[3]) << osc::EndMessage
+      << osc::EndBundle;
+    socket.Send(p.Data(), p.Size());
+}
+
+template <int M>
+void expectEqual(const SimTK::Vec<M>& received, const SimTK::Vec<M>& expected,
+                 const string& name) {
+    // values are transmitted as floats
+    for (int j = 0; j < M; ++j)
+        if (abs(received[j] - expected[j]) > 1e-5)
+            THROW_EXCEPTION(name + " was not decoded correctly.");
+}
+
+void testReceiver(const NGIMUInputDriver::ReceiverMode& mode,
+                  const int& basePort) {
+    const int numIMUs = 2;
+    const string ip = "127.0.0.1";
+    vector<string> labels;
+    vector<int> ports;
+    for (int i = 0; i < numIMUs; ++i) {
+        labels.push_back("imu_" + to_string(i));
+        ports.push_back(basePort + i);
+    }
+
+    NGIMUInputDriver driver;
+    driver.setupInput(labels, vector<string>(numIMUs, ip), ports);
+    driver.setReceiverMode(mode);
+    if (mode == NGIMUInputDriver::ReceiverMode::SHARDED)
+        driver.setShards(numIMUs);
+    thread listen(&NGIMUInputDriver::startListening, &driver);
+    this_thread::sleep_for(milliseconds(200)); // wait for sockets to bind
+
+    // send the frames, each with its own time tag
+    vector<unique_ptr<UdpTransmitSocket>> sockets;
+    for (const auto& port : ports)
+        sockets.push_back(make_unique<UdpTransmitSocket>(
+                IpEndpointName(ip.c_str(), port)));
+    const auto start = system_clock::now();
+    vector<std::uint64_t> timeTags;
+    for (int k = 0; k < NUM_FRAMES; ++k) {
+        timeTags.push_back(tp2ntp(start + milliseconds(10 * k)));
+        for (int i = 0; i < numIMUs; ++i)
+            sendSample(*sockets[i], makeSample(i, k), timeTags[k]);
+        this_thread::sleep_for(milliseconds(2));
+    }
+    this_thread::sleep_for(milliseconds(100)); // receive in-flight packets
+    auto received = driver.getDataSinceLastRead();
+    driver.stopListening();
+    listen.join();
+
+    // every bundle is decoded into exactly one sample
+    for (int i = 0; i < numIMUs; ++i) {
+        if (received[i].size() != NUM_FRAMES)
+            THROW_EXCEPTION("IMU " + to_string(i) + " received " +
+                            to_string(received[i].size()) + " samples, " +
+                            to_string(NUM_FRAMES) + " were sent.");
+        for (int k = 0; k < NUM_FRAMES; ++k) {
+            const auto& sample = received[i][k];
+            const auto expected = makeSample(i, k);
+            expectEqual<4>(sample.quaternion.q, expected.quaternion.q,
+                           "quaternion");
+            expectEqual(sample.sensors.gyroscope, expected.sensors.gyroscope,
+                        "gyroscope");
+            expectEqual(sample.sensors.acceleration,
+                        expected.sensors.acceleration, "acceleration");
+            expectEqual(sample.sensors.magnetometer,
+                        expected.sensors.magnetometer, "magnetometer");
+            expectEqual(sample.sensors.barometer, expected.sensors.barometer,
+                        "barometer");
+            expectEqual(sample.linear.acceleration,
+                        expected.linear.acceleration, "linear acceleration");
+            expectEqual(sample.altitude.measurement,
+                        expected.altitude.measurement, "altitude");
+            const auto time = ntp2double(timeTags[k]);
+            if (sample.quaternion.timeStamp != time ||
+                sample.sensors.timeStamp != time ||
+                sample.linear.timeStamp != time ||
+                sample.altitude.timeStamp != time)
+                THROW_EXCEPTION("The bundle time tag was not decoded.");
+            // kernel receive timestamps are provided by the batched receiver
+            if (mode != NGIMUInputDriver::ReceiverMode::MULTIPLEXER &&
+                abs(sample.receiveTimeStamp - time) > 10)
+                THROW_EXCEPTION("Invalid receive timestamp.");
+        }
+    }
+}
+
+void run() {
+    testReceiver(NGIMUInputDriver::ReceiverMode::MULTIPLEXER, 9400);
+#ifdef __linux__
+    testReceiver(NGIMUInputDriver::ReceiverMode::BATCHED, 9410);
+    testReceiver(NGIMUInputDriver::ReceiverMode::SHARDED, 9420);
+
+    // a stop issued before run() is latched
+    UdpBatchReceiver receiver;
+    receiver.stop();
+    receiver.run();
+#endif
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestOrientationFilter.cpp
+ *
+ * @brief Test the convergence of the orientation filters (Madgwick IMU and
+ * MARG, Mahony) on synthetic sensor data of known orientation: a static pose
+ * observed through gravity (and the magnetic field) from a wrong initial
+ * estimate, and a constant rotation tracked from the true initial orientation.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "OrientationFilter.h"
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+// Earth frame references of the filters (z up)
+const Vec3 gravity(0, 0, 1);          // in g
+const Vec3 magneticField(20, 0, -40); // in uT
+const double samplePeriod = 0.01;     // 100 Hz
+
+/**
+ * Sensor data of an IMU with true orientation R (sensor to Earth) and angular
+ * velocity w (rad/s, sensor frame). The device quaternion is the initial
+ * estimate of the filter.
+ */
+NGIMUData measure(const double& t, const Rotation& R, const Vec3& w,
+                  const Rotation& initial) {
+    NGIMUData data;
+    data.sensors.timeStamp = t;
+    data.sensors.gyroscope = w * 180 / Pi;
+    data.sensors.acceleration = ~R * gravity;
+    data.sensors.magnetometer = ~R * magneticField;
+    data.quaternion.timeStamp = t;
+    data.quaternion.q = initial.convertRotationToQuaternion();
+    return data;
+}
+
+/**
+ * Angle (in radians) between two orientations.
+ */
+double angle(const Quaternion& q1, const Quaternion& q2) {
+    double d = abs(~q1.asVec4() * q2.asVec4());
+    return 2 * acos(min(d, 1.0));
+}
+
+/**
+ * Angle (in radians) between the directions of gravity in the sensor frame
+ * (tilt error). The heading is not observable without the magnetometer.
+ */
+double tiltAngle(const Quaternion& q1, const Quaternion& q2) {
+    double d = ~(~Rotation(q1) * gravity) * (~Rotation(q2) * gravity);
+    return acos(max(-1.0, min(d, 1.0)));
+}
+
+/**
+ * Static poses of the IMUs observed from the identity orientation. The
+ * estimates must converge to the true tilt (and heading if the magnetometer
+ * is used).
+ */
+void testStaticPose(const string& name,
+                    const OrientationFilter::Parameters& parameters,
+                    const bool& observableHeading) {
+    vector<Rotation> pose = {Rotation(Pi / 4, XAxis),
+                             Rotation(-Pi / 3, YAxis),
+                             Rotation(Pi / 3, UnitVec3(1, 1, 1)),
+                             Rotation(Pi / 2, ZAxis)};
+    const int n = pose.size();
+    OrientationFilter filter(n, parameters);
+
+    const double duration = 60;
+    vector<NGIMUData> frame(n);
+    for (double t = 0; t < duration; t += samplePeriod) {
+        for (int i = 0; i < n; ++i)
+            frame[i] = measure(t, pose[i], Vec3(0), Rotation());
+        filter.update(frame);
+    }
+
+    const double tolerance = convertDegreesToRadians(0.5);
+    for (int i = 0; i < n; ++i) {
+        auto q = pose[i].convertRotationToQuaternion();
+        double tilt = tiltAngle(filter.getQuaternion(i), q);
+        double error = angle(filter.getQuaternion(i), q);
+        cout << name << " static IMU " << i
+             << " tilt error: " << convertRadiansToDegrees(tilt)
+             << " deg, orientation error: " << convertRadiansToDegrees(error)
+             << " deg" << endl;
+        if (tilt > tolerance)
+            THROW_EXCEPTION(name + ": tilt of IMU " + to_string(i) +
+                            " did not converge");
+        if (observableHeading && error > tolerance)
+            THROW_EXCEPTION(name + ": orientation of IMU " + to_string(i) +
+                            " did not converge");
+        // the update must replace the device quaternion with the estimate
+        if (angle(frame[i].quaternion.q, filter.getQuaternion(i)) > 1e-6)
+            THROW_EXCEPTION(name + ": frame was not updated with the estimate");
+    }
+}
+
+/**
+ * Constant angular velocity in the sensor frame, so that the true orientation
+ * is R(t) = R0 * R(|w| t, w). Starting from the true initial orientation, the
+ * estimate must track the rotation.
+ */
+void testConstantRotation(const string& name,
+                          const OrientationFilter::Parameters& parameters) {
+    const Rotation R0(Pi / 6, UnitVec3(1, -1, 0));
+    const vector<Vec3> velocity = {Vec3(0, 0, 1), Vec3(0.5, 0.3, -0.2),
+                                   Vec3(-1, 0.4, 0.6)};
+    const int n = velocity.size();
+    OrientationFilter filter(n, parameters);
+
+    auto trueOrientation = [&](const double& t, const Vec3& w) {
+        if (w.norm() == 0) return R0;
+        return Rotation(R0 * Rotation(w.norm() * t, UnitVec3(w)));
+    };
+
+    // the correction compares the measurements with the orientation of the
+    // previous sample, thus an error of the order of |w| dt is expected
+    const double duration = 10;
+    const double tolerance = convertDegreesToRadians(2);
+    vector<NGIMUData> frame(n);
+    vector<double> maxError(n, 0);
+    for (double t = 0; t < duration; t += samplePeriod) {
+        for (int i = 0; i < n; ++i)
+            frame[i] = measure(t, trueOrientation(t, velocity[i]),
+                               velocity[i], R0);
+        filter.update(frame);
+        for (int i = 0; i < n; ++i) {
+            auto q = trueOrientation(t, velocity[i])
+                             .convertRotationToQuaternion();
+            maxError[i] = max(maxError[i], angle(filter.getQuaternion(i), q));
+        }
+    }
+
+    for (int i = 0; i < n; ++i) {
+        cout << name << " rotating IMU " << i << " max orientation error: "
+             << convertRadiansToDegrees(maxError[i]) << " deg" << endl;
+        if (maxError[i] > tolerance)
+            THROW_EXCEPTION(name + ": rotation of IMU " + to_string(i) +
+                            " was not tracked");
+    }
+}
+
+void run() {
+    OrientationFilter::Parameters madgwickIMU;
+    madgwickIMU.algorithm = OrientationFilter::Algorithm::MADGWICK;
+    madgwickIMU.useMagnetometer = false;
+
+    OrientationFilter::Parameters madgwickMARG;
+    madgwickMARG.algorithm = OrientationFilter::Algorithm::MADGWICK;
+    madgwickMARG.useMagnetometer = true;
+
+    OrientationFilter::Parameters mahony;
+    mahony.algorithm = OrientationFilter::Algorithm::MAHONY;
+    mahony.ki = 0.1;
+
+    testStaticPose("Madgwick (IMU)", madgwickIMU, false);
+    testStaticPose("Madgwick (MARG)", madgwickMARG, true);
+    testStaticPose("Mahony", mahony, false);
+
+    testConstantRotation("Madgwick (IMU)", madgwickIMU);
+    testConstantRotation("Madgwick (MARG)", madgwickMARG);
+    testConstantRotation("Mahony", mahony);
+
+    // the frame must contain one sample per IMU
+    OrientationFilter filter(2, madgwickIMU);
+    vector<NGIMUData> frame(3);
+    try {
+        filter.update(frame);
+    } catch (exception&) { return; }
+    THROW_EXCEPTION("a frame of wrong size was accepted");
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
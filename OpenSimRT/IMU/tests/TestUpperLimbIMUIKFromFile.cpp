@@ -28,6 +28,7 @@
 #include "InverseKinematics.h"
 #include "NGIMUInputFromFileDriver.h"
 #include "OpenSimUtils.h"
+#include "PerformanceGate.h"
 #include "Settings.h"
 #include "Visualization.h"
 #include <Actuators/Schutte1993Muscle_Deprecated.h>
@@ -38,7 +39,7 @@ using namespace OpenSim;
 using namespace OpenSimRT;
 using namespace SimTK;
 
-void run() {
+void run(const PerformanceGate& gate) {
     INIReader ini(INI_FILE);
     auto section = "UPPER_LIMB_NGIMU_OFFLINE";
     // imu calibration settings
@@ -52,6 +53,8 @@ void run() {
 
     // driver send rate
     auto rate = ini.getInteger(section, "DRIVER_SEND_RATE", 0);
+    // replay as fast as possible for the performance gate
+    if (gate.isEnabled()) rate = 0;
 
     // subject data
     auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
@@ -97,6 +100,8 @@ void run() {
     // mean delay
     int sumDelayMS = 0;
     int numFrames = 0;
+    LatencyHistogram latencies;
+    auto start = monotonicNanoseconds();
 
     try { // main loop
         while (!driver.shouldTerminate()) {
@@ -115,9 +120,12 @@ void run() {
             t2 = chrono::high_resolution_clock::now();
             sumDelayMS += chrono::duration_cast<chrono::milliseconds>(t2 - t1)
                                   .count();
+            latencies.record(
+                    chrono::duration_cast<chrono::nanoseconds>(t2 - t1)
+                            .count());
 
-            // visualize
-            visualizer.update(pose.q);
+            // visualize (not part of the throughput of the performance gate)
+            if (!gate.isEnabled()) visualizer.update(pose.q);
 
             // record
             qLogger.appendRow(pose.t, ~pose.q);
@@ -128,7 +136,11 @@ void run() {
         driver.shouldTerminate(true);
     }
 
+    auto duration = (monotonicNanoseconds() - start) * 1e-9;
+
     cout << "Mean delay: " << (double) sumDelayMS / numFrames << " ms" << endl;
+    gate.submit(PerformanceReport::fromLatencies(
+            "TestUpperLimbIMUIKFromFile", latencies.getStatistics(), duration));
 
     // // store results
     // STOFileAdapter::write(
@@ -137,7 +149,9 @@ void run() {
 
 int main(int argc, char* argv[]) {
     try {
-        run();
+        PerformanceGate gate(argc, argv, INI_FILE, DATA_DIR,
+                             LIBRARY_OUTPUT_PATH);
+        run(gate);
     } catch (exception& e) {
         cout << e.what() << endl;
         return -1;
@@ -0,0 +1,401 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file BenchmarkSolvers.cpp
+ *
+ * \brief Microbenchmarks of the IK (markers with gait1992, IMUs with mobl2016),
+ * ID, SO and JR solvers and the generated moment arm function of gait1992.
+ * The inputs are prepared as in the corresponding tests (see setup.ini) and the
+ * solvers cycle through the recorded frames.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "AllocationCounter.h"
+#include "INIReader.h"
+#include "InverseDynamics.h"
+#include "InverseKinematics.h"
+#include "JointReaction.h"
+#include "MuscleOptimization.h"
+#include "OpenSimUtils.h"
+#include "Settings.h"
+#include "SignalProcessing.h"
+#include <Actuators/Schutte1993Muscle_Deprecated.h>
+#include <Actuators/Thelen2003Muscle.h>
+#include <OpenSim/Common/Storage.h>
+#include <OpenSim/Tools/IKTaskSet.h>
+
+using namespace std;
+using namespace OpenSim;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+/**
+ * Path of the generated moment arm library (see TestSOFromFile).
+ */
+static string getMomentArmLibraryPath(const INIReader& ini,
+                                      const string& section) {
+#ifndef WIN32
+    return LIBRARY_OUTPUT_PATH + "/" +
+           ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#else
+    return ini.getString(section, "MOMENT_ARM_LIBRARY", "");
+#endif
+}
+
+/*******************************************************************************/
+
+/**
+ * Filtered kinematics and ground reaction wrenches of gait1992, as the input of
+ * the ID and JR solvers.
+ */
+struct FilteredFrames {
+    vector<ExternalWrench::Parameters> wrenchParameters;
+    vector<InverseDynamics::Input> frames;
+    vector<int> rows; // row of the unfiltered table of each frame
+
+    FilteredFrames(const Model& model, const string& section) {
+        INIReader ini(INI_FILE);
+        auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+        auto grfMotFile =
+                subjectDir + ini.getString(section, "GRF_MOT_FILE", "");
+        auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+        auto memory = ini.getInteger(section, "MEMORY", 0);
+        auto cutoffFreq = ini.getReal(section, "CUTOFF_FREQ", 0);
+        auto delay = ini.getInteger(section, "DELAY", 0);
+        auto splineOrder = ini.getInteger(section, "SPLINE_ORDER", 0);
+
+        // external forces
+        Storage grfMotion(grfMotFile);
+        vector<vector<string>> labels;
+        for (const string side : {"RIGHT", "LEFT"}) {
+            wrenchParameters.push_back(
+                    {ini.getString(section,
+                                   "GRF_" + side + "_APPLY_TO_BODY", ""),
+                     ini.getString(section,
+                                   "GRF_" + side + "_FORCE_EXPRESSED_IN_BODY",
+                                   ""),
+                     ini.getString(section,
+                                   "GRF_" + side + "_POINT_EXPRESSED_IN_BODY",
+                                   "")});
+            labels.push_back(ExternalWrench::createGRFLabelsFromIdentifiers(
+                    ini.getString(section,
+                                  "GRF_" + side + "_POINT_IDENTIFIER", ""),
+                    ini.getString(section,
+                                  "GRF_" + side + "_FORCE_IDENTIFIER", ""),
+                    ini.getString(section,
+                                  "GRF_" + side + "_TORQUE_IDENTIFIER", "")));
+        }
+
+        // filters
+        auto qTable =
+                OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+                        model, ikFile, 0.01);
+        LowPassSmoothFilter::Parameters ikFilterParam;
+        ikFilterParam.numSignals = model.getNumCoordinates();
+        ikFilterParam.memory = memory;
+        ikFilterParam.delay = delay;
+        ikFilterParam.cutoffFrequency = cutoffFreq;
+        ikFilterParam.splineOrder = splineOrder;
+        ikFilterParam.calculateDerivatives = true;
+        LowPassSmoothFilter ikFilter(ikFilterParam);
+        LowPassSmoothFilter::Parameters grfFilterParam = ikFilterParam;
+        grfFilterParam.numSignals = 9;
+        grfFilterParam.calculateDerivatives = false;
+        LowPassSmoothFilter grfRightFilter(grfFilterParam),
+                grfLeftFilter(grfFilterParam);
+
+        for (int i = 0; i < qTable.getNumRows(); ++i) {
+            double t = qTable.getIndependentColumn()[i];
+            auto ikFiltered =
+                    ikFilter.filter({t, qTable.getRowAtIndex(i).getAsVector()});
+            vector<ExternalWrench::Input> wrenches;
+            bool isValid = ikFiltered.isValid;
+            for (int j = 0; j < 2; ++j) {
+                auto wrench = ExternalWrench::getWrenchFromStorage(
+                        t, labels[j], grfMotion);
+                auto filtered = (j == 0 ? grfRightFilter : grfLeftFilter)
+                                        .filter({t, wrench.toVector()});
+                wrench.fromVector(filtered.x);
+                wrenches.push_back(wrench);
+                isValid = isValid && filtered.isValid;
+            }
+            if (!isValid) continue;
+            frames.push_back({ikFiltered.t, ikFiltered.x, ikFiltered.xDot,
+                              ikFiltered.xDDot, wrenches});
+            rows.push_back(i - delay);
+        }
+    }
+};
+
+/*******************************************************************************/
+
+static void BM_InverseKinematicsMarkers(benchmark::State& state) {
+    struct Fixture {
+        vector<InverseKinematics::Input> frames;
+        unique_ptr<InverseKinematics> ik;
+        Fixture() {
+            INIReader ini(INI_FILE);
+            auto section = "TEST_IK_FROM_FILE";
+            auto subjectDir =
+                    DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+            auto modelFile =
+                    subjectDir + ini.getString(section, "MODEL_FILE", "");
+            auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+            auto ikTaskSetFile =
+                    subjectDir + ini.getString(section, "IK_TASK_SET_FILE", "");
+
+            Model model(modelFile);
+            OpenSimUtils::removeActuators(model);
+            IKTaskSet ikTaskSet(ikTaskSetFile);
+            MarkerData markerData(trcFile);
+            vector<InverseKinematics::MarkerTask> markerTasks;
+            vector<string> observationOrder;
+            InverseKinematics::createMarkerTasksFromIKTaskSet(
+                    model, ikTaskSet, markerTasks, observationOrder);
+            ik = make_unique<InverseKinematics>(
+                    model, markerTasks, vector<InverseKinematics::IMUTask>{},
+                    SimTK::Infinity, 1e-5);
+            for (int i = 0; i < markerData.getNumFrames(); ++i)
+                frames.push_back(InverseKinematics::getFrameFromMarkerData(
+                        i, markerData, observationOrder, false));
+        }
+    };
+    static Fixture fixture;
+
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto pose = fixture.ik->solve(fixture.frames[i]);
+        benchmark::DoNotOptimize(pose);
+        if (++i == fixture.frames.size()) i = 0;
+    }
+}
+BENCHMARK(BM_InverseKinematicsMarkers)->Unit(benchmark::kMicrosecond);
+
+static void BM_InverseKinematicsIMU(benchmark::State& state) {
+    struct Fixture {
+        vector<InverseKinematics::Input> frames;
+        unique_ptr<InverseKinematics> ik;
+        Fixture() {
+            INIReader ini(INI_FILE);
+            auto section = "TEST_IK_IMU_FROM_FILE";
+            auto subjectDir =
+                    DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+            auto modelFile =
+                    subjectDir + ini.getString(section, "MODEL_FILE", "");
+            auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+
+            Object::RegisterType(Schutte1993Muscle_Deprecated());
+            Model model(modelFile);
+            OpenSimUtils::removeActuators(model);
+            MarkerData markerData(trcFile);
+            vector<InverseKinematics::IMUTask> imuTasks;
+            vector<string> observationOrder;
+            InverseKinematics::createIMUTasksFromMarkerData(
+                    model, markerData, imuTasks, observationOrder);
+            ik = make_unique<InverseKinematics>(
+                    model, vector<InverseKinematics::MarkerTask>{}, imuTasks,
+                    SimTK::Infinity, 1e-5);
+            for (int i = 0; i < markerData.getNumFrames(); ++i)
+                frames.push_back(InverseKinematics::getFrameFromMarkerData(
+                        i, markerData, observationOrder, true));
+        }
+    };
+    static Fixture fixture;
+
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto pose = fixture.ik->solve(fixture.frames[i]);
+        benchmark::DoNotOptimize(pose);
+        if (++i == fixture.frames.size()) i = 0;
+    }
+}
+BENCHMARK(BM_InverseKinematicsIMU)->Unit(benchmark::kMicrosecond);
+
+static void BM_InverseDynamics(benchmark::State& state) {
+    struct Fixture {
+        unique_ptr<FilteredFrames> data;
+        unique_ptr<InverseDynamics> id;
+        Fixture() {
+            INIReader ini(INI_FILE);
+            auto section = "TEST_ID_FROM_FILE";
+            auto modelFile = DATA_DIR +
+                             ini.getString(section, "SUBJECT_DIR", "") +
+                             ini.getString(section, "MODEL_FILE", "");
+            Object::RegisterType(Thelen2003Muscle());
+            Model model(modelFile);
+            OpenSimUtils::removeActuators(model);
+            model.initSystem();
+            data = make_unique<FilteredFrames>(model, section);
+            id = make_unique<InverseDynamics>(model, data->wrenchParameters);
+        }
+    };
+    static Fixture fixture;
+
+    const auto& frames = fixture.data->frames;
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto output = fixture.id->solve(frames[i]);
+        benchmark::DoNotOptimize(output);
+        if (++i == frames.size()) i = 0;
+    }
+}
+BENCHMARK(BM_InverseDynamics)->Unit(benchmark::kMicrosecond);
+
+static void BM_MuscleOptimization(benchmark::State& state) {
+    struct Fixture {
+        vector<MuscleOptimization::Input> frames;
+        unique_ptr<MuscleOptimization> so;
+        Fixture() {
+            INIReader ini(INI_FILE);
+            auto section = "TEST_SO_FROM_FILE";
+            auto subjectDir =
+                    DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+            auto modelFile =
+                    subjectDir + ini.getString(section, "MODEL_FILE", "");
+            auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+            auto idFile = subjectDir + ini.getString(section, "ID_FILE", "");
+
+            Object::RegisterType(Thelen2003Muscle());
+            Model model(modelFile);
+            model.initSystem();
+            auto calcMomentArm = OpenSimUtils::getMomentArmFromDynamicLibrary(
+                    model, getMomentArmLibraryPath(ini, section));
+
+            MuscleOptimization::OptimizationParameters parameters;
+            parameters.convergenceTolerance =
+                    ini.getReal(section, "CONVERGENCE_TOLERANCE", 0);
+            parameters.memoryHistory =
+                    ini.getReal(section, "MEMORY_HISTORY", 0);
+            parameters.maximumIterations =
+                    ini.getInteger(section, "MAXIMUM_ITERATIONS", 0);
+            parameters.objectiveExponent =
+                    ini.getInteger(section, "OBJECTIVE_EXPONENT", 0);
+            so = make_unique<MuscleOptimization>(model, parameters,
+                                                 calcMomentArm);
+
+            auto qTable =
+                    OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+                            model, ikFile, 0.01);
+            auto tauTable =
+                    OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+                            model, idFile, 0.01);
+            for (int i = 0; i < qTable.getNumRows(); ++i)
+                frames.push_back(
+                        {qTable.getIndependentColumn()[i],
+                         qTable.getRowAtIndex(i).getAsVector(),
+                         tauTable.getRowAtIndex(i).getAsVector()});
+        }
+    };
+    static Fixture fixture;
+
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto output = fixture.so->solve(fixture.frames[i]);
+        benchmark::DoNotOptimize(output);
+        if (++i == fixture.frames.size()) i = 0;
+    }
+}
+BENCHMARK(BM_MuscleOptimization)->Unit(benchmark::kMicrosecond);
+
+static void BM_JointReaction(benchmark::State& state) {
+    struct Fixture {
+        vector<JointReaction::Input> frames;
+        unique_ptr<JointReaction> jr;
+        Fixture() {
+            INIReader ini(INI_FILE);
+            auto section = "TEST_JR_FROM_FILE";
+            auto subjectDir =
+                    DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+            auto modelFile =
+                    subjectDir + ini.getString(section, "MODEL_FILE", "");
+            auto soFile = subjectDir + ini.getString(section, "SO_FILE", "");
+
+            Object::RegisterType(Thelen2003Muscle());
+            Model model(modelFile);
+            model.initSystem();
+            FilteredFrames data(model, section);
+            jr = make_unique<JointReaction>(model, data.wrenchParameters);
+
+            // muscle forces aligned with the delay of the filter
+            Storage soFm(soFile);
+            soFm.resampleLinear(0.01);
+            const int numMuscles = model.getMuscles().getSize();
+            for (int i = 0; i < data.frames.size(); ++i) {
+                const auto& frame = data.frames[i];
+                auto fm = soFm.getStateVector(data.rows[i]);
+                frames.push_back({frame.t, frame.q, frame.qDot,
+                                  Vector(numMuscles, &fm->getData()[0]),
+                                  frame.externalWrenches});
+            }
+        }
+    };
+    static Fixture fixture;
+
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto output = fixture.jr->solve(fixture.frames[i]);
+        benchmark::DoNotOptimize(output);
+        if (++i == fixture.frames.size()) i = 0;
+    }
+}
+BENCHMARK(BM_JointReaction)->Unit(benchmark::kMicrosecond);
+
+static void BM_CalcMomentArm(benchmark::State& state) {
+    struct Fixture {
+        vector<Vector> frames;
+        MomentArmFunctionT calcMomentArm;
+        Fixture() {
+            INIReader ini(INI_FILE);
+            auto section = "TEST_SO_FROM_FILE";
+            auto subjectDir =
+                    DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+            auto modelFile =
+                    subjectDir + ini.getString(section, "MODEL_FILE", "");
+            auto ikFile = subjectDir + ini.getString(section, "IK_FILE", "");
+
+            Object::RegisterType(Thelen2003Muscle());
+            Model model(modelFile);
+            model.initSystem();
+            calcMomentArm = OpenSimUtils::getMomentArmFromDynamicLibrary(
+                    model, getMomentArmLibraryPath(ini, section));
+            auto qTable =
+                    OpenSimUtils::getMultibodyTreeOrderedCoordinatesFromStorage(
+                            model, ikFile, 0.01);
+            for (int i = 0; i < qTable.getNumRows(); ++i)
+                frames.push_back(qTable.getRowAtIndex(i).getAsVector());
+        }
+    };
+    static Fixture fixture;
+
+    int i = 0;
+    AllocationCounter allocations(state);
+    for (auto _ : state) {
+        auto R = fixture.calcMomentArm(fixture.frames[i]);
+        benchmark::DoNotOptimize(R);
+        if (++i == fixture.frames.size()) i = 0;
+    }
+}
+BENCHMARK(BM_CalcMomentArm);
+
+BENCHMARK_MAIN();
@@ -27,13 +27,15 @@
 
 #include "InverseDynamics.h"
 #include "internal/RealTimeExports.h"
+#include <OpenSim/Simulation/Model/Actuator.h>
 #include <OpenSim/Simulation/Model/Model.h>
 
 namespace OpenSimRT {
 
 /**
  * \brief Calculates the joint reaction loads as applied on child bodies
- * expressed in ground.
+ * expressed in ground. Reversed joints (where the child is the inboard body of
+ * the mobilizer) are supported.
  *
  * TODO: implement re-express in different frame of interest
  */
@@ -59,9 +61,15 @@ class RealTime_API JointReaction {
     /**
      * Transform the joint reactions into a Vector arranged as
      * [force[0], moment[0], point[0], ..., force[n - 1], moment[n -
-     * 1], point[n - 1]].
+     * 1], point[n - 1]]. The points are evaluated at the state of the last
+     * solve(), thus jrOutput must be the result of the last solve().
      */
     SimTK::Vector asForceMomentPoint(const Output& jrOutput);
+    /**
+     * Same as above, but writes into a caller-provided vector (resized only
+     * if its size differs), avoiding the allocation in real-time loops.
+     */
+    void asForceMomentPoint(const Output& jrOutput, SimTK::Vector& out);
     /**
      * Initialize inverse dynamics log storage. Use this to create a
      * TimeSeriesTable that can be appended with the computed generalized
@@ -73,6 +81,13 @@ class RealTime_API JointReaction {
     OpenSim::Model model;
     SimTK::State state;
     std::vector<ExternalWrench*> externalWrenches;
+    // muscles (in the order of the muscle forces) with overridden actuation
+    std::vector<const OpenSim::ScalarActuator*> muscleActuators;
+    int numActuators;
+    // outboard mobilized body of the mobilizer of each joint (the child, or
+    // the parent if the joint is reversed)
+    std::vector<SimTK::MobilizedBodyIndex> jointMobilizedBodies;
+    std::vector<bool> reversedJoints;
 };
 
 } // namespace OpenSimRT
@@ -27,16 +27,23 @@
  */
 #pragma once
 
+#include "BoundedQueue.h"
 #include "CircularBuffer.h"
 #include "InverseDynamics.h"
 #include "InverseKinematics.h"
 #include "JointReaction.h"
+#include "Measure.h"
 #include "MuscleOptimization.h"
 #include "OpenSimUtils.h"
 #include "RealTimeAnalysis.h"
 #include "SignalProcessing.h"
+#include "TripleBuffer.h"
 #include "internal/RealTimeExports.h"
+#include <array>
 #include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
 
 namespace OpenSimRT {
 /**
@@ -51,7 +58,12 @@ struct RealTime_API MotionCaptureInput {
 /**
  * @brief A higher order function that is an interface between the motion
  * capture system and the InverseKinematics input. Termination of the
- * acquisition should be handled by throwing an exception.
+ * acquisition should be handled by throwing an exception. The function may
+ * return the previous frame when no new data are available; the acquisition
+ * thread then sleeps until RealTimeAnalysis::notifyDataAvailable() is called or
+ * the acquisition idle timeout elapses. The producer of the data should call
+ * notifyDataAvailable() (e.g., through the setDataAvailableCallback of the IMU
+ * drivers and the ViconDataStream), since the timeout is only a safety net.
  */
 typedef std::function<MotionCaptureInput()> DataAcquisitionFunction;
 
@@ -62,12 +74,58 @@ typedef std::function<MotionCaptureInput()> DataAcquisitionFunction;
  */
 class RealTime_API RealTimeAnalysis {
  public:
+    /**
+     * Select how the results are passed from the processing thread to the
+     * consumer of getResults(). There is a single consumer: the results must
+     * be fetched (getResults() and tryGetResults()) by one thread, else an
+     * exception is thrown.
+     *
+     * - LATEST_ONLY keeps only the newest result (triple buffer). The
+     * processing thread never waits, but results that are not fetched in time
+     * are lost.
+     *
+     * - DROP_OLDEST keeps the newest results in a bounded queue. The
+     * processing thread never waits and the oldest results are discarded when
+     * the queue is full.
+     *
+     * - BLOCKING keeps the results in a bounded queue and the processing
+     * thread waits when the queue is full (backpressure), thus no result is
+     * lost (e.g., for logging every frame).
+     */
+    enum class ResultPolicy { LATEST_ONLY, DROP_OLDEST, BLOCKING };
+
+    /**
+     * Stages whose latency is measured when the project is configured with
+     * ENABLE_LATENCY_INSTRUMENTATION. The latency of a stage is the time from
+     * the completion of the previous stage, thus the ID latency includes the
+     * wait in the buffer between the threads, and TOTAL spans from the
+     * acquisition of a frame to the publication of its result (the delay of
+     * the filter in samples is not included).
+     */
+    enum class LatencyStage { IK, FILTER, ID, SO, JR, PUBLICATION, TOTAL };
+    static constexpr int numLatencyStages = 7;
+
+    /**
+     * Monotonic completion timestamps (ns) of the stages of a frame (zero if
+     * not measured).
+     */
+    struct FrameTimestamps {
+        std::int64_t acquisition = 0;
+        std::int64_t ik = 0;
+        std::int64_t filter = 0;
+        std::int64_t id = 0;
+        std::int64_t so = 0;
+        std::int64_t jr = 0;
+        std::int64_t publication = 0;
+    };
+
     struct FilteredData {
         double t;
         SimTK::Vector q;
         SimTK::Vector qd;
         SimTK::Vector qdd;
         std::vector<ExternalWrench::Input> externalWrenches;
+        FrameTimestamps timestamps; // latency instrumentation
 
         /**
          * Assigns the struct fields of FilteredData from SimTK::Vectors. The
@@ -105,6 +163,16 @@ class RealTime_API RealTimeAnalysis {
     struct Parameters {
         // acquisition function
         DataAcquisitionFunction dataAcquisitionFunction;
+        // max sleep (in seconds) when the acquisition function has no new data
+        // and the producer does not call notifyDataAvailable() (safety net)
+        double acquisitionIdleTimeout = 0.1;
+
+        // result channel to the consumer of getResults()
+        ResultPolicy resultPolicy = ResultPolicy::LATEST_ONLY;
+        int resultQueueCapacity = 64; // DROP_OLDEST and BLOCKING
+
+        // period (in seconds) of printing the latency statistics (0 disables)
+        double latencyReportPeriod = 0;
 
         // lp smooth filter parameters
         LowPassSmoothFilter::Parameters filterParameters;
@@ -124,6 +192,35 @@ class RealTime_API RealTimeAnalysis {
         MomentArmFunctionT momentArmFunction;
     };
 
+    /**
+     * Counters of the acquisition thread. An idle wait occurs when the
+     * acquisition function returns a frame that has already been processed. A
+     * skipped frame is acquired but yields no result (e.g., while the filter
+     * is initialized), thus every other acquired frame is eventually published.
+     */
+    struct AcquisitionStatistics {
+        long long frames;
+        long long idleWaits;
+        long long skippedFrames;
+    };
+
+    /**
+     * Counters of the result publication. An overwrite occurs when a result is
+     * replaced (LATEST_ONLY) or discarded (DROP_OLDEST) before it has been
+     * fetched, and a stale read when a fetch returns without a new result
+     * (e.g., tryGetResults() on an empty channel or termination). A producer
+     * wait occurs when the processing thread waits for the consumer
+     * (BLOCKING). The queue size is the high watermark of the queued results
+     * (at most one with LATEST_ONLY, zero if nothing was published).
+     */
+    struct PublicationStatistics {
+        long long published;
+        long long overwrites;
+        long long staleReads;
+        long long producerWaits;
+        int maxQueueSize;
+    };
+
     struct Loggers {
         // ik
         OpenSim::TimeSeriesTable qLogger;
@@ -166,10 +263,59 @@ class RealTime_API RealTimeAnalysis {
     void shouldTerminate(bool flag);
 
     /**
-     * Thread safe fetch function of analysis results.
+     * Thread safe fetch function of analysis results. Blocks until the
+     * processing thread publishes a new result (the newest one with
+     * LATEST_ONLY, else the oldest queued one) or terminates, in which case the
+     * previous result is returned. The result is copied outside the lock, thus
+     * the processing thread only waits for the caller with BLOCKING.
      */
     Output getResults();
 
+    /**
+     * Same as getResults(), but swaps the content of the latest result with
+     * `output`, so that the buffers of the caller are reused by the processing
+     * thread instead of copying the result. If no new result has been
+     * published, `output` is left unchanged.
+     */
+    void getResults(Output& output);
+
+    /**
+     * Non-blocking version of getResults(Output&). Returns false (`output` is
+     * unchanged) if no new result is available. For instance, a logging
+     * consumer can drain every queued result, while a visualizer keeps the
+     * last one.
+     */
+    bool tryGetResults(Output& output);
+
+    /**
+     * Notify the acquisition thread that new data are available (e.g., called
+     * by the producer of the motion capture data), thus it does not wait for
+     * the idle timeout. Thread safe.
+     */
+    void notifyDataAvailable();
+
+    /**
+     * Thread safe access to the acquisition counters.
+     */
+    AcquisitionStatistics getAcquisitionStatistics() const;
+
+    /**
+     * Thread safe access to the result publication counters.
+     */
+    PublicationStatistics getPublicationStatistics() const;
+
+    /**
+     * Latency statistics (in ns) of a stage, recorded by the processing
+     * thread. Empty if the project is not configured with
+     * ENABLE_LATENCY_INSTRUMENTATION.
+     */
+    LatencyHistogram::Statistics getLatencyStatistics(LatencyStage stage) const;
+
+    /**
+     * Print the latency statistics of all stages (in us).
+     */
+    void printLatencyStatistics(std::ostream& stream) const;
+
     /**
      * Initialize module loggers.
      */
@@ -188,6 +334,37 @@ class RealTime_API RealTimeAnalysis {
      */
     virtual void processing();
 
+    /**
+     * Block the acquisition thread until new data are notified, termination is
+     * requested or the acquisition idle timeout elapses. Called when the
+     * acquisition function has no new data, instead of polling it again.
+     */
+    void waitForData();
+
+    /**
+     * Publish the result written in results.write() through the selected
+     * result channel and notify the consumer (processing thread only).
+     */
+    void publishResults();
+
+    /**
+     * Register the calling thread as the consumer of the results on the first
+     * call. Throws if the results are fetched by another thread.
+     */
+    void checkConsumer();
+
+    /**
+     * Wake up and release the consumer and the processing thread that may wait
+     * on the result channel (on termination).
+     */
+    void closeResults();
+
+    /**
+     * Record the latencies of a processed frame in the histograms and print
+     * them periodically (processing thread only).
+     */
+    void recordLatencies(const FrameTimestamps& timestamps);
+
     /**
      * Prepare the input data for filtering.
      */
@@ -196,9 +373,9 @@ class RealTime_API RealTimeAnalysis {
             const std::vector<ExternalWrench::Input>& externalWrenches) const;
 
     OpenSim::Model model;
-    Parameters parameters; // RealTimeAnalysis parameters
-    Loggers log;           // loggers
-    Output output;         // analysis results
+    Parameters parameters;        // RealTimeAnalysis parameters
+    Loggers log;                  // loggers
+    TripleBuffer<Output> results; // analysis results
     double previousAcquisitionTime;
     double previousProcessingTime;
 
@@ -209,8 +386,18 @@ class RealTime_API RealTimeAnalysis {
     SimTK::ReferencePtr<MuscleOptimization> muscleOptimization;
     SimTK::ReferencePtr<JointReaction> jointReaction;
 
-    // data buffer
-    CircularBuffer<1, LowPassSmoothFilter::Output> buffer;
+    // data buffer (filter output and timestamps of a frame)
+    struct BufferedFrame {
+        LowPassSmoothFilter::Output filtered;
+        FrameTimestamps timestamps;
+    };
+    CircularBuffer<1, BufferedFrame> buffer;
+
+    // result queue (DROP_OLDEST and BLOCKING) and the last result fetched by
+    // getResults()
+    std::unique_ptr<BoundedQueue<Output>> resultQueue;
+    Output lastResult;
+    std::atomic<std::thread::id> consumerThread;
 
     // termination flag
     std::atomic_bool terminationFlag;
@@ -219,5 +406,15 @@ class RealTime_API RealTimeAnalysis {
     std::mutex mu;
     std::condition_variable cond;
     std::atomic_bool notifyParentThread;
+
+    // acquisition readiness notification and counters
+    std::mutex dataMutex;
+    std::condition_variable dataCond;
+    bool dataAvailable;
+    std::atomic<long long> acquiredFrames, idleWaits, skippedFrames;
+
+    // latency histograms of the stages
+    std::array<LatencyHistogram, numLatencyStages> latencies;
+    std::int64_t lastLatencyReport;
 };
 } // namespace OpenSimRT
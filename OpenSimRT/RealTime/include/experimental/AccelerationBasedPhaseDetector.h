@@ -28,10 +28,14 @@
 
 #include "GRFMPrediction.h"
 #include "GaitPhaseDetector.h"
+#include "ModelStateContext.h"
+#include "OpenSimUtils.h"
 #include "SignalProcessing.h"
 #include <SimTKcommon.h>
 #include <Simulation/Model/Model.h>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace OpenSimRT {
 
@@ -42,6 +46,22 @@ namespace OpenSimRT {
  */
 class RealTime_API AccelerationBasedPhaseDetector : public GaitPhaseDetector {
  public:
+    /**
+     * Estimation of the foot accelerations.
+     *
+     * - FILTERED_DIFFERENTIATION computes the station positions in a copy of
+     * the model and differentiates them twice numerically, low-pass filtering
+     * the position, velocity and acceleration.
+     *
+     * - STATION_JACOBIAN computes the station accelerations from the input
+     * (already filtered) q, qDot and qDDot as JS * qDDot + JSDot * qDot, using
+     * the station Jacobian and its bias term. No additional filtering, thus no
+     * additional delay, is introduced and the filter parameters are ignored.
+     * The model is not copied, thus it must have an initialized system and
+     * outlive the detector.
+     */
+    enum class Method { FILTERED_DIFFERENTIATION, STATION_JACOBIAN };
+
     struct Parameters {
         int windowSize;          // windowSize to determine HS/TO events
         double heelAccThreshold; // threshold at heel point
@@ -66,22 +86,72 @@ class RealTime_API AccelerationBasedPhaseDetector : public GaitPhaseDetector {
         // order of differentiators
         int posDiffOrder; // position differentiator order
         int velDiffOrder; // velocity differentiator order
+
+        Method method = Method::FILTERED_DIFFERENTIATION;
     };
 
     // ctor
     AccelerationBasedPhaseDetector(const OpenSim::Model& otherModel,
                                    const Parameters& parameters);
 
+    /**
+     * Construct on a model state context that is shared with other modules.
+     * The context is not updated by updDetector(), thus its owner must update
+     * it with the kinematics of each frame before updating the detector.
+     */
+    AccelerationBasedPhaseDetector(std::shared_ptr<ModelStateContext> context,
+                                   const Parameters& parameters);
+
     /**
      * Update detector using the kinematic data.
      */
     void updDetector(const GRFMPrediction::Input& input);
 
+    /**
+     * Accelerations of the R/L heel and R/L toe stations (in this order) of
+     * the last update.
+     */
+    const SimTK::Vector_<SimTK::Vec3>& getStationAccelerations() const;
+
  private:
-    OpenSim::Model model;
+    /**
+     * Update the accelerations of the R/L heel and R/L toe stations (in this
+     * order), estimated based on the selected method.
+     */
+    void updStationAccelerations(const GRFMPrediction::Input& input);
+
+    /**
+     * Common initialization of the constructors.
+     */
+    void initialize();
+
+    /**
+     * The state of the detector or of the shared context.
+     */
+    const SimTK::State& getKinematicState() const;
+
+    // copy of the model (FILTERED_DIFFERENTIATION)
+    std::unique_ptr<OpenSim::Model> stationModel;
+    // the model whose kinematics are used (the copy, the original model for
+    // STATION_JACOBIAN, or the model of the shared context)
+    SimTK::ReferencePtr<const OpenSim::Model> kinematicModel;
+    // shared model and state (optional)
+    std::shared_ptr<ModelStateContext> context;
     SimTK::State state;
+    OpenSimUtils::StateIndices stateIndices;
     Parameters parameters;
 
+    // foot stations (R/L heel and R/L toe)
+    SimTK::Array_<SimTK::MobilizedBodyIndex> stationBodies;
+    SimTK::Array_<SimTK::Vec3> stationLocations;
+
+    // workspace of the station Jacobian (STATION_JACOBIAN)
+    SimTK::Vector uDot;
+    SimTK::Vector_<SimTK::Vec3> bias;
+
+    // R/L heel and R/L toe station accelerations
+    SimTK::Vector_<SimTK::Vec3> accelerations;
+
     // buffers with size = consecutive values. Hold values for both heel and
     // toe that indicate when the acceleration exceeds the threshold.
     SlidingWindow<SimTK::Vec2> rSlidingWindow;
@@ -95,11 +165,5 @@ class RealTime_API AccelerationBasedPhaseDetector : public GaitPhaseDetector {
     // differentiators
     SimTK::ReferencePtr<NumericalDifferentiator> posDiff;
     SimTK::ReferencePtr<NumericalDifferentiator> velDiff;
-
-    // attached station points to foot
-    SimTK::ReferencePtr<OpenSim::Station> heelStationR;
-    SimTK::ReferencePtr<OpenSim::Station> heelStationL;
-    SimTK::ReferencePtr<OpenSim::Station> toeStationR;
-    SimTK::ReferencePtr<OpenSim::Station> toeStationL;
 };
 } // namespace OpenSimRT
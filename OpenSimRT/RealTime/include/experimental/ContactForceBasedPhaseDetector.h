@@ -27,8 +27,11 @@
 #pragma once
 
 #include "GaitPhaseDetector.h"
+#include "ModelStateContext.h"
+#include "OpenSimUtils.h"
 #include <OpenSim/Simulation/Model/HuntCrossleyForce.h>
 #include <OpenSim/Simulation/Model/Model.h>
+#include <memory>
 #include <string>
 
 namespace OpenSimRT {
@@ -42,6 +45,21 @@ namespace OpenSimRT {
  */
 class RealTime_API ContactForceBasedPhaseDetector : public GaitPhaseDetector {
  public:
+    /**
+     * Computation of the contact forces.
+     *
+     * - CONTACT_MODEL adds the contact geometries (half-space and spheres) and
+     * Hunt-Crossley forces to a copy of the model, and realizes the dynamics
+     * of the copy on each update.
+     *
+     * - GEOMETRIC evaluates the same Hunt-Crossley contact model in closed
+     * form, from the penetration of the spheres into the plane and the
+     * velocity of the feet. Only the position and velocity kinematics of the
+     * given model are realized. The model is not copied, thus it must have an
+     * initialized system and outlive the detector.
+     */
+    enum class Method { CONTACT_MODEL, GEOMETRIC };
+
     struct Parameters {
         int windowSize;           // windowSize to determine HS/TO events
         double threshold;         // force threshold
@@ -55,22 +73,55 @@ class RealTime_API ContactForceBasedPhaseDetector : public GaitPhaseDetector {
         SimTK::Vec3 lToeSphereLocation;
         std::string rFootBodyName;
         std::string lFootBodyName;
+
+        Method method = Method::CONTACT_MODEL;
     };
     // ctor
     ContactForceBasedPhaseDetector(const OpenSim::Model&,
                                    const Parameters& parameters);
+
+    /**
+     * Construct on a model state context that is shared with other modules
+     * (GEOMETRIC method only). The context is not updated by updDetector(),
+     * thus its owner must update it with the kinematics of each frame before
+     * updating the detector.
+     */
+    ContactForceBasedPhaseDetector(std::shared_ptr<ModelStateContext> context,
+                                   const Parameters& parameters);
     /**
      * Update detector using the kinematic data.
      */
     void updDetector(const GRFMPrediction::Input& input);
 
  private:
+    /**
+     * Total contact force applied by the plane on the heel and toe spheres of
+     * a foot (GEOMETRIC method).
+     */
+    SimTK::Vec3 calcContactForce(const SimTK::State& state,
+                                 const SimTK::MobilizedBodyIndex& foot,
+                                 const SimTK::Vec3& heelLocation,
+                                 const SimTK::Vec3& toeLocation) const;
+
+    /**
+     * Refer to the kinematics of the model (GEOMETRIC method).
+     */
+    void setKinematicModel(const OpenSim::Model& model);
+
     // contact force elements added to a copy of the original model
+    // (CONTACT_MODEL method)
+    std::unique_ptr<OpenSim::Model> contactModel;
     SimTK::ReferencePtr<OpenSim::HuntCrossleyForce> rightContactForce;
     SimTK::ReferencePtr<OpenSim::HuntCrossleyForce> leftContactForce;
 
-    OpenSim::Model model;
+    // the original model and the feet (GEOMETRIC method)
+    SimTK::ReferencePtr<const OpenSim::Model> kinematicModel;
+    SimTK::MobilizedBodyIndex rFoot, lFoot;
+    // shared model and state (GEOMETRIC method, optional)
+    std::shared_ptr<ModelStateContext> context;
+
     SimTK::State state;
+    OpenSimUtils::StateIndices stateIndices;
     Parameters parameters;
 };
 } // namespace OpenSimRT
@@ -28,10 +28,12 @@
 
 #include "Exception.h"
 #include "InverseDynamics.h"
+#include "ModelStateContext.h"
 #include "SlidingWindow.h"
 #include "internal/RealTimeExports.h"
 #include <OpenSim/Simulation/Model/Model.h>
 #include <SimTKcommon.h>
+#include <memory>
 
 namespace OpenSimRT {
 
@@ -101,6 +103,14 @@ class RealTime_API GRFMPrediction {
     GRFMPrediction(const OpenSim::Model&, const Parameters&,
                    GaitPhaseDetector*); // ctor
 
+    /**
+     * Construct on a model state context that is shared with other modules.
+     * The context is not updated by solve(), thus its owner must update it
+     * with the kinematics of each frame before calling solve().
+     */
+    GRFMPrediction(std::shared_ptr<ModelStateContext>, const Parameters&,
+                   GaitPhaseDetector*);
+
     /**
      * Select the name of the method used to compute the total reaction loads
      * F_ext and M_ext. Computation is performed using either the Newton-Euler
@@ -128,19 +138,29 @@ class RealTime_API GRFMPrediction {
     // gait direction based on the average direction of the pelvis anterior axis
     SlidingWindow<SimTK::Vec3> gaitDirectionBuffer;
 
-    OpenSim::Model model;
-    SimTK::State state;
+    // model and state (own or shared with other modules)
+    std::shared_ptr<ModelStateContext> context;
+    bool sharedContext;
     Parameters parameters;
 
     // gait phase detection
     SimTK::ReferencePtr<GaitPhaseDetector> gaitPhaseDetector;
     GaitPhaseState::GaitPhase gaitphase; // gait phase during simulation
 
-    // station points forming the cop trajectory
-    SimTK::ReferencePtr<OpenSim::Station> heelStationR;
-    SimTK::ReferencePtr<OpenSim::Station> heelStationL;
-    SimTK::ReferencePtr<OpenSim::Station> toeStationR;
-    SimTK::ReferencePtr<OpenSim::Station> toeStationL;
+    // feet of the station points forming the cop trajectory
+    SimTK::MobilizedBodyIndex rStationBody, lStationBody;
+
+    /**
+     * Common initialization of the constructors.
+     */
+    void initialize();
+
+    /**
+     * Location of a station point on a foot in ground.
+     */
+    SimTK::Vec3
+    getStationLocationInGround(const SimTK::MobilizedBodyIndex& body,
+                               const SimTK::Vec3& location) const;
 
     /**
      * Compute the rotation matrix required to transform the estimated total
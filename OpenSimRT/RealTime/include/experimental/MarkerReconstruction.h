@@ -41,15 +41,33 @@ namespace OpenSimRT {
  * Modified implementation of Aristidou et.al.
  * "Real-time estimation of missing markers in human motion capture".
  * https://ieeexplore.ieee.org/abstract/document/4535545
+ *
+ * Markers are grouped per body segment and referred to by their index in the
+ * observation order. The neighbors of each marker (markers in the same body,
+ * sorted by their distance in the model) are determined at construction, thus
+ * no lookups or sorting are performed when solving.
  */
 class RealTime_API MarkerReconstruction {
  public:
+    /**
+     * Reconstruction method.
+     *
+     * - CLOSEST_MARKERS reconstructs each missing marker independently from
+     * (up to) the three closest valid markers of its body.
+     *
+     * - RIGID_BODY fits a single rigid transformation (Kabsch) to all valid
+     * markers of a body and fills all missing markers of the body with it.
+     * Bodies with less than three valid markers fall back to CLOSEST_MARKERS.
+     */
+    enum class Method { CLOSEST_MARKERS, RIGID_BODY };
+
     /**
      * Construct the Missing Marker Module.
      */
     MarkerReconstruction(
             const OpenSim::Model& model,
-            const std::vector<InverseKinematics::MarkerTask>& markerTasks);
+            const std::vector<InverseKinematics::MarkerTask>& markerTasks,
+            const Method& method = Method::CLOSEST_MARKERS);
 
     /**
      * Initialize internal state. Returns true if it's initialized when input is
@@ -75,11 +93,6 @@ class RealTime_API MarkerReconstruction {
     OpenSim::TimeSeriesTable_<SimTK::Vec3> initializeLogger();
 
  private:
-    // A table alias that keeps track of the distances among markers in the same
-    // body based on their location defined in the osim model.
-    typedef std::map<std::string, std::map<std::string, SimTK::Vec3>>
-            DistanceTable;
-
     // circle representation
     struct Circle {
         double radius;
@@ -99,31 +112,58 @@ class RealTime_API MarkerReconstruction {
     bool isValidFrame(const SimTK::Array_<SimTK::Vec3>& markerObservations);
 
     /**
-     *  Find intersection of two spheres, i.e. a circle in the 3D space.
+     * Find intersection of two spheres, i.e. a circle in the 3D space. Returns
+     * false if the spheres do not intersect.
      */
-    Circle* sphereSphereIntersection(const Sphere& c1, const Sphere& c2);
+    bool sphereSphereIntersection(const Sphere& c1, const Sphere& c2,
+                                  Circle& circle);
 
     /**
      * Given a point, find its closest point in the circumference of a
      * given circle lying in the 3D space.
      */
-    SimTK::Vec3 closestPointToCircle(const SimTK::Vec3& vec, const Circle* c);
+    SimTK::Vec3 closestPointToCircle(const SimTK::Vec3& vec, const Circle& c);
 
     /**
      * Find the closests N markers (indexes) to the missing marker.
      *
-     * @param [mMarkerName]: name of the missing marker
+     * @param [i]: index of the missing marker
      * @param [currentObservations] - Array with positions of the markers in
      * current frame.
      * @param [numMarkers] - N closest markers
-     *
-     * @return [id1] - reference to the index of the closest marker.
-     * @return [id2] - reference to the index of the second closest marker.
+     * @param [indices] - indices of the closest valid markers, sorted by
+     * distance.
      */
-    std::vector<int>
-    findClosestMarkers(const std::string& mMarkerName,
+    void
+    findClosestMarkers(const int& i,
                        const SimTK::Array_<SimTK::Vec3>& currentObservations,
-                       int numMarkers);
+                       int numMarkers, std::vector<int>& indices);
+
+    /**
+     * Find the rigid transformation (rotation R and translation t) that best
+     * transforms the given markers from the previous to the current frame,
+     * using the SVD of their cross-covariance matrix (Kabsch algorithm).
+     */
+    void
+    fitRigidTransform(const SimTK::Array_<SimTK::Vec3>& currentObservations,
+                      const std::vector<int>& indices, SimTK::Mat33& R,
+                      SimTK::Vec3& t);
+
+    /**
+     * Reconstruct a missing marker from its closest markers, dispatching the
+     * reconstruction method on the number of valid markers in the same body.
+     */
+    void reconstructMarker(SimTK::Array_<SimTK::Vec3>& currentObservations,
+                           const int& i);
+
+    /**
+     * Reconstruct all missing markers of a body with a single rigid
+     * transformation. Returns false if less than three markers of the body are
+     * valid.
+     */
+    bool reconstructSegment(SimTK::Array_<SimTK::Vec3>& currentObservations,
+                            const std::vector<int>& segment);
+
     /**
      * Overloaded function of the marker reconstruction method. Case where no
      * valid markers exist in the same body. Returns the previously known
@@ -158,11 +198,17 @@ class RealTime_API MarkerReconstruction {
      */
     void reconstructionMethod(SimTK::Array_<SimTK::Vec3>& currentObservations,
                               const int& i, const std::vector<int>& indices);
-    OpenSim::Model model;
-    DistanceTable markerDistanceTable;
-    std::multimap<std::string, std::string> markersPerBodyMap;
+
+    Method method;
     std::vector<std::string> observationOrder;
+    // marker indices per body segment (in observation order)
+    std::vector<std::vector<int>> segments;
+    // markers of the same body sorted by their distance to the i-th marker
+    std::vector<std::vector<int>> neighbors;
     SimTK::Array_<SimTK::Vec3> previousObservations;
     bool isInitialized;
+
+    // preallocated workspace
+    std::vector<int> closest, valid, missing;
 };
 } // namespace OpenSimRT
@@ -0,0 +1,70 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file ModelStateContext.h
+ *
+ * @brief A model and its state shared by the modules of the GRF&M prediction
+ * (GRFMPrediction and the phase detectors), so that the kinematics of each
+ * frame are realized once instead of once per module.
+ *
+ * @Author: Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#pragma once
+
+#include "OpenSimUtils.h"
+#include "internal/RealTimeExports.h"
+#include <OpenSim/Simulation/Model/Model.h>
+#include <SimTKcommon.h>
+
+namespace OpenSimRT {
+
+/**
+ * Holds a copy of the model (with disabled actuators, as required by the
+ * GRF&M prediction) and its state. The owner of the context (e.g., the
+ * pipeline) updates the state once per frame, realizing it up to the highest
+ * stage required by the modules constructed on the context. The modules only
+ * read the model and the realized state.
+ */
+class RealTime_API ModelStateContext {
+ public:
+    ModelStateContext(const OpenSim::Model& model);
+
+    /**
+     * Declare the stage up to which a module requires the state to be
+     * realized on each update.
+     */
+    void requireStage(const SimTK::Stage& stage);
+
+    /**
+     * Update the generalized coordinates and speeds (in multibody tree order)
+     * and realize the state up to the required stage.
+     */
+    void update(const SimTK::Vector& q, const SimTK::Vector& qDot);
+
+    const OpenSim::Model& getModel() const;
+    const SimTK::State& getState() const;
+
+ private:
+    OpenSim::Model model;
+    SimTK::State state;
+    OpenSimUtils::StateIndices stateIndices;
+    SimTK::Stage stage;
+};
+
+} // namespace OpenSimRT
@@ -29,9 +29,11 @@
 
 #include "GRFMPrediction.h"
 #include "MarkerReconstruction.h"
+#include "ModelStateContext.h"
 #include "RealTimeAnalysis.h"
 #include "internal/RealTimeExports.h"
 #include <SimTKcommon/SmallMatrix.h>
+#include <memory>
 
 namespace OpenSimRT {
 
@@ -77,6 +79,10 @@ class RealTime_API RealTimeAnalysisExtended : public RealTimeAnalysis {
         ExternalPhaseDetectorUpdateFunction externalPhaseDetectorUpdateFunction;
         // detector update function (with internal estimations)
         InternalPhaseDetectorUpdateFunction internalPhaseDetectorUpdateFunction;
+        // model state shared by the GRFMPrediction and the (INTERNAL)
+        // detector (optional). The pipeline updates it once per frame before
+        // updating the detector.
+        std::shared_ptr<ModelStateContext> modelStateContext;
     };
 
  public:
@@ -20,6 +20,7 @@
 #include "InverseDynamics.h"
 #include "Exception.h"
 #include "OpenSimUtils.h"
+#include "Tracer.h"
 #include "Utils.h"
 #include <OpenSim/Simulation/Model/BodySet.h>
 #include <OpenSim/Simulation/Model/Muscle.h>
@@ -195,6 +196,7 @@ InverseDynamics::InverseDynamics(
 
 InverseDynamics::Output
 InverseDynamics::solve(const InverseDynamics::Input& input) {
+    TRACE_SPAN("InverseDynamics::solve");
     // update state
     state.updTime() = input.t;
     state.updQ() = input.q;
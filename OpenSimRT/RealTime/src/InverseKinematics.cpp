@@ -20,6 +20,7 @@
 #include "InverseKinematics.h"
 #include "Exception.h"
 #include "OpenSimUtils.h"
+#include "Tracer.h"
 #include <OpenSim/Simulation/Model/BodySet.h>
 #include <OpenSim/Simulation/Model/MarkerSet.h>
 #include <OpenSim/Tools/IKCoordinateTask.h>
@@ -96,6 +97,7 @@ InverseKinematics::InverseKinematics(const OpenSim::Model& otherModel,
 }
 
 InverseKinematics::Output InverseKinematics::solve(const Input& input) {
+    TRACE_SPAN("InverseKinematics::solve");
     state.updTime() = input.t;
     markerAssemblyConditions->moveAllObservations(input.markerObservations);
     imuAssemblyConditions->moveAllObservations(input.imuObservations);
@@ -19,6 +19,7 @@
  */
 #include "JointReaction.h"
 #include "Exception.h"
+#include "Tracer.h"
 #include <OpenSim/Simulation/Model/Actuator.h>
 
 using namespace std;
@@ -41,10 +42,50 @@ JointReaction::JointReaction(
 
     // init state
     state = model.initSystem();
+
+    // resolve the muscles once and enable the override of their actuation;
+    // here we iterate over the muscles and not actuators because we want to
+    // be in line with OpenSim's implementation, which considers only muscle
+    // forces
+    const auto& muscles = model.getMuscles();
+    for (int i = 0; i < muscles.getSize(); ++i) {
+        const auto* act = dynamic_cast<const ScalarActuator*>(&muscles[i]);
+        if (act) act->overrideActuation(state, true);
+        muscleActuators.push_back(act);
+    }
+    numActuators = model.getActuators().getSize();
+
+    // the reaction of each joint is the mobilizer reaction of its child, or
+    // of its parent if the joint is reversed in the multibody tree (i.e., the
+    // parent is the outboard body of the mobilizer)
+    const auto& matter = model.getMatterSubsystem();
+    const auto& joints = model.getJointSet();
+    for (int i = 0; i < joints.getSize(); ++i) {
+        auto child = joints[i].getChildFrame().getMobilizedBodyIndex();
+        auto parent = joints[i].getParentFrame().getMobilizedBodyIndex();
+        auto isInboard = [&](const MobilizedBodyIndex& inboard,
+                             const MobilizedBodyIndex& outboard) {
+            return outboard != GroundIndex &&
+                   matter.getMobilizedBody(outboard)
+                                   .getParentMobilizedBody()
+                                   .getMobilizedBodyIndex() == inboard;
+        };
+        if (isInboard(parent, child)) {
+            jointMobilizedBodies.push_back(child);
+            reversedJoints.push_back(false);
+        } else if (isInboard(child, parent)) {
+            jointMobilizedBodies.push_back(parent);
+            reversedJoints.push_back(true);
+        } else {
+            THROW_EXCEPTION("joint " + joints[i].getName() +
+                            " is not modeled by a mobilizer");
+        }
+    }
 }
 
 JointReaction::Output JointReaction::solve(const JointReaction::Input& input) {
-    if (model.getActuators().getSize() != input.fm.size()) {
+    TRACE_SPAN("JointReaction::solve");
+    if (numActuators != input.fm.size()) {
         THROW_EXCEPTION("actuators and provided muscle forces are of different "
                         "dimensions");
     }
@@ -64,16 +105,10 @@ JointReaction::Output JointReaction::solve(const JointReaction::Input& input) {
         externalWrenches[i]->getInput() = input.externalWrenches[i];
     }
 
-    // update muscle forces; here we iterate over the muscles and not
-    // actuators because we want to be in line with OpenSim's
-    // implementation, which considers only muscle forces
-    for (int i = 0; i < model.getMuscles().getSize(); ++i) {
-        const ScalarActuator* act =
-                dynamic_cast<const ScalarActuator*>(&model.getMuscles()[i]);
-        if (act) {
-            act->overrideActuation(state, true);
-            act->setOverrideActuation(state, input.fm[i]);
-        }
+    // update muscle forces (the override is enabled at construction)
+    for (int i = 0; i < muscleActuators.size(); ++i) {
+        if (muscleActuators[i])
+            muscleActuators[i]->setOverrideActuation(state, input.fm[i]);
     }
 
     // calculate all joint reaction forces and moments applied to child bodies,
@@ -91,26 +126,37 @@ JointReaction::Output JointReaction::solve(const JointReaction::Input& input) {
 
 SimTK::Vector
 JointReaction::asForceMomentPoint(const JointReaction::Output& jrOutput) {
-    const int nj = model.getJointSet().getSize();
-    const auto& joints = model.getJointSet();
-    const auto& ground = model.getGround();
+    Vector out;
+    asForceMomentPoint(jrOutput, out);
+    return out;
+}
 
-    Vector out(nj * 9);
+void JointReaction::asForceMomentPoint(const JointReaction::Output& jrOutput,
+                                       SimTK::Vector& out) {
+    const int nj = jointMobilizedBodies.size();
+    const auto& joints = model.getJointSet();
+    if (out.size() != nj * 9) out.resize(nj * 9);
     for (int i = 0; i < nj; ++i) {
-        auto jointReaction =
-                joints[i].calcReactionOnChildExpressedInGround(state);
-
-        // find the point of application in immediate child frame, then
-        // transform to the base frame of the child (expressedInBody)
-        Vec3 childLocationInGlobal =
+        // the mobilizer reaction on the outboard body, felt at the outboard
+        // frame (mobilizer frame M) and expressed in ground, as computed by
+        // Joint::calcReactionOnChildExpressedInGround
+        const auto& reaction = jrOutput.reactionWrench[jointMobilizedBodies[i]];
+        Vec3 moment = reaction[0];
+        Vec3 force = reaction[1];
+
+        // point of application (child frame origin) in ground
+        const auto& pointOfApplication =
                 joints[i].getChildFrame().getTransformInGround(state).p();
-        auto pointOfApplication = ground.findStationLocationInGround(
-                state, childLocationInGlobal);
 
-        // transform SpatialVec of reaction forces and moments to the
-        // requested base frame (expressedInBody)
-        Vec3 force = ground.expressVectorInGround(state, jointReaction[1]);
-        Vec3 moment = ground.expressVectorInGround(state, jointReaction[0]);
+        // the reaction of a reversed joint is on the parent, felt at the
+        // parent frame; the reaction on the child is opposite and shifted to
+        // the child frame (mobilizer frame F)
+        if (reversedJoints[i]) {
+            const auto& parentOrigin =
+                    joints[i].getParentFrame().getTransformInGround(state).p();
+            moment = -moment - (parentOrigin - pointOfApplication) % force;
+            force = -force;
+        }
 
         /* place results in the truncated loads vectors*/
         out[i * 9 + 0] = force[0];
@@ -123,7 +169,6 @@ JointReaction::asForceMomentPoint(const JointReaction::Output& jrOutput) {
         out[i * 9 + 7] = pointOfApplication[1];
         out[i * 9 + 8] = pointOfApplication[2];
     }
-    return out;
 }
 
 TimeSeriesTable JointReaction::initializeLogger() {
@@ -20,6 +20,7 @@
 #include "MuscleOptimization.h"
 #include "Exception.h"
 #include "OpenSimUtils.h"
+#include "Tracer.h"
 #include <OpenSim/Actuators/CoordinateActuator.h>
 #include <OpenSim/Simulation/Model/ForceSet.h>
 
@@ -74,6 +75,7 @@ MuscleOptimization::MuscleOptimization(
 
 MuscleOptimization::Output
 MuscleOptimization::solve(const MuscleOptimization::Input& input) {
+    TRACE_SPAN("MuscleOptimization::solve");
     try {
         target->prepareForOptimization(input);
         optimizer->optimize(parameterSeeds);
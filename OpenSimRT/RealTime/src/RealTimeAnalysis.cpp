@@ -20,7 +20,9 @@
 #include "RealTimeAnalysis.h"
 #include "Exception.h"
 #include "JointReaction.h"
+#include "Tracer.h"
 #include <SimTKcommon/internal/BigMatrix.h>
+#include <chrono>
 #include <thread>
 
 using namespace std;
@@ -54,7 +56,10 @@ RealTimeAnalysis::RealTimeAnalysis(
         const Model& otherModel, const RealTimeAnalysis::Parameters& parameters)
         : model(*otherModel.clone()), parameters(parameters),
           previousAcquisitionTime(-1.0), previousProcessingTime(-1.0),
-          notifyParentThread(false), terminationFlag(false) {
+          consumerThread(thread::id()), notifyParentThread(false),
+          terminationFlag(false), dataAvailable(false), acquiredFrames(0),
+          idleWaits(0), skippedFrames(0),
+          lastLatencyReport(monotonicNanoseconds()) {
     // filter
     lowPassFilter = new LowPassSmoothFilter(parameters.filterParameters);
 
@@ -73,11 +78,60 @@ RealTimeAnalysis::RealTimeAnalysis(
 
     // jr
     jointReaction = new JointReaction(model, parameters.wrenchParameters);
+
+    // result channel
+    if (parameters.resultPolicy != ResultPolicy::LATEST_ONLY)
+        resultQueue = make_unique<BoundedQueue<Output>>(
+                parameters.resultQueueCapacity,
+                parameters.resultPolicy == ResultPolicy::BLOCKING
+                        ? OverflowPolicy::BLOCK
+                        : OverflowPolicy::DROP_OLDEST);
 }
 
 bool RealTimeAnalysis::shouldTerminate() { return terminationFlag.load(); }
 
-void RealTimeAnalysis::shouldTerminate(bool flag) { terminationFlag = flag; }
+void RealTimeAnalysis::shouldTerminate(bool flag) {
+    terminationFlag = flag;
+    // wake up the acquisition thread
+    dataCond.notify_one();
+    // release the processing thread if it waits for the consumer
+    if (flag && resultQueue) resultQueue->close();
+}
+
+void RealTimeAnalysis::notifyDataAvailable() {
+    {
+        lock_guard<mutex> locker(dataMutex);
+        dataAvailable = true;
+    }
+    dataCond.notify_one();
+}
+
+void RealTimeAnalysis::waitForData() {
+    idleWaits++;
+    unique_lock<mutex> locker(dataMutex);
+    dataCond.wait_for(locker,
+                      chrono::duration<double>(
+                              parameters.acquisitionIdleTimeout),
+                      [&]() { return dataAvailable || shouldTerminate(); });
+}
+
+RealTimeAnalysis::AcquisitionStatistics
+RealTimeAnalysis::getAcquisitionStatistics() const {
+    return {acquiredFrames.load(), idleWaits.load(), skippedFrames.load()};
+}
+
+RealTimeAnalysis::PublicationStatistics
+RealTimeAnalysis::getPublicationStatistics() const {
+    if (resultQueue) {
+        auto statistics = resultQueue->getStatistics();
+        return {statistics.pushed, statistics.dropped, statistics.emptyPops,
+                statistics.producerWaits, statistics.maxSize};
+    }
+    // a published result is held until it is fetched or replaced
+    auto published = results.getPublished();
+    return {published, results.getOverwrites(), results.getStaleReads(), 0,
+            published > 0 ? 1 : 0};
+}
 
 void RealTimeAnalysis::run() {
     thread acquisitionThread(&RealTimeAnalysis::acquisition, this);
@@ -102,30 +156,50 @@ Vector RealTimeAnalysis::prepareUnfilteredData(
 }
 
 void RealTimeAnalysis::acquisition() {
+    TRACE_THREAD_NAME("acquisition");
     try {
         while (true) {
             if (shouldTerminate()) THROW_EXCEPTION("Acquisition terminated.");
 
-            // get data
-            auto acquisitionData = parameters.dataAcquisitionFunction();
+            // get data (notifications after this point wake up waitForData)
+            {
+                lock_guard<mutex> locker(dataMutex);
+                dataAvailable = false;
+            }
+            MotionCaptureInput acquisitionData;
+            {
+                TRACE_SPAN("data acquisition");
+                acquisitionData = parameters.dataAcquisitionFunction();
+            }
             if (previousAcquisitionTime >= acquisitionData.IkFrame.t) {
+                TRACE_SPAN("wait for data");
+                waitForData();
                 continue;
             }
+            TRACE_SPAN("acquisition frame");
 
             // update time
             previousAcquisitionTime = acquisitionData.IkFrame.t;
+            acquiredFrames++;
+            FrameTimestamps timestamps;
+            LATENCY_TIMESTAMP(timestamps.acquisition);
 
             // perform ik
             auto pose = inverseKinematics->solve(acquisitionData.IkFrame);
+            LATENCY_TIMESTAMP(timestamps.ik);
 
             // filter
             auto unfilteredData = prepareUnfilteredData(
                     pose.q, acquisitionData.ExternalWrenches);
             auto filteredData = lowPassFilter->filter({pose.t, unfilteredData});
+            LATENCY_TIMESTAMP(timestamps.filter);
 
             // push to buffer
-            if (!filteredData.isValid) continue;
-            buffer.add(filteredData);
+            if (!filteredData.isValid) {
+                skippedFrames++;
+                continue;
+            }
+            buffer.add({filteredData, timestamps});
         }
     } catch (exception& e) {
         cout << e.what() << endl;
@@ -139,6 +213,7 @@ void RealTimeAnalysis::acquisition() {
 }
 
 void RealTimeAnalysis::processing() {
+    TRACE_THREAD_NAME("processing");
     try {
         FilteredData filteredData;
         Vector am, fm, residuals, reactionWrenchVector;
@@ -147,7 +222,14 @@ void RealTimeAnalysis::processing() {
             if (shouldTerminate()) THROW_EXCEPTION("Processing terminated.");
 
             // get data from buffer
-            auto data = buffer.get(1)[0];
+            BufferedFrame frame;
+            {
+                TRACE_SPAN("wait for frame");
+                frame = buffer.get(1)[0];
+            }
+            TRACE_SPAN("processing frame");
+            const auto& data = frame.filtered;
+            auto& timestamps = frame.timestamps;
             filteredData.fromVector(data.t, data.x, data.xDot, data.xDDot,
                                     model.getNumCoordinates());
 
@@ -155,6 +237,7 @@ void RealTimeAnalysis::processing() {
             auto id = inverseDynamics->solve({filteredData.t, filteredData.q,
                                               filteredData.qd, filteredData.qdd,
                                               filteredData.externalWrenches});
+            LATENCY_TIMESTAMP(timestamps.id);
 
             // solve so and jr
             if (parameters.solveMuscleOptimization) {
@@ -163,34 +246,39 @@ void RealTimeAnalysis::processing() {
                 am = so.am;
                 fm = so.fm;
                 residuals = so.residuals;
+                LATENCY_TIMESTAMP(timestamps.so);
 
                 auto jr = jointReaction->solve({filteredData.t, filteredData.q,
                                                 filteredData.qd, so.fm,
                                                 filteredData.externalWrenches});
                 reactionWrenches = jr.reactionWrench;
-                reactionWrenchVector = jointReaction->asForceMomentPoint(jr);
+                jointReaction->asForceMomentPoint(jr, reactionWrenchVector);
+                LATENCY_TIMESTAMP(timestamps.jr);
             }
 
-            { // thread-safe write to output
-                lock_guard<mutex> locker(mu);
-                output.t = filteredData.t;
-                output.q = filteredData.q;
-                output.qd = filteredData.qd;
-                output.qdd = filteredData.qdd;
-                output.grfRightWrench =
-                        filteredData.externalWrenches[0].toVector();
-                output.grfLeftWrench =
-                        filteredData.externalWrenches[1].toVector();
-                output.tau = id.tau;
-                output.am = am;
-                output.fm = fm;
-                output.residuals = residuals;
-                output.reactionWrenches = reactionWrenches;
-                output.reactionWrenchVector = reactionWrenchVector;
+            // write to the back slot of the result buffer without locking (the
+            // main thread may still be reading another slot)
+            auto& output = results.write();
+            output.t = filteredData.t;
+            output.q = filteredData.q;
+            output.qd = filteredData.qd;
+            output.qdd = filteredData.qdd;
+            output.grfRightWrench = filteredData.externalWrenches[0].toVector();
+            output.grfLeftWrench = filteredData.externalWrenches[1].toVector();
+            output.tau = id.tau;
+            output.am = am;
+            output.fm = fm;
+            output.residuals = residuals;
+            output.reactionWrenches = reactionWrenches;
+            output.reactionWrenchVector = reactionWrenchVector;
+            {
+                TRACE_SPAN("publish results");
+                publishResults();
             }
-            // notify main thread to read output
-            notifyParentThread = true;
-            cond.notify_one();
+            LATENCY_TIMESTAMP(timestamps.publication);
+#ifdef ENABLE_LATENCY_INSTRUMENTATION
+            recordLatencies(timestamps);
+#endif
         }
     } catch (const std::exception& e) {
         cout << e.what() << endl;
@@ -199,16 +287,130 @@ void RealTimeAnalysis::processing() {
         terminationFlag = true;
 
         // notify main thread in case of exception
+        closeResults();
+    }
+}
+
+void RealTimeAnalysis::publishResults() {
+    if (resultQueue) {
+        // the back slot of the triple buffer is swapped with a slot of the
+        // queue, thus the result is not copied and the storage of the slot is
+        // reused for the next result
+        resultQueue->push(std::move(results.write()));
+        return;
+    }
+    results.publish();
+
+    // notify main thread to read output (the flag is set under the lock so
+    // that the notification is not lost)
+    {
+        lock_guard<mutex> locker(mu);
         notifyParentThread = true;
-        cond.notify_one();
     }
+    cond.notify_one();
+}
+
+void RealTimeAnalysis::closeResults() {
+    {
+        lock_guard<mutex> locker(mu);
+        notifyParentThread = true;
+    }
+    cond.notify_one();
+    if (resultQueue) resultQueue->close();
+}
+
+void RealTimeAnalysis::recordLatencies(const FrameTimestamps& timestamps) {
+    auto record = [&](LatencyStage stage, int64_t start, int64_t end) {
+        latencies[static_cast<int>(stage)].record(end - start);
+    };
+    record(LatencyStage::IK, timestamps.acquisition, timestamps.ik);
+    record(LatencyStage::FILTER, timestamps.ik, timestamps.filter);
+    record(LatencyStage::ID, timestamps.filter, timestamps.id);
+    auto last = timestamps.id;
+    if (timestamps.so != 0) { // so and jr are optional
+        record(LatencyStage::SO, timestamps.id, timestamps.so);
+        record(LatencyStage::JR, timestamps.so, timestamps.jr);
+        last = timestamps.jr;
+    }
+    record(LatencyStage::PUBLICATION, last, timestamps.publication);
+    record(LatencyStage::TOTAL, timestamps.acquisition, timestamps.publication);
+
+    // periodic report
+    if (parameters.latencyReportPeriod > 0 &&
+        timestamps.publication - lastLatencyReport >=
+                parameters.latencyReportPeriod * 1e9) {
+        printLatencyStatistics(cout);
+        lastLatencyReport = timestamps.publication;
+    }
+}
+
+LatencyHistogram::Statistics
+RealTimeAnalysis::getLatencyStatistics(LatencyStage stage) const {
+    return latencies[static_cast<int>(stage)].getStatistics();
+}
+
+void RealTimeAnalysis::printLatencyStatistics(ostream& stream) const {
+#ifndef ENABLE_LATENCY_INSTRUMENTATION
+    stream << "latency instrumentation is disabled (configure with "
+              "ENABLE_LATENCY_INSTRUMENTATION)"
+           << endl;
+#else
+    static const char* names[numLatencyStages] = {
+            "IK", "filter", "ID", "SO", "JR", "publication", "total"};
+    stream << "latency (us)\tcount\tmean\tp50\tp99\tp99.9\tmax" << endl;
+    for (int i = 0; i < numLatencyStages; ++i) {
+        auto statistics = latencies[i].getStatistics();
+        stream << names[i] << "\t" << statistics.count << "\t"
+               << statistics.mean / 1e3 << "\t" << statistics.p50 / 1e3 << "\t"
+               << statistics.p99 / 1e3 << "\t" << statistics.p999 / 1e3 << "\t"
+               << statistics.max / 1e3 << endl;
+    }
+#endif
 }
 
 RealTimeAnalysis::Output RealTimeAnalysis::getResults() {
-    unique_lock<mutex> locker(mu);
-    cond.wait(locker, [&]() { return notifyParentThread.load(); });
-    notifyParentThread = false;
-    return output;
+    // on a stale read (e.g., termination) the previous result is returned
+    getResults(lastResult);
+    return lastResult;
+}
+
+void RealTimeAnalysis::checkConsumer() {
+    // the result channels support a single consumer
+    thread::id consumer;
+    if (!consumerThread.compare_exchange_strong(consumer,
+                                                this_thread::get_id()) &&
+        consumer != this_thread::get_id())
+        THROW_EXCEPTION("The results must be fetched by a single thread.");
+}
+
+void RealTimeAnalysis::getResults(Output& output) {
+    checkConsumer();
+    if (resultQueue) {
+        resultQueue->pop(output);
+        return;
+    }
+    {
+        unique_lock<mutex> locker(mu);
+        cond.wait(locker, [&]() { return notifyParentThread.load(); });
+        notifyParentThread = false;
+    }
+    // the latest result is taken without blocking the processing thread; on a
+    // stale read the caller already holds the latest result
+    if (results.acquire()) results.swap(output);
+}
+
+bool RealTimeAnalysis::tryGetResults(Output& output) {
+    checkConsumer();
+    if (resultQueue) return resultQueue->tryPop(output);
+    {
+        // the flag is cleared before acquiring, thus a result published in
+        // between is not lost (at most getResults() returns a stale read)
+        lock_guard<mutex> locker(mu);
+        notifyParentThread = false;
+    }
+    if (!results.acquire()) return false;
+    results.swap(output);
+    return true;
 }
 
 RealTimeAnalysis::Loggers RealTimeAnalysis::initializeLoggers() {
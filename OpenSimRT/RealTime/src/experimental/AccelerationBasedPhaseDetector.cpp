@@ -18,6 +18,7 @@
  * -----------------------------------------------------------------------------
  */
 #include "AccelerationBasedPhaseDetector.h"
+#include "Exception.h"
 #include "GRFMPrediction.h"
 #include "OpenSimUtils.h"
 #include <algorithm>
@@ -29,12 +30,65 @@ using namespace SimTK;
 AccelerationBasedPhaseDetector::AccelerationBasedPhaseDetector(
         const Model& otherModel, const Parameters& otherParameters)
         : GaitPhaseDetector(otherParameters.windowSize),
-          model(*otherModel.clone()), parameters(otherParameters) {
+          parameters(otherParameters) {
+    if (parameters.method == Method::STATION_JACOBIAN) {
+        // refer to the kinematics of the given model
+        if (!otherModel.hasSystem())
+            THROW_EXCEPTION("The model must have an initialized system.");
+        kinematicModel = &otherModel;
+        state = otherModel.getWorkingState();
+    } else {
+        stationModel.reset(otherModel.clone());
+        state = stationModel->initSystem();
+        kinematicModel = stationModel.get();
+    }
+    stateIndices = OpenSimUtils::getStateIndices(*kinematicModel, state);
+    initialize();
+}
+
+AccelerationBasedPhaseDetector::AccelerationBasedPhaseDetector(
+        shared_ptr<ModelStateContext> otherContext,
+        const Parameters& otherParameters)
+        : GaitPhaseDetector(otherParameters.windowSize),
+          context(otherContext), parameters(otherParameters) {
+    kinematicModel = &context->getModel();
+    if (parameters.method == Method::STATION_JACOBIAN)
+        context->requireStage(Stage::Velocity);
+    else
+        context->requireStage(Stage::Position);
+    initialize();
+}
+
+void AccelerationBasedPhaseDetector::initialize() {
+    const auto& model = *kinematicModel;
+    accelerations.resize(4);
+
     // initialize buffers with consecutive values indicating the acceleration
     // exceeds the threshold
     rSlidingWindow.init(Array_<Vec2>(2, Vec2(0.0)));
     lSlidingWindow.init(Array_<Vec2>(2, Vec2(0.0)));
 
+    // stations in the order of the accelerations
+    const auto& rFoot = model.getBodySet().get(parameters.rFootBodyName);
+    const auto& lFoot = model.getBodySet().get(parameters.lFootBodyName);
+    stationBodies.push_back(rFoot.getMobilizedBodyIndex());
+    stationBodies.push_back(lFoot.getMobilizedBodyIndex());
+    stationBodies.push_back(rFoot.getMobilizedBodyIndex());
+    stationBodies.push_back(lFoot.getMobilizedBodyIndex());
+    stationLocations.push_back(parameters.rHeelLocationInFoot);
+    stationLocations.push_back(parameters.lHeelLocationInFoot);
+    stationLocations.push_back(parameters.rToeLocationInFoot);
+    stationLocations.push_back(parameters.lToeLocationInFoot);
+
+    if (parameters.method == Method::STATION_JACOBIAN) {
+        // the input accelerations (multibody tree order) are mapped to uDot
+        // through the u indices of the coordinates
+        const auto& s = getKinematicState();
+        if (context) stateIndices = OpenSimUtils::getStateIndices(model, s);
+        uDot = Vector(s.getNU(), 0.0);
+        return;
+    }
+
     // initialize bw filters
     posFilter = new ButterworthFilter(12, parameters.posLPFilterOrder,
                                       (2 * parameters.posLPFilterFreq) /
@@ -57,43 +111,46 @@ AccelerationBasedPhaseDetector::AccelerationBasedPhaseDetector(
     // initialize differentiators
     posDiff = new NumericalDifferentiator(12, parameters.posDiffOrder);
     velDiff = new NumericalDifferentiator(12, parameters.velDiffOrder);
+}
 
-    // add station points to the model to compute acceleration
-    heelStationR = new Station(model.getBodySet().get(parameters.rFootBodyName),
-                               parameters.rHeelLocationInFoot);
-    heelStationL = new Station(model.getBodySet().get(parameters.lFootBodyName),
-                               parameters.lHeelLocationInFoot);
-    toeStationR = new Station(model.getBodySet().get(parameters.rFootBodyName),
-                              parameters.rToeLocationInFoot);
-    toeStationL = new Station(model.getBodySet().get(parameters.lFootBodyName),
-                              parameters.lToeLocationInFoot);
-    model.addModelComponent(heelStationR.get());
-    model.addModelComponent(heelStationL.get());
-    model.addModelComponent(toeStationR.get());
-    model.addModelComponent(toeStationL.get());
-
-    // initialize system
-    state = model.initSystem();
+const State& AccelerationBasedPhaseDetector::getKinematicState() const {
+    return context ? context->getState() : state;
 }
 
-void AccelerationBasedPhaseDetector::updDetector(
+void AccelerationBasedPhaseDetector::updStationAccelerations(
         const GRFMPrediction::Input& input) {
-    // update detector simtk state
-    OpenSimUtils::updateState(model, state, input.q, input.qDot);
-    model.realizeAcceleration(state);
-
-    // get station position
-    auto rHeelPos = heelStationR->getLocationInGround(state);
-    auto rToePos = toeStationR->getLocationInGround(state);
-    auto lHeelPos = heelStationL->getLocationInGround(state);
-    auto lToePos = toeStationL->getLocationInGround(state);
-
-    // prepare for filtering
+    // update detector simtk state (a shared context is updated by its owner)
+    if (!context) {
+        OpenSimUtils::updateState(stateIndices, state, input.q, input.qDot);
+        if (parameters.method == Method::STATION_JACOBIAN)
+            kinematicModel->realizeVelocity(state);
+        else
+            kinematicModel->realizePosition(state);
+    }
+    const auto& s = getKinematicState();
+    const auto& matter = kinematicModel->getMatterSubsystem();
+
+    if (parameters.method == Method::STATION_JACOBIAN) {
+        if (stateIndices.u.size() != input.qDDot.size())
+            THROW_EXCEPTION("Wrong dimensions");
+        for (int i = 0; i < stateIndices.u.size(); ++i)
+            uDot[stateIndices.u[i]] = input.qDDot[i];
+
+        // a = JS * uDot + JSDot * u
+        matter.multiplyByStationJacobian(s, stationBodies, stationLocations,
+                                         uDot, accelerations);
+        matter.calcBiasForStationJacobian(s, stationBodies, stationLocations,
+                                          bias);
+        accelerations += bias;
+        return;
+    }
+
+    // prepare station positions for filtering
     Vector v(12);
-    v(0, 3) = Vector(rHeelPos);
-    v(3, 3) = Vector(lHeelPos);
-    v(6, 3) = Vector(rToePos);
-    v(9, 3) = Vector(lToePos);
+    for (int i = 0; i < 4; ++i)
+        v(3 * i, 3) = Vector(matter.getMobilizedBody(stationBodies[i])
+                                     .findStationLocationInGround(
+                                             s, stationLocations[i]));
 
     // apply filters and differentiators
     auto x = posFilter->filter(v);
@@ -101,10 +158,21 @@ void AccelerationBasedPhaseDetector::updDetector(
     auto xDDot = accFilter->filter(velDiff->diff(input.t, xDot));
 
     // get station accelerations
-    auto rHeelAcc = Vec3(&xDDot[0]);
-    auto lHeelAcc = Vec3(&xDDot[3]);
-    auto rToeAcc = Vec3(&xDDot[6]);
-    auto lToeAcc = Vec3(&xDDot[9]);
+    for (int i = 0; i < 4; ++i) accelerations[i] = Vec3(&xDDot[3 * i]);
+}
+
+const Vector_<Vec3>&
+AccelerationBasedPhaseDetector::getStationAccelerations() const {
+    return accelerations;
+}
+
+void AccelerationBasedPhaseDetector::updDetector(
+        const GRFMPrediction::Input& input) {
+    updStationAccelerations(input);
+    const auto& rHeelAcc = accelerations[0];
+    const auto& lHeelAcc = accelerations[1];
+    const auto& rToeAcc = accelerations[2];
+    const auto& lToeAcc = accelerations[3];
 
     // append to sliding windows a state value representing if the acceleration
     // exceeded the threshold.
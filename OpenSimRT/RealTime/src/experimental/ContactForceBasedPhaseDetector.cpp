@@ -31,10 +31,31 @@ using namespace OpenSim;
 using namespace OpenSimRT;
 using namespace SimTK;
 
+// Hunt-Crossley contact parameters of the spheres and the plane
+static const double stiffness = 2e6;
+static const double dissipation = 1.0;
+static const double staticFriction = 0.9;
+static const double dynamicFriction = 0.8;
+static const double viscousFriction = 0.6;
+static const double transitionVelocity = 0.01; // HuntCrossleyForce default
+
 ContactForceBasedPhaseDetector::ContactForceBasedPhaseDetector(
         const Model& otherModel, const Parameters& otherParameters)
         : GaitPhaseDetector(otherParameters.windowSize),
-          model(*otherModel.clone()), parameters(otherParameters) {
+          parameters(otherParameters) {
+    if (parameters.method == Method::GEOMETRIC) {
+        // refer to the kinematics of the given model
+        if (!otherModel.hasSystem())
+            THROW_EXCEPTION("The model must have an initialized system.");
+        setKinematicModel(otherModel);
+        state = otherModel.getWorkingState();
+        stateIndices = OpenSimUtils::getStateIndices(otherModel, state);
+        return;
+    }
+
+    contactModel.reset(otherModel.clone());
+    auto& model = *contactModel;
+
     // add platform
     auto platform = new OpenSim::Body("Platform", 1.0, Vec3(0), Inertia(0));
     model.addBody(platform);
@@ -81,12 +102,6 @@ ContactForceBasedPhaseDetector::ContactForceBasedPhaseDetector(
     model.addContactGeometry(leftToeContact);
 
     // contact parameters
-    double stiffness = 2e6;
-    double dissipation = 1.0;
-    double staticFriction = 0.9;
-    double dynamicFriction = 0.8;
-    double viscousFriction = 0.6;
-
     auto rightContactParams = new OpenSim::HuntCrossleyForce::ContactParameters(
             stiffness, dissipation, staticFriction, dynamicFriction,
             viscousFriction);
@@ -111,12 +126,55 @@ ContactForceBasedPhaseDetector::ContactForceBasedPhaseDetector(
 
     // initialize system
     state = model.initSystem();
+    stateIndices = OpenSimUtils::getStateIndices(model, state);
+}
+
+ContactForceBasedPhaseDetector::ContactForceBasedPhaseDetector(
+        shared_ptr<ModelStateContext> otherContext,
+        const Parameters& otherParameters)
+        : GaitPhaseDetector(otherParameters.windowSize),
+          context(otherContext), parameters(otherParameters) {
+    // the contact model requires a copy of the model
+    if (parameters.method != Method::GEOMETRIC)
+        THROW_EXCEPTION("Only the GEOMETRIC method can be constructed on a "
+                        "shared model state context.");
+    setKinematicModel(context->getModel());
+    context->requireStage(Stage::Velocity);
+}
+
+void ContactForceBasedPhaseDetector::setKinematicModel(const Model& model) {
+    kinematicModel = &model;
+    rFoot = model.getBodySet()
+                    .get(parameters.rFootBodyName)
+                    .getMobilizedBodyIndex();
+    lFoot = model.getBodySet()
+                    .get(parameters.lFootBodyName)
+                    .getMobilizedBodyIndex();
 }
 
 void ContactForceBasedPhaseDetector::updDetector(
         const GRFMPrediction::Input& input) {
-    OpenSimUtils::updateState(model, state, input.q, input.qDot);
-    model.realizeDynamics(state);
+    if (parameters.method == Method::GEOMETRIC) {
+        // a shared context is updated by its owner
+        if (!context) {
+            OpenSimUtils::updateState(stateIndices, state, input.q, input.qDot);
+            kinematicModel->realizeVelocity(state);
+        }
+        const auto& s = context ? context->getState() : state;
+        auto rightContactForce = calcContactForce(
+                s, rFoot, parameters.rHeelSphereLocation,
+                parameters.rToeSphereLocation);
+        auto leftContactForce = calcContactForce(
+                s, lFoot, parameters.lHeelSphereLocation,
+                parameters.lToeSphereLocation);
+        updDetectorState(input.t,
+                         rightContactForce.norm() - parameters.threshold,
+                         leftContactForce.norm() - parameters.threshold);
+        return;
+    }
+
+    OpenSimUtils::updateState(stateIndices, state, input.q, input.qDot);
+    contactModel->realizeDynamics(state);
 
     // compute contact forces
     auto rightContactWrench = rightContactForce.get()->getRecordValues(state);
@@ -132,3 +190,50 @@ void ContactForceBasedPhaseDetector::updDetector(
     updDetectorState(input.t, rightContactForce.norm() - parameters.threshold,
                      leftContactForce.norm() - parameters.threshold);
 }
+
+Vec3 ContactForceBasedPhaseDetector::calcContactForce(
+        const State& state, const MobilizedBodyIndex& foot,
+        const Vec3& heelLocation, const Vec3& toeLocation) const {
+    const auto& body =
+            kinematicModel->getMatterSubsystem().getMobilizedBody(foot);
+    const auto& radius = parameters.sphereRadius;
+    const Vec3 normal(0, 1, 0); // outward normal of the plane
+
+    // Simbody combines the (equal) parameters of the two surfaces, thus the
+    // stiffness is (stiffness^(2/3) / 2) and the rest are unchanged
+    const double k = pow(stiffness, 2.0 / 3.0) / 2;
+
+    Vec3 force(0);
+    for (const auto& location : {heelLocation, toeLocation}) {
+        // penetration of the sphere into the plane
+        Vec3 center = body.findStationLocationInGround(state, location);
+        double depth = radius - dot(center - parameters.plane_origin, normal);
+        if (depth <= 0) continue;
+
+        // velocity of the contact point (midway of the penetration)
+        Vec3 point = center - (radius - depth / 2) * normal;
+        Vec3 v = body.findStationVelocityInGround(
+                state, body.findStationAtGroundPoint(state, point));
+        double penetrationRate = -dot(v, normal);
+        Vec3 vTangent = v + penetrationRate * normal;
+
+        // Hertz force with Hunt-Crossley dissipation
+        double fH = 4.0 / 3.0 * k * depth * sqrt(radius * k * depth);
+        double f = fH * (1 + 1.5 * dissipation * penetrationRate);
+        if (f <= 0) continue;
+        force += f * normal;
+
+        // friction opposes the slip of the sphere
+        double vSlip = vTangent.norm();
+        if (vSlip == 0) continue;
+        double vRel = vSlip / transitionVelocity;
+        double fFriction =
+                f * (min(vRel, 1.0) *
+                             (dynamicFriction +
+                              2 * (staticFriction - dynamicFriction) /
+                                      (1 + vRel * vRel)) +
+                     viscousFriction * vSlip);
+        force -= fFriction * vTangent / vSlip;
+    }
+    return force;
+}
@@ -20,7 +20,7 @@
 #include "GRFMPrediction.h"
 #include "Exception.h"
 #include "GaitPhaseDetector.h"
-#include "OpenSimUtils.h"
+#include "Tracer.h"
 #include "Utils.h"
 
 using namespace std;
@@ -31,38 +31,39 @@ using namespace SimTK;
 GRFMPrediction::GRFMPrediction(const Model& otherModel,
                                const Parameters& aParameters,
                                GaitPhaseDetector* detector)
-        : model(*otherModel.clone()), gaitPhaseDetector(detector),
-          parameters(aParameters) {
+        : context(make_shared<ModelStateContext>(otherModel)),
+          sharedContext(false), parameters(aParameters),
+          gaitPhaseDetector(detector) {
+    initialize();
+}
+
+GRFMPrediction::GRFMPrediction(shared_ptr<ModelStateContext> otherContext,
+                               const Parameters& aParameters,
+                               GaitPhaseDetector* detector)
+        : context(otherContext), sharedContext(true),
+          parameters(aParameters), gaitPhaseDetector(detector) {
+    initialize();
+}
+
+void GRFMPrediction::initialize() {
+    const auto& model = context->getModel();
+
     // reserve memory size for computing the mean gait direction
     gaitDirectionBuffer.setSize(parameters.directionWindowSize);
 
-    // add station points to the model for the CoP trajectory
-    heelStationR =
-            new Station(model.getBodySet().get(parameters.rStationBodyName),
-                        parameters.rHeelStationLocation);
-    heelStationL =
-            new Station(model.getBodySet().get(parameters.lStationBodyName),
-                        parameters.lHeelStationLocation);
-    toeStationR =
-            new Station(model.getBodySet().get(parameters.rStationBodyName),
-                        parameters.rToeStationLocation);
-    toeStationL =
-            new Station(model.getBodySet().get(parameters.lStationBodyName),
-                        parameters.lToeStationLocation);
-    heelStationR->setName("heel_station_point_r");
-    heelStationL->setName("heel_station_point_l");
-    toeStationR->setName("toe_station_point_r");
-    toeStationL->setName("toe_station_point_l");
-    model.addModelComponent(heelStationR.get());
-    model.addModelComponent(heelStationL.get());
-    model.addModelComponent(toeStationR.get());
-    model.addModelComponent(toeStationL.get());
-
-    // disable muscles, otherwise they apply passive forces
-    OpenSimUtils::disableActuators(model);
-
-    // initialize system
-    state = model.initSystem();
+    // feet of the station points for the CoP trajectory
+    rStationBody = model.getBodySet()
+                           .get(parameters.rStationBodyName)
+                           .getMobilizedBodyIndex();
+    lStationBody = model.getBodySet()
+                           .get(parameters.lStationBodyName)
+                           .getMobilizedBodyIndex();
+
+    // the ID method requires the applied forces of the model
+    if (parameters.method == Method::InverseDynamics)
+        context->requireStage(Stage::Dynamics);
+    else
+        context->requireStage(Stage::Velocity);
 
     // define STA functions by Ren et al.
     // https://doi.org/10.1016/j.jbiomech.2008.06.001
@@ -109,9 +110,20 @@ GRFMPrediction::selectMethod(const std::string& methodName) {
         THROW_EXCEPTION("Wrong input method. Select appropriate input name.");
 }
 
+Vec3 GRFMPrediction::getStationLocationInGround(
+        const MobilizedBodyIndex& body, const Vec3& location) const {
+    return context->getModel()
+            .getMatterSubsystem()
+            .getMobilizedBody(body)
+            .findStationLocationInGround(context->getState(), location);
+}
+
 void GRFMPrediction::computeTotalReactionComponents(const Input& input,
                                                     Vec3& totalReactionForce,
                                                     Vec3& totalReactionMoment) {
+    const auto& model = context->getModel();
+    const auto& state = context->getState();
+
     // get matter subsystem
     const auto& matter = model.getMatterSubsystem();
 
@@ -181,12 +193,13 @@ void GRFMPrediction::computeTotalReactionComponents(const Input& input,
 
 SimTK::Rotation
 GRFMPrediction::computeGaitDirectionRotation(const std::string& bodyName) {
+    const auto& model = context->getModel();
     const auto& body = model.getBodySet().get(bodyName);
     const auto& mob = model.getMatterSubsystem().getMobilizedBody(
             body.getMobilizedBodyIndex());
 
     // get body transformation
-    const auto& R_GB = mob.getBodyTransform(state).R();
+    const auto& R_GB = mob.getBodyTransform(context->getState()).R();
 
     // append direction to buffer (x-component in rotation matrix)
     gaitDirectionBuffer.insert((~R_GB).col(0).asVec3());
@@ -208,6 +221,7 @@ GRFMPrediction::computeGaitDirectionRotation(const std::string& bodyName) {
 
 GRFMPrediction::Output
 GRFMPrediction::solve(const GRFMPrediction::Input& input) {
+    TRACE_SPAN("GRFMPrediction::solve");
     Output output;
     output.t = input.t;
     output.right.force = Vec3(0.0);
@@ -218,9 +232,8 @@ GRFMPrediction::solve(const GRFMPrediction::Input& input) {
     output.left.point = Vec3(0.0);
 
     if (gaitPhaseDetector->isDetectorReady()) {
-        // update model state and realize state
-        OpenSimUtils::updateState(model, state, input.q, input.qDot);
-        model.realizeDynamics(state);
+        // update model state and realize state (unless shared)
+        if (!sharedContext) context->update(input.q, input.qDot);
 
         // compute the transformation to the average heading direction
         auto R = computeGaitDirectionRotation(parameters.pelvisBodyName);
@@ -337,6 +350,16 @@ void GRFMPrediction::seperateReactionComponents(
 void GRFMPrediction::computeReactionPoint(const double& t,
                                           SimTK::Vec3& rightPoint,
                                           SimTK::Vec3& leftPoint) {
+    // station points forming the cop trajectory
+    const auto rHeel = getStationLocationInGround(
+            rStationBody, parameters.rHeelStationLocation);
+    const auto lHeel = getStationLocationInGround(
+            lStationBody, parameters.lHeelStationLocation);
+    const auto rToe = getStationLocationInGround(
+            rStationBody, parameters.rToeStationLocation);
+    const auto lToe = getStationLocationInGround(
+            lStationBody, parameters.lToeStationLocation);
+
     // get previous SS time-period
     Tss = gaitPhaseDetector->getSingleSupportDuration();
 
@@ -346,12 +369,12 @@ void GRFMPrediction::computeReactionPoint(const double& t,
         // first determine leading / trailing leg
         switch (gaitPhaseDetector->getLeadingLeg()) {
         case GaitPhaseState::LeadingLeg::RIGHT: {
-            rightPoint = heelStationR->getLocationInGround(state);
-            leftPoint = toeStationL->getLocationInGround(state);
+            rightPoint = rHeel;
+            leftPoint = lToe;
         } break;
         case GaitPhaseState::LeadingLeg::LEFT: {
-            rightPoint = toeStationR->getLocationInGround(state);
-            leftPoint = heelStationL->getLocationInGround(state);
+            rightPoint = rToe;
+            leftPoint = lHeel;
         } break;
         case GaitPhaseState::LeadingLeg::INVALID: {
             cerr << "CoP: invalid LeadingLeg state!" << endl;
@@ -361,30 +384,26 @@ void GRFMPrediction::computeReactionPoint(const double& t,
 
     case GaitPhaseState::GaitPhase::LEFT_SWING: {
         // distance between heel and toe station points on foot
-        const auto d = toeStationR->getLocationInGround(state) -
-                       heelStationR->getLocationInGround(state);
+        const auto d = rToe - rHeel;
 
         // time since last toe-off event
         auto time = t - gaitPhaseDetector->getToeOffTime();
 
         // result CoP
         leftPoint = Vec3(0);
-        rightPoint =
-                heelStationR->getLocationInGround(state) + copPosition(time, d);
+        rightPoint = rHeel + copPosition(time, d);
     } break;
 
     case GaitPhaseState::GaitPhase::RIGHT_SWING: {
         // distance between heel and toe station points on foot
-        const auto d = toeStationL->getLocationInGround(state) -
-                       heelStationL->getLocationInGround(state);
+        const auto d = lToe - lHeel;
 
         // time since last toe-off event
         auto time = t - gaitPhaseDetector->getToeOffTime();
 
         // result CoP
         rightPoint = Vec3(0);
-        leftPoint =
-                heelStationL->getLocationInGround(state) + copPosition(time, d);
+        leftPoint = lHeel + copPosition(time, d);
     } break;
 
     default: {
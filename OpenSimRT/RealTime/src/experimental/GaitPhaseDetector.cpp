@@ -35,9 +35,8 @@ GaitPhaseDetector::GaitPhaseDetector(const int& windowSize) : Tds(-1), Tss(-1) {
     // define function for detecting HS - transition SWING -> STANCE
     // (compare latest value the the previous n-1 values in the window)
     detectHS = [](const SlidingWindow<GaitPhaseState::LegPhase>& w) {
-        return (w.nFirstEqual(GaitPhaseState::LegPhase::SWING,
-                              w.data.size() - 1) &&
-                w.data.back() == GaitPhaseState::LegPhase::STANCE)
+        return (w.nFirstEqual(GaitPhaseState::LegPhase::SWING, w.size() - 1) &&
+                w.back() == GaitPhaseState::LegPhase::STANCE)
                        ? true
                        : false;
     };
@@ -46,8 +45,8 @@ GaitPhaseDetector::GaitPhaseDetector(const int& windowSize) : Tds(-1), Tss(-1) {
     // (compare latest value the the previous n-1 values in the window)
     detectTO = [](const SlidingWindow<GaitPhaseState::LegPhase>& w) {
         return (w.nFirstEqual(GaitPhaseState::LegPhase::STANCE,
-                              w.data.size() - 1) &&
-                w.data.back() == GaitPhaseState::LegPhase::SWING)
+                              w.size() - 1) &&
+                w.back() == GaitPhaseState::LegPhase::SWING)
                        ? true
                        : false;
     };
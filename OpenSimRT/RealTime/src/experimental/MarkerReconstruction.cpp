@@ -19,6 +19,9 @@
  */
 #include "MarkerReconstruction.h"
 #include "OpenSimUtils.h"
+#include "Tracer.h"
+#include <algorithm>
+#include <map>
 
 using namespace std;
 using namespace OpenSim;
@@ -27,36 +30,43 @@ using namespace SimTK;
 
 // MarkerReconstruction constructor
 MarkerReconstruction::MarkerReconstruction(
-        const Model& otherModel,
-        const vector<InverseKinematics::MarkerTask>& markerTasks)
-        : model(*otherModel.clone()), isInitialized(false) {
+        const Model& model,
+        const vector<InverseKinematics::MarkerTask>& markerTasks,
+        const Method& method)
+        : method(method), isInitialized(false) {
     // map markers to corresponding body segments
+    map<string, int> segmentIndices;
+    vector<Vec3> locations;
     for (int i = 0; i < markerTasks.size(); ++i) {
         const auto& markerName = markerTasks[i].name;
         const auto& marker = model.getMarkerSet().get(markerName);
-        markersPerBodyMap.emplace(marker.getParentFrameName(), markerName);
+        auto inserted = segmentIndices.emplace(marker.getParentFrameName(),
+                                               segments.size());
+        if (inserted.second) segments.emplace_back();
+        segments[inserted.first->second].push_back(i);
+        locations.push_back(marker.get_location());
 
         // get marker observation order from tasks.
         observationOrder.push_back(markerName);
     }
-    // create table with distances between markers in same body
-    for (int i = 0; i < markerTasks.size(); ++i) {
-        const auto& iMarkerName = markerTasks[i].name;
-        const auto& iMarker = model.getMarkerSet().get(iMarkerName);
-
-        const auto& markersInBody =
-                markersPerBodyMap.equal_range(iMarker.getParentFrameName());
-
-        // for every marker in body calculate the distance between marker i,j
-        for (auto itr = markersInBody.first; itr != markersInBody.second;
-             ++itr) {
-            const auto& jMarkerName = itr->second;
-            const auto& jMarker = model.getMarkerSet().get(jMarkerName);
 
-            Vec3 dij = jMarker.get_location() - iMarker.get_location();
-            markerDistanceTable[iMarkerName][jMarkerName] = dij;
+    // sort the markers of each body based on their distance from marker i
+    neighbors.resize(markerTasks.size());
+    for (const auto& segment : segments) {
+        for (const auto& i : segment) {
+            neighbors[i] = segment;
+            stable_sort(neighbors[i].begin(), neighbors[i].end(),
+                        [&](const int& j, const int& k) {
+                            return (locations[j] - locations[i]).norm() <
+                                   (locations[k] - locations[i]).norm();
+                        });
         }
     }
+
+    // workspace
+    closest.reserve(3);
+    valid.reserve(markerTasks.size());
+    missing.reserve(markerTasks.size());
 }
 
 bool MarkerReconstruction::isValidFrame(
@@ -108,94 +118,129 @@ void MarkerReconstruction::reconstructionMethod(
     Sphere c1{d1x.norm(), currentObservations[id1]};
     Sphere c2{d2x.norm(), currentObservations[id2]};
 
-    // find intersection of the two spheres.
-    auto* circle = sphereSphereIntersection(c1, c2);
-
-    // reconstructed point is the point on the circle closest to
-    // x_tilde.
-    if (circle) {
+    // find intersection of the two spheres. reconstructed point is the point
+    // on the circle closest to x_tilde.
+    Circle circle;
+    if (sphereSphereIntersection(c1, c2, circle)) {
         // projection on the plane of the circle
         currentObservations[i] = closestPointToCircle(x_tilde, circle);
 
     } else { // spheres do not intersect.
         currentObservations[i] = x_tilde;
     }
-    delete circle;
 }
 
 void MarkerReconstruction::reconstructionMethod(
         Array_<Vec3>& currentObservations, const int& i,
         const vector<int>& indices) {
-    Matrix A(3, 3);
-    Matrix B(3, 3);
+    Mat33 R;
+    Vec3 t;
+    fitRigidTransform(currentObservations, indices, R, t);
+
+    // transform missing marker to compute a current estimate
+    currentObservations[i] = R * previousObservations[i] + t;
+}
 
-    // marker coordinates as columns in matrices
-    for (int j = 0; j < 3; ++j) {
-        A.updCol(j) = Vector(3, &previousObservations[indices[j]][0]);
+void MarkerReconstruction::fitRigidTransform(
+        const Array_<Vec3>& currentObservations, const vector<int>& indices,
+        Mat33& R, Vec3& t) {
+    // find centroids of the markers in the previous (A) and current (B) frame
+    Vec3 centroid_A(0), centroid_B(0);
+    for (const auto& j : indices) {
+        centroid_A += previousObservations[j];
+        centroid_B += currentObservations[j];
     }
-    for (int j = 0; j < 3; ++j) {
-        B.updCol(j) = Vector(3, &currentObservations[indices[j]][0]);
+    centroid_A /= double(indices.size());
+    centroid_B /= double(indices.size());
+
+    // cross-covariance H = A * B**T of the centered coordinates
+    Mat33 H(0);
+    for (const auto& j : indices) {
+        H += (previousObservations[j] - centroid_A) *
+             ~(currentObservations[j] - centroid_B);
     }
 
-    // find centroid and substract from columns in A and B
-    const auto centroid_A = A.rowSum() / A.ncol();
-    const auto centroid_B = B.rowSum() / B.ncol();
-
-    for (int j = 0; j < A.ncol(); ++j) { A.updCol(j) -= centroid_A; }
-    for (int j = 0; j < B.ncol(); ++j) { B.updCol(j) -= centroid_B; }
-
-    // solve SVD for H = A * B**T --> [U, S, V**T] = SVD(H)
+    // solve SVD for H --> [U, S, V**T] = SVD(H)
     Matrix rightVectors;
     Matrix leftVectors;
     Vector singularValues;
 
-    FactorSVD svd(A * (~B));
+    FactorSVD svd((Matrix(H)));
     svd.getSingularValuesAndVectors(singularValues, leftVectors, rightVectors);
 
     // rotation matrix R = V * U**T
-    auto r = (~rightVectors) * (~leftVectors);
-    auto R = Mat33(r[0][0], r[0][1], r[0][2], r[1][0], r[1][1], r[1][2],
-                   r[2][0], r[2][1], r[2][2]);
+    Mat33 U, Vt;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            U[r][c] = leftVectors[r][c];
+            Vt[r][c] = rightVectors[r][c];
+        }
+    }
+    R = ~Vt * ~U;
 
     // address reflexion case
     if (det(R) < 0) {
-        rightVectors[2] *= -1;
-        r = (~rightVectors) * (~leftVectors);
-        R = Mat33(r[0][0], r[0][1], r[0][2], r[1][0], r[1][1], r[1][2], r[2][0],
-                  r[2][1], r[2][2]);
+        Vt[2] = -Vt[2];
+        R = ~Vt * ~U;
     }
 
     // translation vector
-    auto t = centroid_B - Matrix(R) * centroid_A;
+    t = centroid_B - R * centroid_A;
+}
 
-    // transform missing marker to compute a current estimate
-    auto estimate = Matrix(R) * Vector(previousObservations[i]) + t;
-    currentObservations[i] = Vec3(estimate[0], estimate[1], estimate[2]);
+void MarkerReconstruction::reconstructMarker(Array_<Vec3>& currentObservations,
+                                             const int& i) {
+    // find the closest markers (max = 3) of the missing marker.
+    findClosestMarkers(i, currentObservations, 3, closest);
+
+    // dispatch reconstruction method based on the number of closest
+    // markers in the same body
+    if (closest.empty()) { // no marker found. return previous positions
+        reconstructionMethod(currentObservations, i);
+    } else if (closest.size() == 1) { // one marker found
+        reconstructionMethod(currentObservations, i, closest[0]);
+    } else if (closest.size() == 2) { // two markers found
+        reconstructionMethod(currentObservations, i, closest[0], closest[1]);
+    } else { // more than two are present. find best tranformation that fits
+             // the data
+        reconstructionMethod(currentObservations, i, closest);
+    }
+}
+
+bool MarkerReconstruction::reconstructSegment(Array_<Vec3>& currentObservations,
+                                              const vector<int>& segment) {
+    valid.clear();
+    missing.clear();
+    for (const auto& j : segment) {
+        if (currentObservations[j].isFinite())
+            valid.push_back(j);
+        else
+            missing.push_back(j);
+    }
+    if (missing.empty()) return true;
+    if (valid.size() < 3) return false;
+
+    // a single transformation for all missing markers of the body
+    Mat33 R;
+    Vec3 t;
+    fitRigidTransform(currentObservations, valid, R, t);
+    for (const auto& j : missing) {
+        currentObservations[j] = R * previousObservations[j] + t;
+    }
+    return true;
 }
 
 void MarkerReconstruction::solve(Array_<Vec3>& currentObservations) {
-    for (int i = 0; i < currentObservations.size(); ++i) {
-        if (!currentObservations[i].isFinite()) {
-            // find the closest markers (max = 3) of the missing marker.
-            const auto& mMarkerName = observationOrder[i];
-            auto indices =
-                    findClosestMarkers(mMarkerName, currentObservations, 3);
-
-            // dispatch reconstruction method based on the number of closest
-            // markers in the same body
-            if (indices.empty()) { // no marker found. return previous positions
-                reconstructionMethod(currentObservations, i);
-            } else if (indices.size() == 1) { // one marker found
-                const auto& id1 = indices[0];
-                reconstructionMethod(currentObservations, i, id1);
-            } else if (indices.size() == 2) { // two markers found
-                const auto& id1 = indices[0];
-                const auto& id2 = indices[1];
-                reconstructionMethod(currentObservations, i, id1, id2);
-            } else { // more than two are present. find best tranformation that
-                     // fits the data
-                reconstructionMethod(currentObservations, i, indices);
-            }
+    TRACE_SPAN("MarkerReconstruction::solve");
+    // markers are reconstructed in observation order within each body, thus
+    // reconstructed markers can be used for the following ones
+    for (const auto& segment : segments) {
+        if (method == Method::RIGID_BODY &&
+            reconstructSegment(currentObservations, segment))
+            continue;
+        for (const auto& i : segment) {
+            if (!currentObservations[i].isFinite())
+                reconstructMarker(currentObservations, i);
         }
     }
     // update previous observations
@@ -209,15 +254,15 @@ MarkerReconstruction::solve(const Array_<Vec3>& currentObservations) {
     return reconstructedObservations;
 }
 
-MarkerReconstruction::Circle*
-MarkerReconstruction::sphereSphereIntersection(const Sphere& c1,
-                                               const Sphere& c2) {
+bool MarkerReconstruction::sphereSphereIntersection(const Sphere& c1,
+                                                    const Sphere& c2,
+                                                    Circle& circle) {
     double d = (c1.origin - c2.origin).norm();        // distance of two origins
     Vec3 d_hat = (c2.origin - c1.origin).normalize(); // unit vector
 
     // check for solvability.
     if (d > (c1.radius + c2.radius) || (d < abs(c1.radius - c2.radius))) {
-        return nullptr;
+        return false;
     }
 
     // determine the distance from c1.origin to point p.
@@ -229,62 +274,29 @@ MarkerReconstruction::sphereSphereIntersection(const Sphere& c1,
     // determine the distance from point p to either of the intersection points.
     double h = sqrt((c1.radius * c1.radius) - (a * a));
     // determine the intersection points.
-    return new Circle{h, p, d_hat};
+    circle = Circle{h, p, d_hat};
+    return true;
 }
 
 Vec3 MarkerReconstruction::closestPointToCircle(const Vec3& vec,
-                                                const Circle* c) {
-    auto dist = dot(vec - c->origin, c->normal);
-    auto vec_prime = vec - dist * c->normal;
+                                                const Circle& c) {
+    auto dist = dot(vec - c.origin, c.normal);
+    auto vec_prime = vec - dist * c.normal;
 
     // shortest distance between a point and a circle in 2D.
-    auto n = (vec_prime - c->origin).normalize();
-    return c->origin + n * c->radius;
+    auto n = (vec_prime - c.origin).normalize();
+    return c.origin + n * c.radius;
 };
 
-vector<int> MarkerReconstruction::findClosestMarkers(
-        const string& mMarkerName, const Array_<Vec3>& currentObservations,
-        int numMarkers) {
-    // info of missing marker
-    const auto& mMarker = model.getMarkerSet().get(mMarkerName);
-    const auto& bodyName = mMarker.getParentFrameName();
-    const int idx = distance(observationOrder.cbegin(),
-                             find(observationOrder.cbegin(),
-                                  observationOrder.cend(), mMarkerName));
-
-    // marker list per body, ignoring missing markers
-    vector<string> markersInBody;
-    for (auto itr = markersPerBodyMap.equal_range(bodyName).first;
-         itr != markersPerBodyMap.equal_range(bodyName).second; ++itr) {
-        const int i = distance(observationOrder.cbegin(),
-                               find(observationOrder.cbegin(),
-                                    observationOrder.cend(), itr->second));
-
-        if (currentObservations[i].isFinite()) {
-            markersInBody.push_back(itr->second);
-        }
-    }
-
-    // compare function based on marker distance
-    auto comp = [&](const string& iMarker, const string& jMarker) -> bool {
-        const auto& d1 = markerDistanceTable[mMarkerName][iMarker];
-        const auto& d2 = markerDistanceTable[mMarkerName][jMarker];
-        return d1.norm() < d2.norm();
-    };
-
-    // sort markers in body based on distance
-    sort(markersInBody.begin(), markersInBody.end(), comp);
-
-    // return the N closest marker IDs
-    vector<int> output;
-    numMarkers = min((int) markersInBody.size(), numMarkers);
-    for (auto itr = markersInBody.cbegin();
-         itr != markersInBody.cbegin() + numMarkers; ++itr) {
-        output.push_back(distance(observationOrder.cbegin(),
-                                  find(observationOrder.cbegin(),
-                                       observationOrder.cend(), *itr)));
+void MarkerReconstruction::findClosestMarkers(
+        const int& i, const Array_<Vec3>& currentObservations, int numMarkers,
+        vector<int>& indices) {
+    // neighbors are sorted based on distance, ignore missing markers
+    indices.clear();
+    for (const auto& j : neighbors[i]) {
+        if (int(indices.size()) == numMarkers) break;
+        if (currentObservations[j].isFinite()) indices.push_back(j);
     }
-    return output;
 }
 
 TimeSeriesTable_<Vec3> MarkerReconstruction::initializeLogger() {
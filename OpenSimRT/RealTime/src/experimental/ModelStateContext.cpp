@@ -0,0 +1,46 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "ModelStateContext.h"
+#include "OpenSimUtils.h"
+
+using namespace OpenSim;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+ModelStateContext::ModelStateContext(const Model& otherModel)
+        : model(*otherModel.clone()), stage(Stage::Position) {
+    // disable muscles, otherwise they apply passive forces
+    OpenSimUtils::disableActuators(model);
+    state = model.initSystem();
+    stateIndices = OpenSimUtils::getStateIndices(model, state);
+}
+
+void ModelStateContext::requireStage(const Stage& otherStage) {
+    if (otherStage > stage) stage = otherStage;
+}
+
+void ModelStateContext::update(const Vector& q, const Vector& qDot) {
+    OpenSimUtils::updateState(stateIndices, state, q, qDot);
+    model.getMultibodySystem().realize(state, stage);
+}
+
+const Model& ModelStateContext::getModel() const { return model; }
+
+const State& ModelStateContext::getState() const { return state; }
@@ -20,6 +20,7 @@
 #include "RealTimeAnalysisExtended.h"
 #include "Exception.h"
 #include "InverseDynamics.h"
+#include "Tracer.h"
 
 using namespace std;
 using namespace OpenSim;
@@ -41,35 +42,59 @@ RealTimeAnalysisExtended::RealTimeAnalysisExtended(const Model& otherModel,
     if (parameters.useGRFMPrediction) {
         if (parameters.phaseDetector == nullptr)
             THROW_EXCEPTION("Phase detector is null");
-        grfmPrediction = new GRFMPrediction(model, parameters.grfmParameters,
-                                            parameters.phaseDetector.get());
+        if (parameters.modelStateContext)
+            grfmPrediction = new GRFMPrediction(
+                    parameters.modelStateContext, parameters.grfmParameters,
+                    parameters.phaseDetector.get());
+        else
+            grfmPrediction =
+                    new GRFMPrediction(model, parameters.grfmParameters,
+                                       parameters.phaseDetector.get());
     }
 }
 
 void RealTimeAnalysisExtended::acquisition() {
+    TRACE_THREAD_NAME("acquisition");
     try {
         while (true) {
             if (shouldTerminate()) THROW_EXCEPTION("Acquisition terminated.");
 
-            // get data
-            auto acquisitionData = parameters.dataAcquisitionFunction();
+            // get data (notifications after this point wake up waitForData)
+            {
+                lock_guard<mutex> locker(dataMutex);
+                dataAvailable = false;
+            }
+            MotionCaptureInput acquisitionData;
+            {
+                TRACE_SPAN("data acquisition");
+                acquisitionData = parameters.dataAcquisitionFunction();
+            }
             if (previousAcquisitionTime >= acquisitionData.IkFrame.t) {
+                TRACE_SPAN("wait for data");
+                waitForData();
                 continue;
             }
+            TRACE_SPAN("acquisition frame");
 
             // update time
             previousAcquisitionTime = acquisitionData.IkFrame.t;
+            acquiredFrames++;
+            FrameTimestamps timestamps;
+            LATENCY_TIMESTAMP(timestamps.acquisition);
 
             // reconstruct possible missing markers. requires at least one valid
             // frame with all markers positions
             if (!markerReconstruction->initState(
-                        acquisitionData.IkFrame.markerObservations))
+                        acquisitionData.IkFrame.markerObservations)) {
+                skippedFrames++;
                 continue;
+            }
             markerReconstruction->solve(
                     acquisitionData.IkFrame.markerObservations);
 
             // perform ik
             auto pose = inverseKinematics->solve(acquisitionData.IkFrame);
+            LATENCY_TIMESTAMP(timestamps.ik);
 
             // filter ik results
             auto unfilteredData = prepareUnfilteredData(
@@ -77,7 +102,10 @@ void RealTimeAnalysisExtended::acquisition() {
             auto filteredData = lowPassFilter->filter({pose.t, unfilteredData});
 
             // skip if filter is not ready
-            if (!filteredData.isValid) continue;
+            if (!filteredData.isValid) {
+                skippedFrames++;
+                continue;
+            }
 
             // represent filtered data as struct
             FilteredData data;
@@ -86,6 +114,10 @@ void RealTimeAnalysisExtended::acquisition() {
 
             // grfm prediction
             if (parameters.useGRFMPrediction) {
+                // realize the shared model state once for all modules
+                if (parameters.modelStateContext)
+                    parameters.modelStateContext->update(data.q, data.qd);
+
                 // update detector
                 if (parameters.detectorUpdateMethod ==
                     PhaseDetectorUpdateMethod::INTERNAL)
@@ -113,7 +145,9 @@ void RealTimeAnalysisExtended::acquisition() {
                 data.externalWrenches = {grfRightWrench, grfLeftWrench};
             }
 
-            // push to buffer
+            // push to buffer (the filter stage includes the grfm prediction)
+            LATENCY_TIMESTAMP(timestamps.filter);
+            data.timestamps = timestamps;
             buffer.add(data);
         }
     } catch (exception& e) {
@@ -128,6 +162,7 @@ void RealTimeAnalysisExtended::acquisition() {
 }
 
 void RealTimeAnalysisExtended::processing() {
+    TRACE_THREAD_NAME("processing");
     try {
         Vector am, fm, residuals, reactionWrenchVector;
         Vector_<SpatialVec> reactionWrenches;
@@ -135,11 +170,17 @@ void RealTimeAnalysisExtended::processing() {
             if (shouldTerminate()) THROW_EXCEPTION("Processing terminated.");
 
             // get data from buffer
-            auto data = buffer.get(1)[0];
+            FilteredData data;
+            {
+                TRACE_SPAN("wait for frame");
+                data = buffer.get(1)[0];
+            }
+            TRACE_SPAN("processing frame");
 
             // solve id
             auto id = inverseDynamics->solve(
                     {data.t, data.q, data.qd, data.qdd, data.externalWrenches});
+            LATENCY_TIMESTAMP(data.timestamps.id);
 
             // solve so and jr
             if (parameters.solveMuscleOptimization) {
@@ -147,31 +188,38 @@ void RealTimeAnalysisExtended::processing() {
                 am = so.am;
                 fm = so.fm;
                 residuals = so.residuals;
+                LATENCY_TIMESTAMP(data.timestamps.so);
 
                 auto jr = jointReaction->solve({data.t, data.q, data.qd, so.fm,
                                                 data.externalWrenches});
                 reactionWrenches = jr.reactionWrench;
-                reactionWrenchVector = jointReaction->asForceMomentPoint(jr);
+                jointReaction->asForceMomentPoint(jr, reactionWrenchVector);
+                LATENCY_TIMESTAMP(data.timestamps.jr);
             }
 
-            { // thread-safe write to output
-                lock_guard<mutex> locker(mu);
-                output.t = data.t;
-                output.q = data.q;
-                output.qd = data.qd;
-                output.qdd = data.qdd;
-                output.grfRightWrench = data.externalWrenches[0].toVector();
-                output.grfLeftWrench = data.externalWrenches[1].toVector();
-                output.tau = id.tau;
-                output.am = am;
-                output.fm = fm;
-                output.residuals = residuals;
-                output.reactionWrenches = reactionWrenches;
-                output.reactionWrenchVector = reactionWrenchVector;
+            // write to the back slot of the result buffer without locking (the
+            // main thread may still be reading another slot)
+            auto& output = results.write();
+            output.t = data.t;
+            output.q = data.q;
+            output.qd = data.qd;
+            output.qdd = data.qdd;
+            output.grfRightWrench = data.externalWrenches[0].toVector();
+            output.grfLeftWrench = data.externalWrenches[1].toVector();
+            output.tau = id.tau;
+            output.am = am;
+            output.fm = fm;
+            output.residuals = residuals;
+            output.reactionWrenches = reactionWrenches;
+            output.reactionWrenchVector = reactionWrenchVector;
+            {
+                TRACE_SPAN("publish results");
+                publishResults();
             }
-            // notify main thread to read output
-            notifyParentThread = true;
-            cond.notify_one();
+            LATENCY_TIMESTAMP(data.timestamps.publication);
+#ifdef ENABLE_LATENCY_INSTRUMENTATION
+            recordLatencies(data.timestamps);
+#endif
         }
     } catch (const std::exception& e) {
         cout << e.what() << endl;
@@ -180,7 +228,6 @@ void RealTimeAnalysisExtended::processing() {
         terminationFlag = true;
 
         // notify main thread in case of exception
-        notifyParentThread = true;
-        cond.notify_one();
+        closeResults();
     }
 }
@@ -0,0 +1,139 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file FrameReplay.h
+ *
+ * \brief Replay of recorded frames to a RealTimeAnalysis pipeline, shared by
+ * the file-based tests of the pipeline.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "Exception.h"
+#include "RealTimeAnalysis.h"
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Replays the frames from a producer thread that notifies the pipeline
+ * of each new frame, while the acquisition function returns the latest frame
+ * (the previous one if no new frame has been replayed yet).
+ *
+ * The frames are replayed at the recording rate (100 Hz). In lock-step mode
+ * (the performance gate) a frame is replayed as soon as the result of the
+ * previous one has been handled by the main loop (resultHandled()) or the
+ * pipeline skipped it, thus the throughput is bounded by the slowest stage and
+ * no result is overwritten.
+ */
+class FrameReplay {
+ public:
+    typedef std::function<MotionCaptureInput(const int&)> FrameFunction;
+
+    FrameReplay(bool lockStep)
+            : lockStep(lockStep), newFrame(false), endOfReplay(false),
+              handledFrames(0) {
+        latestFrame.IkFrame.t = -1;
+    }
+
+    ~FrameReplay() { join(); }
+
+    /**
+     * The data acquisition function of the pipeline. Throws at the end of the
+     * replay.
+     */
+    MotionCaptureInput acquire() {
+        std::lock_guard<std::mutex> locker(frameMutex);
+        if (!newFrame && endOfReplay) THROW_EXCEPTION("End of replay.");
+        newFrame = false;
+        return latestFrame;
+    }
+
+    /**
+     * Start replaying `numFrames` frames to a running pipeline.
+     */
+    void start(RealTimeAnalysis& pipeline, int numFrames,
+               FrameFunction getFrame) {
+        producer = std::thread(&FrameReplay::replay, this, std::ref(pipeline),
+                               numFrames, getFrame);
+    }
+
+    /**
+     * Notify that the main loop has handled a result.
+     */
+    void resultHandled() {
+        {
+            std::lock_guard<std::mutex> locker(frameMutex);
+            handledFrames++;
+        }
+        resultCond.notify_one();
+    }
+
+    void join() {
+        if (producer.joinable()) producer.join();
+    }
+
+ private:
+    void replay(RealTimeAnalysis& pipeline, int numFrames,
+                FrameFunction getFrame) {
+        using namespace std::chrono_literals;
+        for (int i = 0; i < numFrames; ++i) {
+            auto frame = getFrame(i);
+            {
+                std::unique_lock<std::mutex> locker(frameMutex);
+                // skipped frames are not notified, thus the wait is polled
+                while (lockStep && !previousFrameDone(pipeline, i) &&
+                       !pipeline.shouldTerminate())
+                    resultCond.wait_for(locker, 1ms);
+                latestFrame = frame;
+                newFrame = true;
+            }
+            pipeline.notifyDataAvailable();
+            if (pipeline.shouldTerminate()) break;
+            if (!lockStep) std::this_thread::sleep_for(10ms);
+        }
+        {
+            std::lock_guard<std::mutex> locker(frameMutex);
+            endOfReplay = true;
+        }
+        pipeline.notifyDataAvailable();
+    }
+
+    // the i previous frames were acquired and either handled or skipped
+    bool previousFrameDone(const RealTimeAnalysis& pipeline, int i) const {
+        auto acquisition = pipeline.getAcquisitionStatistics();
+        return !newFrame && acquisition.frames == i &&
+               handledFrames + acquisition.skippedFrames == i;
+    }
+
+    bool lockStep;
+    std::mutex frameMutex;
+    std::condition_variable resultCond;
+    MotionCaptureInput latestFrame;
+    bool newFrame, endOfReplay;
+    long long handledFrames;
+    std::thread producer;
+};
+
+} // namespace OpenSimRT
@@ -26,6 +26,7 @@
 #include "INIReader.h"
 #include "InverseKinematics.h"
 #include "OpenSimUtils.h"
+#include "PerformanceGate.h"
 #include "Settings.h"
 #include "Utils.h"
 #include "Visualization.h"
@@ -41,7 +42,7 @@ using namespace OpenSim;
 using namespace SimTK;
 using namespace OpenSimRT;
 
-void run() {
+void run(const PerformanceGate& gate) {
     // subject data
     INIReader ini(INI_FILE);
     auto section = "TEST_IK_IMU_FROM_FILE";
@@ -72,6 +73,8 @@ void run() {
 
     // mean delay
     int sumDelayMS = 0;
+    LatencyHistogram latencies;
+    auto start = monotonicNanoseconds();
 
     // loop through marker frames
     for (int i = 0; i < markerData.getNumFrames(); ++i) {
@@ -89,9 +92,11 @@ void run() {
         t2 = chrono::high_resolution_clock::now();
         sumDelayMS +=
                 chrono::duration_cast<chrono::milliseconds>(t2 - t1).count();
+        latencies.record(
+                chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count());
 
-        // visualize
-        visualizer.update(pose.q);
+        // visualize (not part of the throughput of the performance gate)
+        if (!gate.isEnabled()) visualizer.update(pose.q);
 
         // record
         qLogger.appendRow(pose.t, ~pose.q);
@@ -99,8 +104,12 @@ void run() {
         // this_thread::sleep_for(chrono::milliseconds(10));
     }
 
+    auto duration = (monotonicNanoseconds() - start) * 1e-9;
+
     cout << "Mean delay: " << (double) sumDelayMS / markerData.getNumFrames()
          << " ms" << endl;
+    gate.submit(PerformanceReport::fromLatencies(
+            "TestIKIMUFromFile", latencies.getStatistics(), duration));
 
     // Compare results with reference tables.
     OpenSimUtils::compareTables(
@@ -114,7 +123,9 @@ void run() {
 
 int main(int argc, char* argv[]) {
     try {
-        run();
+        PerformanceGate gate(argc, argv, INI_FILE, DATA_DIR,
+                             LIBRARY_OUTPUT_PATH);
+        run(gate);
     } catch (exception& e) {
         cout << e.what() << endl;
         return -1;
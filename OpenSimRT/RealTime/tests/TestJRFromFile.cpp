@@ -38,6 +38,7 @@
 #include <OpenSim/Common/STOFileAdapter.h>
 #include <OpenSim/Simulation/Model/BodySet.h>
 #include <OpenSim/Simulation/Model/Muscle.h>
+#include <algorithm>
 #include <iostream>
 #include <thread>
 
@@ -46,6 +47,57 @@ using namespace OpenSim;
 using namespace SimTK;
 using namespace OpenSimRT;
 
+/**
+ * Reference joint reaction analysis: the previous implementation of
+ * JointReaction::solve, which looks up the muscles and enables their override
+ * on every frame. Used to benchmark the cached actuators of JointReaction.
+ */
+class ReferenceJointReaction {
+ public:
+    ReferenceJointReaction(
+            const Model& otherModel,
+            const vector<ExternalWrench::Parameters>& wrenchParameters)
+            : model(*otherModel.clone()) {
+        for (const auto& parameters : wrenchParameters) {
+            auto wrench = new ExternalWrench(parameters);
+            externalWrenches.push_back(wrench);
+            model.addForce(wrench);
+        }
+        state = model.initSystem();
+    }
+
+    JointReaction::Output solve(const JointReaction::Input& input) {
+        if (model.getActuators().getSize() != input.fm.size())
+            THROW_EXCEPTION("actuators and provided muscle forces are of "
+                            "different dimensions");
+        state.updTime() = input.t;
+        state.updQ() = input.q;
+        state.updU() = input.qDot;
+        for (int i = 0; i < input.externalWrenches.size(); ++i)
+            externalWrenches[i]->getInput() = input.externalWrenches[i];
+        for (int i = 0; i < model.getMuscles().getSize(); ++i) {
+            const ScalarActuator* act =
+                    dynamic_cast<const ScalarActuator*>(&model.getMuscles()[i]);
+            if (act) {
+                act->overrideActuation(state, true);
+                act->setOverrideActuation(state, input.fm[i]);
+            }
+        }
+        JointReaction::Output output;
+        output.t = input.t;
+        output.reactionWrench = Vector_<SpatialVec>(model.getNumBodies());
+        model.getMultibodySystem().realize(state, Stage::Acceleration);
+        model.getMatterSubsystem().calcMobilizerReactionForces(
+                state, output.reactionWrench);
+        return output;
+    }
+
+ private:
+    Model model;
+    State state;
+    vector<ExternalWrench*> externalWrenches;
+};
+
 void run() {
     // subject data
     INIReader ini(INI_FILE);
@@ -173,6 +225,9 @@ void run() {
     // mean delay
     int sumDelayMS = 0;
 
+    // inputs of the analysis, for the benchmark
+    vector<JointReaction::Input> jrInputs;
+
     // loop through kinematic frames
     for (int i = 0; i < qTable.getNumRows(); ++i) {
         // get raw pose from table
@@ -219,9 +274,10 @@ void run() {
         chrono::high_resolution_clock::time_point t1;
         t1 = chrono::high_resolution_clock::now();
 
-        auto jrOutput = jr.solve(
-                {ikFiltered.t, q, qDot, fm,
-                 vector<ExternalWrench::Input>{grfRightWrench, grfLeftWrench}});
+        JointReaction::Input jrInput = {
+                ikFiltered.t, q, qDot, fm,
+                vector<ExternalWrench::Input>{grfRightWrench, grfLeftWrench}};
+        auto jrOutput = jr.solve(jrInput);
 
         chrono::high_resolution_clock::time_point t2;
         t2 = chrono::high_resolution_clock::now();
@@ -245,6 +301,7 @@ void run() {
 
         // log data (use filter time to align with delay)
         jrLogger.appendRow(ikFiltered.t, ~jr.asForceMomentPoint(jrOutput));
+        jrInputs.push_back(jrInput);
 
         // this_thread::sleep_for(chrono::milliseconds(10));
     }
@@ -252,6 +309,37 @@ void run() {
     cout << "Mean delay: " << (double) sumDelayMS / qTable.getNumRows() << " ms"
          << endl;
 
+    // benchmark JointReaction::solve with the actuators resolved at
+    // construction against the reference, which looks up the muscles and
+    // enables their override on every frame, on the same inputs
+    ReferenceJointReaction jrReference(model, wrenchParameters);
+    const int repetitions = 10;
+    double maxDifference = 0;
+    auto t1 = chrono::high_resolution_clock::now();
+    for (int k = 0; k < repetitions; ++k)
+        for (const auto& input : jrInputs) jr.solve(input);
+    auto t2 = chrono::high_resolution_clock::now();
+    for (int k = 0; k < repetitions; ++k)
+        for (const auto& input : jrInputs) jrReference.solve(input);
+    auto t3 = chrono::high_resolution_clock::now();
+    for (const auto& input : jrInputs) {
+        auto cached = jr.solve(input).reactionWrench;
+        auto reference = jrReference.solve(input).reactionWrench;
+        for (int j = 0; j < cached.size(); ++j) {
+            maxDifference = max({maxDifference,
+                                 (cached[j][0] - reference[j][0]).norm(),
+                                 (cached[j][1] - reference[j][1]).norm()});
+        }
+    }
+    const double n = repetitions * jrInputs.size();
+    cout << "JointReaction::solve (cached/reference): "
+         << chrono::duration<double, micro>(t2 - t1).count() / n << " / "
+         << chrono::duration<double, micro>(t3 - t2).count() / n << " us"
+         << endl;
+    if (maxDifference > 1e-9)
+        THROW_EXCEPTION("JointReaction differs from the reference by " +
+                        toString(maxDifference));
+
     // Compare results with reference tables.
     OpenSimUtils::compareTables(
             jrLogger,
@@ -26,11 +26,15 @@
  * @author Dimitar Stanev <jimstanev@gmail.com>, Filip Konstantinos
  * <filip.k@ece.upatras.gr>
  */
+#include "BinaryLogger.h"
+#include "FrameReplay.h"
 #include "INIReader.h"
 #include "InverseDynamics.h"
 #include "OpenSimUtils.h"
+#include "PerformanceGate.h"
 #include "RealTimeAnalysis.h"
 #include "Settings.h"
+#include "Tracer.h"
 #include "Visualization.h"
 #include <Actuators/Thelen2003Muscle.h>
 #include <Common/TimeSeriesTable.h>
@@ -43,7 +47,7 @@ using namespace SimTK;
 using namespace OpenSim;
 using namespace OpenSimRT;
 
-void run(char const* name) {
+void run(const PerformanceGate& gate) {
     INIReader ini(INI_FILE);
     auto section = "TEST_RT_PIPELINE_FROM_FILE";
     auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
@@ -87,6 +91,17 @@ void run(char const* name) {
     auto splineOrder = ini.getInteger(section, "SPLINE_ORDER", 0);
     auto calcDer = ini.getBoolean(section, "CALC_DER", true);
 
+    // result channel
+    auto resultPolicyName =
+            ini.getString(section, "RESULT_POLICY", "LATEST_ONLY");
+    auto resultQueueCapacity =
+            ini.getInteger(section, "RESULT_QUEUE_CAPACITY", 64);
+
+#ifdef ENABLE_TRACING
+    // span trace export
+    auto traceWindow = ini.getReal(section, "TRACE_WINDOW", 0.0);
+#endif
+
     // ik parameters
     auto ikConstraintsWeight =
             ini.getReal(section, "IK_CONSTRAINT_WEIGHT", 0.0);
@@ -150,9 +165,8 @@ void run(char const* name) {
     wrenchParameters.push_back(grfRightFootPar);
     wrenchParameters.push_back(grfLeftFootPar);
 
-    // acquisition function (simulates acquisition from motion)
-    auto dataAcquisitionFunction = [&]() -> MotionCaptureInput {
-        static int i = 0;
+    // recorded frames (simulates acquisition from motion)
+    auto getFrame = [&](const int& i) -> MotionCaptureInput {
         MotionCaptureInput input;
 
         // get frame data
@@ -166,13 +180,12 @@ void run(char const* name) {
         auto grfLeftWrench = ExternalWrench::getWrenchFromStorage(
                 t, grfLeftLabels, grfMotion);
         input.ExternalWrenches = {grfRightWrench, grfLeftWrench};
-
-        // dummy delay to simulate real time
-        this_thread::sleep_for(10ms);
-        i++;
         return input;
     };
 
+    // replay of the frames (lock-step for the performance gate)
+    FrameReplay frameReplay(gate.isEnabled());
+
     // initialize filter parameters
     LowPassSmoothFilter::Parameters filterParameters;
     filterParameters.numSignals =
@@ -200,12 +213,41 @@ void run(char const* name) {
     pipelineParameters.muscleOptimizationParameters =
             muscleOptimizationParameters;
     pipelineParameters.wrenchParameters = wrenchParameters;
-    pipelineParameters.dataAcquisitionFunction = dataAcquisitionFunction;
+    pipelineParameters.dataAcquisitionFunction = [&]() {
+        return frameReplay.acquire();
+    };
     pipelineParameters.momentArmFunction = calcMomentArm;
+    if (resultPolicyName == "LATEST_ONLY") {
+        pipelineParameters.resultPolicy =
+                RealTimeAnalysis::ResultPolicy::LATEST_ONLY;
+    } else if (resultPolicyName == "DROP_OLDEST") {
+        pipelineParameters.resultPolicy =
+                RealTimeAnalysis::ResultPolicy::DROP_OLDEST;
+    } else if (resultPolicyName == "BLOCKING") {
+        pipelineParameters.resultPolicy =
+                RealTimeAnalysis::ResultPolicy::BLOCKING;
+    } else {
+        THROW_EXCEPTION("unsupported result policy: " + resultPolicyName);
+    }
+    pipelineParameters.resultQueueCapacity = resultQueueCapacity;
     RealTimeAnalysis pipeline(model, pipelineParameters);
     auto log = pipeline.initializeLoggers();
 
+    // binary loggers, so that logging does not grow the memory or block the
+    // loop; converted to tables after the analysis
+    auto binaryDir = LIBRARY_OUTPUT_PATH + "/";
+    BinaryLogger qLogger(binaryDir + "q.bin", log.qLogger);
+    BinaryLogger qDotLogger(binaryDir + "qDot.bin", log.qDotLogger);
+    BinaryLogger qDDotLogger(binaryDir + "qDDot.bin", log.qDDotLogger);
+    BinaryLogger tauLogger(binaryDir + "tau.bin", log.tauLogger);
+    BinaryLogger fmLogger(binaryDir + "fm.bin", log.fmLogger);
+    BinaryLogger amLogger(binaryDir + "am.bin", log.amLogger);
+    BinaryLogger residualLogger(binaryDir + "residuals.bin",
+                                log.residualLogger);
+    BinaryLogger jrLogger(binaryDir + "jr.bin", log.jrLogger);
+
     // run pipeline
+    auto start = monotonicNanoseconds();
     pipeline.run();
 
     // visualizer
@@ -219,16 +261,20 @@ void run(char const* name) {
     auto leftKneeForceDecorator = new ForceDecorator(Red, 0.0005, 3);
     visualizer.addDecorationGenerator(leftKneeForceDecorator);
 
+    // replay the frames
+    frameReplay.start(pipeline, markerData.getNumFrames(), getFrame);
+
     // mean delay
     int sumDelayMS = 0;
     int sumDelayMSCount = 0;
+    RealTimeAnalysis::Output results; // reused between fetches
     try {
         while (!pipeline.shouldTerminate()) {
             chrono::high_resolution_clock::time_point t1;
             t1 = chrono::high_resolution_clock::now();
 
             // fetch of rt results
-            auto results = pipeline.getResults();
+            pipeline.getResults(results);
 
             chrono::high_resolution_clock::time_point t2;
             t2 = chrono::high_resolution_clock::now();
@@ -249,26 +295,74 @@ void run(char const* name) {
                         leftKneeForceDecorator);
             }
             // log
-            log.qLogger.appendRow(results.t, ~results.q);
-            log.qDotLogger.appendRow(results.t, ~results.qd);
-            log.qDDotLogger.appendRow(results.t, ~results.qdd);
-            log.tauLogger.appendRow(results.t, ~results.tau);
+            qLogger.appendRow(results.t, results.q);
+            qDotLogger.appendRow(results.t, results.qd);
+            qDDotLogger.appendRow(results.t, results.qdd);
+            tauLogger.appendRow(results.t, results.tau);
             if (solveMuscleOptimization) {
-                log.fmLogger.appendRow(results.t, ~results.fm);
-                log.amLogger.appendRow(results.t, ~results.am);
-                log.residualLogger.appendRow(results.t, ~results.residuals);
-                log.jrLogger.appendRow(results.t,
-                                       ~results.reactionWrenchVector);
+                fmLogger.appendRow(results.t, results.fm);
+                amLogger.appendRow(results.t, results.am);
+                residualLogger.appendRow(results.t, results.residuals);
+                jrLogger.appendRow(results.t, results.reactionWrenchVector);
             }
-
+            frameReplay.resultHandled();
         } // while loop
     } catch (const exception& e) {
         cout << e.what() << "\n";
         pipeline.shouldTerminate(true);
     }
+    frameReplay.join();
+    auto duration = (monotonicNanoseconds() - start) * 1e-9;
 
     cout << "Mean delay: " << (double) sumDelayMS / sumDelayMSCount << " ms"
          << endl;
+    pipeline.printLatencyStatistics(cout);
+    gate.submit(PerformanceReport::fromLatencies(
+            "TestRTFromFile",
+            pipeline.getLatencyStatistics(
+                    RealTimeAnalysis::LatencyStage::TOTAL),
+            duration));
+#ifdef ENABLE_TRACING
+    cout << "Exported spans: "
+         << Tracer::exportChromeTrace(LIBRARY_OUTPUT_PATH + "/trace.json",
+                                      traceWindow)
+         << endl;
+#endif
+
+    // write the remaining rows and read the binary logs back; a dropped row
+    // would be missing from the comparison with the reference tables
+    vector<pair<string, BinaryLogger*>> loggers = {
+            {"q", &qLogger},
+            {"qDot", &qDotLogger},
+            {"qDDot", &qDDotLogger},
+            {"tau", &tauLogger},
+            {"fm", &fmLogger},
+            {"am", &amLogger},
+            {"residuals", &residualLogger},
+            {"jr", &jrLogger}};
+    for (const auto& logger : loggers) {
+        logger.second->close();
+        auto dropped = logger.second->getStatistics().dropped;
+        if (dropped != 0)
+            THROW_EXCEPTION(to_string(dropped) + " rows of the " +
+                            logger.first + " log were dropped");
+    }
+    log.qLogger = BinaryLogger::readTable(binaryDir + "q.bin");
+    log.qDotLogger = BinaryLogger::readTable(binaryDir + "qDot.bin");
+    log.qDDotLogger = BinaryLogger::readTable(binaryDir + "qDDot.bin");
+    log.tauLogger = BinaryLogger::readTable(binaryDir + "tau.bin");
+    log.fmLogger = BinaryLogger::readTable(binaryDir + "fm.bin");
+    log.amLogger = BinaryLogger::readTable(binaryDir + "am.bin");
+    log.residualLogger = BinaryLogger::readTable(binaryDir + "residuals.bin");
+    log.jrLogger = BinaryLogger::readTable(binaryDir + "jr.bin");
+
+    auto publication = pipeline.getPublicationStatistics();
+    cout << "Results (" << resultPolicyName << ") published: "
+         << publication.published
+         << ", overwritten: " << publication.overwrites
+         << ", stale reads: " << publication.staleReads
+         << ", producer waits: " << publication.producerWaits
+         << ", max queue size: " << publication.maxQueueSize << endl;
 
      // store results
      //STOFileAdapter::write(log.qLogger, subjectDir +
@@ -333,7 +427,9 @@ void run(char const* name) {
 }
 int main(int argc, char* argv[]) {
     try {
-        run(argc > 1 ? argv[1] : nullptr);
+        PerformanceGate gate(argc, argv, INI_FILE, DATA_DIR,
+                             LIBRARY_OUTPUT_PATH);
+        run(gate);
     } catch (exception& e) {
         cout << e.what() << endl;
         return -1;
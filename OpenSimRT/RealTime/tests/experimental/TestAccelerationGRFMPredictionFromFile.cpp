@@ -26,6 +26,7 @@
  * @author Filip Konstantinos <filip.k@ece.upatras.gr>
  */
 #include "AccelerationBasedPhaseDetector.h"
+#include "Exception.h"
 #include "GRFMPrediction.h"
 #include "INIReader.h"
 #include "OpenSimUtils.h"
@@ -111,6 +112,8 @@ void run() {
     auto posLPFilterOrder = ini.getInteger(section, "POS_LP_FILTER_ORDER", 0);
     auto posDiffOrder = ini.getInteger(section, "POS_DIFF_ORDER", 0);
     auto velDiffOrder = ini.getInteger(section, "VEL_DIFF_ORDER", 0);
+    auto jacobianMinPhaseAgreement =
+            ini.getReal(section, "JACOBIAN_MIN_PHASE_AGREEMENT", 0);
 
     // grfm parameters
     auto grfmMethod = ini.getString(section, "METHOD", "");
@@ -190,6 +193,29 @@ void run() {
     detectorParameters.velDiffOrder = velDiffOrder;
     AccelerationBasedPhaseDetector detector(model, detectorParameters);
 
+    // the station Jacobian method computes the accelerations from the
+    // kinematics without the delay of the filters, thus the detected phases
+    // are required to agree only in a part of the frames
+    auto jacobianDetectorParameters = detectorParameters;
+    jacobianDetectorParameters.method =
+            AccelerationBasedPhaseDetector::Method::STATION_JACOBIAN;
+    AccelerationBasedPhaseDetector jacobianDetector(model,
+                                                    jacobianDetectorParameters);
+    double sumJacobianDelayUS = 0;
+    int jacobianPhaseMatches = 0;
+
+    // the station Jacobian accelerations are checked against the station
+    // accelerations of a realized state, given the generalized accelerations
+    // of the (forward dynamics) state as input
+    AccelerationBasedPhaseDetector accelerationCheckDetector(
+            model, jacobianDetectorParameters);
+    State checkState = model.getWorkingState();
+    const auto& coordinates = model.getCoordinatesInMultibodyTreeOrder();
+    vector<pair<string, Vec3>> stations = {{rFootBodyName, rHeelLocation},
+                                           {lFootBodyName, lHeelLocation},
+                                           {rFootBodyName, rToeLocation},
+                                           {lFootBodyName, lToeLocation}};
+
     // grfm prediction
     GRFMPrediction::Parameters grfmParameters;
     grfmParameters.method = GRFMPrediction::selectMethod(grfmMethod);
@@ -256,6 +282,42 @@ void run() {
                 chrono::duration_cast<chrono::milliseconds>(t2 - t1).count();
         sumDelayMSCounter++;
 
+        // compare with the station Jacobian method
+        t1 = chrono::high_resolution_clock::now();
+        jacobianDetector.updDetector({ikFiltered.t, q, qDot, qDDot});
+        t2 = chrono::high_resolution_clock::now();
+        sumJacobianDelayUS += chrono::duration<double, micro>(t2 - t1).count();
+        if (jacobianDetector.getPhase() == detector.getPhase())
+            jacobianPhaseMatches++;
+
+        if (sumDelayMSCounter % 10 == 0) {
+            OpenSimUtils::updateState(model, checkState, q, qDot);
+            model.realizeAcceleration(checkState);
+            Vector qCheck(q.size()), qDotCheck(q.size()), qDDotCheck(q.size());
+            for (int j = 0; j < coordinates.size(); ++j) {
+                qCheck[j] = coordinates[j]->getValue(checkState);
+                qDotCheck[j] = coordinates[j]->getSpeedValue(checkState);
+                qDDotCheck[j] =
+                        coordinates[j]->getAccelerationValue(checkState);
+            }
+            accelerationCheckDetector.updDetector(
+                    {ikFiltered.t, qCheck, qDotCheck, qDDotCheck});
+            const auto& accelerations =
+                    accelerationCheckDetector.getStationAccelerations();
+            for (int j = 0; j < stations.size(); ++j) {
+                auto expected = model.getBodySet()
+                                        .get(stations[j].first)
+                                        .findStationAccelerationInGround(
+                                                checkState, stations[j].second);
+                if ((accelerations[j] - expected).norm() >
+                    1e-8 * (1 + expected.norm()))
+                    THROW_EXCEPTION("station Jacobian acceleration " +
+                                    to_string(j) + " does not match the " +
+                                    "realized state at t = " +
+                                    to_string(ikFiltered.t));
+            }
+        }
+
         // project on plane
         grfmOutput.right.point =
                 projectionOnPlane(grfmOutput.right.point, grfOrigin);
@@ -289,6 +351,17 @@ void run() {
 
     cout << "Mean delay: " << double(sumDelayMS) / sumDelayMSCounter << " ms"
          << endl;
+    cout << "Mean station Jacobian detector delay: "
+         << sumJacobianDelayUS / sumDelayMSCounter << " us" << endl;
+    double jacobianPhaseAgreement =
+            double(jacobianPhaseMatches) / sumDelayMSCounter;
+    cout << "Station Jacobian detector phase agreement: "
+         << 100.0 * jacobianPhaseAgreement << " %" << endl;
+    if (jacobianPhaseAgreement < jacobianMinPhaseAgreement)
+        THROW_EXCEPTION("The station Jacobian detector phases agree in " +
+                        to_string(100.0 * jacobianPhaseAgreement) +
+                        " % of the frames, less than " +
+                        to_string(100.0 * jacobianMinPhaseAgreement) + " %");
 
     // // store results
     // STOFileAdapter::write(grfRightLogger,
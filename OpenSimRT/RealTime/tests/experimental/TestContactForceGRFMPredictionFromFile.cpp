@@ -26,6 +26,7 @@
  * @author Filip Konstantinos <filip.k@ece.upatras.gr>
  */
 #include "ContactForceBasedPhaseDetector.h"
+#include "Exception.h"
 #include "GRFMPrediction.h"
 #include "INIReader.h"
 #include "OpenSimUtils.h"
@@ -176,6 +177,15 @@ void run() {
     detectorParameters.lFootBodyName = lFootBodyName;
     auto detector = ContactForceBasedPhaseDetector(model, detectorParameters);
 
+    // the geometric method evaluates the same contact model from the
+    // kinematics, thus the detected events must match
+    auto geometricDetectorParameters = detectorParameters;
+    geometricDetectorParameters.method =
+            ContactForceBasedPhaseDetector::Method::GEOMETRIC;
+    auto geometricDetector =
+            ContactForceBasedPhaseDetector(model, geometricDetectorParameters);
+    double sumGeometricDelayUS = 0;
+
     // grfm prediction
     GRFMPrediction::Parameters grfmParameters;
     grfmParameters.method = GRFMPrediction::selectMethod(grfmMethod);
@@ -242,6 +252,19 @@ void run() {
                 chrono::duration_cast<chrono::milliseconds>(t2 - t1).count();
         sumDelayMSCounter++;
 
+        // compare with the geometric method
+        t1 = chrono::high_resolution_clock::now();
+        geometricDetector.updDetector({ikFiltered.t, q, qDot, qDDot});
+        t2 = chrono::high_resolution_clock::now();
+        sumGeometricDelayUS +=
+                chrono::duration<double, micro>(t2 - t1).count();
+        if (geometricDetector.getPhase() != detector.getPhase() ||
+            geometricDetector.getHeelStrikeTime() !=
+                    detector.getHeelStrikeTime() ||
+            geometricDetector.getToeOffTime() != detector.getToeOffTime())
+            THROW_EXCEPTION("Geometric contact events do not match at t = " +
+                            to_string(ikFiltered.t));
+
         // project on plane
         grfmOutput.right.point =
                 projectionOnPlane(grfmOutput.right.point, grfOrigin);
@@ -275,6 +298,8 @@ void run() {
 
     cout << "Mean delay: " << double(sumDelayMS) / sumDelayMSCounter << " ms"
          << endl;
+    cout << "Mean geometric detector delay: "
+         << sumGeometricDelayUS / sumDelayMSCounter << " us" << endl;
 
     // // store results
     // STOFileAdapter::write(
@@ -0,0 +1,325 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestMarkerReconstructionBenchmark.cpp
+ *
+ * @brief Benchmark the missing marker reconstruction methods under heavy
+ * occlusion. Markers of a recorded motion are randomly occluded in each frame
+ * and reconstructed with the closest markers and the rigid body methods. The
+ * mean execution time per frame and the error with respect to the recorded
+ * positions are reported. The closest markers method is also checked against a
+ * reference (the previous name-based implementation) on the same frames.
+ *
+ * @author Filip Konstantinos <filip.k@ece.upatras.gr>
+ */
+#include "Exception.h"
+#include "INIReader.h"
+#include "InverseKinematics.h"
+#include "MarkerReconstruction.h"
+#include "Settings.h"
+#include <Actuators/Thelen2003Muscle.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+/**
+ * Reference closest markers reconstruction: the previous implementation of
+ * MarkerReconstruction that looks up and sorts the markers of the body by name
+ * in every frame. Kept to check that the index-based implementation gives the
+ * same output.
+ */
+class ReferenceReconstruction {
+ public:
+    ReferenceReconstruction(
+            const Model& model,
+            const vector<InverseKinematics::MarkerTask>& markerTasks) {
+        for (const auto& task : markerTasks) {
+            const auto& marker = model.getMarkerSet().get(task.name);
+            markersPerBodyMap.emplace(marker.getParentFrameName(), task.name);
+            bodies[task.name] = marker.getParentFrameName();
+            observationOrder.push_back(task.name);
+        }
+        for (const auto& iTask : markerTasks) {
+            const auto& iMarker = model.getMarkerSet().get(iTask.name);
+            auto range = markersPerBodyMap.equal_range(bodies[iTask.name]);
+            for (auto itr = range.first; itr != range.second; ++itr) {
+                const auto& jMarker = model.getMarkerSet().get(itr->second);
+                markerDistanceTable[iTask.name][itr->second] =
+                        jMarker.get_location() - iMarker.get_location();
+            }
+        }
+    }
+
+    void initState(const Array_<Vec3>& markerObservations) {
+        if (previousObservations.empty())
+            previousObservations = markerObservations;
+    }
+
+    void solve(Array_<Vec3>& currentObservations) {
+        for (int i = 0; i < currentObservations.size(); ++i) {
+            if (currentObservations[i].isFinite()) continue;
+            auto indices = findClosestMarkers(i, currentObservations, 3);
+            if (indices.empty()) {
+                currentObservations[i] = previousObservations[i];
+            } else if (indices.size() == 1) {
+                auto d1x = previousObservations[indices[0]] -
+                           previousObservations[i];
+                currentObservations[i] = currentObservations[indices[0]] - d1x;
+            } else if (indices.size() == 2) {
+                reconstructFromTwo(currentObservations, i, indices[0],
+                                   indices[1]);
+            } else {
+                reconstructFromThree(currentObservations, i, indices);
+            }
+        }
+        previousObservations = currentObservations;
+    }
+
+ private:
+    int indexOf(const string& name) const {
+        return distance(observationOrder.cbegin(),
+                        find(observationOrder.cbegin(), observationOrder.cend(),
+                             name));
+    }
+
+    vector<int> findClosestMarkers(const int& i,
+                                   const Array_<Vec3>& currentObservations,
+                                   int numMarkers) {
+        const auto& mMarkerName = observationOrder[i];
+        vector<string> markersInBody;
+        auto range = markersPerBodyMap.equal_range(bodies[mMarkerName]);
+        for (auto itr = range.first; itr != range.second; ++itr) {
+            if (currentObservations[indexOf(itr->second)].isFinite())
+                markersInBody.push_back(itr->second);
+        }
+        sort(markersInBody.begin(), markersInBody.end(),
+             [&](const string& iMarker, const string& jMarker) {
+                 return markerDistanceTable[mMarkerName][iMarker].norm() <
+                        markerDistanceTable[mMarkerName][jMarker].norm();
+             });
+        vector<int> output;
+        numMarkers = min((int) markersInBody.size(), numMarkers);
+        for (int j = 0; j < numMarkers; ++j)
+            output.push_back(indexOf(markersInBody[j]));
+        return output;
+    }
+
+    void reconstructFromTwo(Array_<Vec3>& currentObservations, const int& i,
+                            const int& id1, const int& id2) {
+        auto d1x = previousObservations[id1] - previousObservations[i];
+        auto d2x = previousObservations[id2] - previousObservations[i];
+        Vec3 x_tilde = ((currentObservations[id1] - d1x) +
+                        (currentObservations[id2] - d2x)) /
+                       2.0;
+
+        // intersection of the spheres centered at the known markers
+        const auto& o1 = currentObservations[id1];
+        const auto& o2 = currentObservations[id2];
+        double r1 = d1x.norm(), r2 = d2x.norm();
+        double d = (o1 - o2).norm();
+        if (d > r1 + r2 || d < abs(r1 - r2)) {
+            currentObservations[i] = x_tilde;
+            return;
+        }
+        Vec3 d_hat = (o2 - o1).normalize();
+        double a = (pow(r1, 2) - pow(r2, 2) + pow(d, 2)) / (2.0 * d);
+        Vec3 p = o1 + a * d_hat;
+        double h = sqrt(r1 * r1 - a * a);
+
+        // closest point of the circle to x_tilde
+        Vec3 vec_prime = x_tilde - dot(x_tilde - p, d_hat) * d_hat;
+        currentObservations[i] = p + (vec_prime - p).normalize() * h;
+    }
+
+    void reconstructFromThree(Array_<Vec3>& currentObservations, const int& i,
+                              const vector<int>& indices) {
+        Matrix A(3, 3), B(3, 3);
+        for (int j = 0; j < 3; ++j) {
+            A.updCol(j) = Vector(3, &previousObservations[indices[j]][0]);
+            B.updCol(j) = Vector(3, &currentObservations[indices[j]][0]);
+        }
+        const auto centroid_A = A.rowSum() / A.ncol();
+        const auto centroid_B = B.rowSum() / B.ncol();
+        for (int j = 0; j < 3; ++j) {
+            A.updCol(j) -= centroid_A;
+            B.updCol(j) -= centroid_B;
+        }
+
+        Matrix rightVectors, leftVectors;
+        Vector singularValues;
+        FactorSVD svd(A * (~B));
+        svd.getSingularValuesAndVectors(singularValues, leftVectors,
+                                        rightVectors);
+        Matrix R = (~rightVectors) * (~leftVectors);
+        if (det(Mat33(R(0, 0), R(0, 1), R(0, 2), R(1, 0), R(1, 1), R(1, 2),
+                      R(2, 0), R(2, 1), R(2, 2))) < 0) {
+            rightVectors[2] *= -1;
+            R = (~rightVectors) * (~leftVectors);
+        }
+        auto t = centroid_B - R * centroid_A;
+        auto estimate = R * Vector(previousObservations[i]) + t;
+        currentObservations[i] = Vec3(estimate[0], estimate[1], estimate[2]);
+    }
+
+    map<string, map<string, Vec3>> markerDistanceTable;
+    multimap<string, string> markersPerBodyMap;
+    map<string, string> bodies;
+    vector<string> observationOrder;
+    Array_<Vec3> previousObservations;
+};
+
+/**
+ * Check that the closest markers method reconstructs the same positions as the
+ * reference implementation in every frame.
+ */
+void compareWithReference(
+        const Model& model,
+        const vector<InverseKinematics::MarkerTask>& markerTasks,
+        const vector<Array_<Vec3>>& occluded) {
+    MarkerReconstruction mmr(model, markerTasks,
+                             MarkerReconstruction::Method::CLOSEST_MARKERS);
+    ReferenceReconstruction reference(model, markerTasks);
+    const double tolerance = 1e-9; // m
+    double maxDifference = 0;
+    Array_<Vec3> markers, expected;
+    for (int i = 0; i < occluded.size(); ++i) {
+        if (!mmr.initState(occluded[i])) continue;
+        reference.initState(occluded[i]);
+        markers = occluded[i];
+        expected = occluded[i];
+        mmr.solve(markers);
+        reference.solve(expected);
+        for (int j = 0; j < markers.size(); ++j) {
+            double difference = (markers[j] - expected[j]).norm();
+            maxDifference = max(maxDifference, difference);
+            if (!(difference <= tolerance))
+                THROW_EXCEPTION("marker " + to_string(j) + " of frame " +
+                                to_string(i) +
+                                " differs from the reference by " +
+                                to_string(difference) + " m");
+        }
+    }
+    cout << "closest markers: max difference from reference: " << maxDifference
+         << " m" << endl;
+}
+
+/**
+ * Reconstruct the occluded frames with the given method, and report the mean
+ * time per frame and the RMS error of the reconstructed markers.
+ */
+void benchmark(const string& name, const Model& model,
+               const vector<InverseKinematics::MarkerTask>& markerTasks,
+               const MarkerReconstruction::Method& method,
+               const vector<Array_<Vec3>>& recorded,
+               const vector<Array_<Vec3>>& occluded) {
+    MarkerReconstruction mmr(model, markerTasks, method);
+    Array_<Vec3> markers;
+    double squaredError = 0, duration = 0;
+    int reconstructed = 0, frames = 0;
+    for (int i = 0; i < occluded.size(); ++i) {
+        if (!mmr.initState(occluded[i])) continue;
+        markers = occluded[i];
+        auto t1 = chrono::steady_clock::now();
+        mmr.solve(markers);
+        auto t2 = chrono::steady_clock::now();
+        duration += chrono::duration<double, micro>(t2 - t1).count();
+        frames++;
+
+        // error of the reconstructed markers
+        for (int j = 0; j < markers.size(); ++j) {
+            if (!markers[j].isFinite())
+                THROW_EXCEPTION(name + ": marker " + to_string(j) +
+                                " was not reconstructed in frame " +
+                                to_string(i));
+            if (!occluded[i][j].isFinite()) {
+                squaredError += (markers[j] - recorded[i][j]).normSqr();
+                reconstructed++;
+            }
+        }
+    }
+    if (frames == 0) THROW_EXCEPTION(name + ": no valid initial frame");
+    cout << name << ": " << duration / frames << " us/frame, "
+         << reconstructed << " markers reconstructed, RMS error: "
+         << sqrt(squaredError / max(reconstructed, 1)) << endl;
+}
+
+void run() {
+    // subject data
+    INIReader ini(INI_FILE);
+    auto section = "TEST_MISSING_MARKER_RECONSTRUCTION_FROM_FILE";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+    auto occlusionProbability =
+            ini.getReal(section, "BENCHMARK_OCCLUSION_PROBABILITY", 0.5);
+
+    // setup model
+    Object::RegisterType(Thelen2003Muscle());
+    Model model(modelFile);
+
+    // read marker data from file
+    MarkerData markerData(trcFile);
+
+    // prepare marker tasks
+    vector<InverseKinematics::MarkerTask> markerTasks;
+    vector<string> observationOrder;
+    InverseKinematics::createMarkerTasksFromMarkerData(
+            model, markerData, markerTasks, observationOrder);
+
+    // occlude markers randomly (fixed seed), except in the first frame that
+    // initializes the reconstruction
+    mt19937 generator(0);
+    bernoulli_distribution occlusion(occlusionProbability);
+    vector<Array_<Vec3>> recorded, occluded;
+    for (int i = 0; i < markerData.getNumFrames(); ++i) {
+        auto ikFrame = InverseKinematics::getFrameFromMarkerData(
+                i, markerData, observationOrder, false);
+        recorded.push_back(ikFrame.markerObservations);
+        occluded.push_back(ikFrame.markerObservations);
+        if (i == 0) continue;
+        for (auto& marker : occluded.back()) {
+            if (occlusion(generator)) marker = Vec3(NaN);
+        }
+    }
+
+    benchmark("closest markers", model, markerTasks,
+              MarkerReconstruction::Method::CLOSEST_MARKERS, recorded,
+              occluded);
+    compareWithReference(model, markerTasks, occluded);
+    benchmark("rigid body", model, markerTasks,
+              MarkerReconstruction::Method::RIGID_BODY, recorded, occluded);
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -22,13 +22,17 @@
  * @brief Tests the RealTimeAnalysisExtended class with data acquired from file.
  * Observed delay (with GRFMPredition) = ~19ms without SO + JR, ~31ms with
  * enabled SO + JR (test with Ubuntu 20.04, Intel(R) Core(TM) i7-9750H CPU @
- * 2.60GHz)
+ * 2.60GHz). The pipeline is run once with the contact model and once with
+ * the geometric phase detector (on a model state shared with the GRF&M
+ * prediction).
  *
  * @author Filip Konstantinos <filip.k@ece.upatras.gr>
  */
 #include "ContactForceBasedPhaseDetector.h"
+#include "FrameReplay.h"
 #include "INIReader.h"
 #include "JointReaction.h"
+#include "PerformanceGate.h"
 #include "RealTimeAnalysisExtended.h"
 #include "Settings.h"
 #include "Visualization.h"
@@ -42,7 +46,9 @@ using namespace SimTK;
 using namespace OpenSim;
 using namespace OpenSimRT;
 
-void run(char const* name) {
+void run(const PerformanceGate& gate,
+         const ContactForceBasedPhaseDetector::Method& detectorMethod,
+         const string& name) {
     INIReader ini(INI_FILE);
     auto section = "TEST_RT_EXTENDED_PIPELINE_FROM_FILE";
     auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
@@ -180,22 +186,17 @@ void run(char const* name) {
     wrenchParameters.push_back(grfRightFootPar);
     wrenchParameters.push_back(grfLeftFootPar);
 
-    // acquisition function (simulates acquisition from motion)
-    auto dataAcquisitionFunction = [&]() -> MotionCaptureInput {
-        static int i = 0;
+    // recorded frames (simulates acquisition from motion)
+    auto getFrame = [&](const int& i) -> MotionCaptureInput {
         MotionCaptureInput input;
-
-        // get frame data
         input.IkFrame = InverseKinematics::getFrameFromMarkerData(
                 i, markerData, observationOrder, false);
-        double t = input.IkFrame.t;
-
-        // dummy delay to simulate real time
-        this_thread::sleep_for(10ms);
-        i++;
         return input;
     };
 
+    // replay of the frames (lock-step for the performance gate)
+    FrameReplay frameReplay(gate.isEnabled());
+
     // initialize filter parameters
     LowPassSmoothFilter::Parameters filterParameters;
     filterParameters.numSignals = dofs;
@@ -217,7 +218,19 @@ void run(char const* name) {
     detectorParameters.sphereRadius = contactSphereRadius;
     detectorParameters.rFootBodyName = rFootBodyName;
     detectorParameters.lFootBodyName = lFootBodyName;
-    auto detector = ContactForceBasedPhaseDetector(model, detectorParameters);
+    detectorParameters.method = detectorMethod;
+
+    // the geometric detector and the grfm prediction share a model state that
+    // the pipeline realizes once per frame, while the contact model detector
+    // simulates its own copy of the model
+    shared_ptr<ModelStateContext> modelStateContext;
+    if (detectorMethod == ContactForceBasedPhaseDetector::Method::GEOMETRIC)
+        modelStateContext = make_shared<ModelStateContext>(model);
+    auto detector =
+            modelStateContext
+                    ? ContactForceBasedPhaseDetector(modelStateContext,
+                                                     detectorParameters)
+                    : ContactForceBasedPhaseDetector(model, detectorParameters);
 
     // grfm prediction
     GRFMPrediction::Parameters grfmParameters;
@@ -248,13 +261,16 @@ void run(char const* name) {
     pipelineParameters.muscleOptimizationParameters =
             muscleOptimizationParameters;
     pipelineParameters.wrenchParameters = wrenchParameters;
-    pipelineParameters.dataAcquisitionFunction = dataAcquisitionFunction;
+    pipelineParameters.dataAcquisitionFunction = [&]() {
+        return frameReplay.acquire();
+    };
     pipelineParameters.momentArmFunction = calcMomentArm;
     pipelineParameters.useGRFMPrediction = useGRFMPrediction;
     pipelineParameters.phaseDetector = detector;
     pipelineParameters.detectorUpdateMethod =
             RealTimeAnalysisExtended::PhaseDetectorUpdateMethod::INTERNAL;
     pipelineParameters.grfmParameters = grfmParameters;
+    pipelineParameters.modelStateContext = modelStateContext;
     pipelineParameters.internalPhaseDetectorUpdateFunction =
             [&](const double& t, const SimTK::Vector& q,
                 const SimTK::Vector& qd, const SimTK::Vector& qdd) {
@@ -264,6 +280,7 @@ void run(char const* name) {
     auto log = pipeline.initializeLoggers();
 
     // run pipeline
+    auto start = monotonicNanoseconds();
     pipeline.run();
 
     // visualizer
@@ -277,6 +294,9 @@ void run(char const* name) {
     auto leftKneeForceDecorator = new ForceDecorator(Red, 0.0005, 3);
     visualizer.addDecorationGenerator(leftKneeForceDecorator);
 
+    // replay the frames
+    frameReplay.start(pipeline, markerData.getNumFrames(), getFrame);
+
     // mean delay
     int sumDelayMS = 0;
     int sumDelayMSCount = 0;
@@ -319,15 +339,23 @@ void run(char const* name) {
                 log.jrLogger.appendRow(results.t,
                                        ~results.reactionWrenchVector);
             }
-
+            frameReplay.resultHandled();
         } // while loop
     } catch (const exception& e) {
         cout << e.what() << "\n";
         pipeline.shouldTerminate(true);
     }
+    frameReplay.join();
+    auto duration = (monotonicNanoseconds() - start) * 1e-9;
 
     cout << "Mean delay: " << (double) sumDelayMS / sumDelayMSCount << " ms"
          << endl;
+    pipeline.printLatencyStatistics(cout);
+    gate.submit(PerformanceReport::fromLatencies(
+            name,
+            pipeline.getLatencyStatistics(
+                    RealTimeAnalysis::LatencyStage::TOTAL),
+            duration));
 
     // store results
     // STOFileAdapter::write(log.qLogger,
@@ -395,7 +423,12 @@ void run(char const* name) {
 }
 int main(int argc, char* argv[]) {
     try {
-        run(argc > 1 ? argv[1] : nullptr);
+        PerformanceGate gate(argc, argv, INI_FILE, DATA_DIR,
+                             LIBRARY_OUTPUT_PATH);
+        run(gate, ContactForceBasedPhaseDetector::Method::CONTACT_MODEL,
+            "TestRTExtFromFile");
+        run(gate, ContactForceBasedPhaseDetector::Method::GEOMETRIC,
+            "TestRTExtFromFileGeometric");
     } catch (exception& e) {
         cout << e.what() << endl;
         return -1;
@@ -25,6 +25,7 @@
  */
 #include "INIReader.h"
 #include "Settings.h"
+#include "ViconClientDataSource.h"
 #include "ViconDataStream.h"
 #include <iostream>
 
@@ -44,31 +45,35 @@ void run() {
     auto referenceFrameZ = ini.getString("VICON", "REFERENCE_FRAME_AXIS_Z", "");
 
     // setup vicon
+    auto client = make_shared<ViconClientDataSource>();
+    client->connect(hostName);
+    client->initialize(stringToDirection(referenceFrameX),
+                       stringToDirection(referenceFrameY),
+                       stringToDirection(referenceFrameZ));
     ViconDataStream vicon(
-            vector<Vec3>{Vec3(forcePlate00X, forcePlate00Y, forcePlate00Z)});
-    vicon.connect(hostName);
-    vicon.initialize(stringToDirection(referenceFrameX),
-                     stringToDirection(referenceFrameY),
-                     stringToDirection(referenceFrameZ));
+            vector<Vec3>{Vec3(forcePlate00X, forcePlate00Y, forcePlate00Z)},
+            client);
+    vicon.initialize();
     vicon.startAcquisition();
 
     double previousTime = -1.0;
-    while (true) {
-        auto markerData = vicon.markerBuffer.get(1)[0];
+    while (!vicon.shouldTerminate) {
+        auto markerData = vicon.markerBuffer.getLatest();
         auto forceData = vicon.forceBuffer.get(10, true)[0];
 
         double t = forceData.time;
         if (previousTime >= t) { continue; }
         cout << "time: " << t << endl;
 
-        for (auto marker : markerData.markers) {
-            cout << marker.first << " " << marker.second << endl;
+        for (size_t i = 0; i < markerData.markers.size(); ++i) {
+            cout << vicon.markerNames[i] << " " << markerData.markers[i]
+                 << endl;
         }
 
-        for (auto wrench : forceData.externalWrenches) {
-            cout << wrench.first << " p: " << wrench.second.point
-                 << " f: " << wrench.second.force
-                 << " t: " << wrench.second.torque << endl;
+        for (size_t i = 0; i < forceData.externalWrenches.size(); ++i) {
+            const auto& wrench = forceData.externalWrenches[i];
+            cout << vicon.forcePlateNames[i] << " p: " << wrench.point
+                 << " f: " << wrench.force << " t: " << wrench.torque << endl;
         }
         previousTime = t;
     }
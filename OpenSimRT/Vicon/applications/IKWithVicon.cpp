@@ -26,6 +26,7 @@
 #include "INIReader.h"
 #include "InverseKinematics.h"
 #include "Settings.h"
+#include "ViconClientDataSource.h"
 #include "ViconDataStream.h"
 #include "Visualization.h"
 #include <iostream>
@@ -49,12 +50,15 @@ void run() {
     auto modelFile = subjectDir + ini.getString("VICON", "MODEL_FILE", "");
 
     // setup vicon
+    auto client = make_shared<ViconClientDataSource>();
+    client->connect(hostName);
+    client->initialize(stringToDirection(referenceFrameX),
+                       stringToDirection(referenceFrameY),
+                       stringToDirection(referenceFrameZ));
     ViconDataStream vicon(
-            vector<Vec3>{Vec3(forcePlate00X, forcePlate00Y, forcePlate00Z)});
-    vicon.connect(hostName);
-    vicon.initialize(stringToDirection(referenceFrameX),
-                     stringToDirection(referenceFrameY),
-                     stringToDirection(referenceFrameZ));
+            vector<Vec3>{Vec3(forcePlate00X, forcePlate00Y, forcePlate00Z)},
+            client);
+    vicon.initialize();
 
     // prepare marker tasks
     Model model(modelFile);
@@ -65,22 +69,27 @@ void run() {
 
     InverseKinematics ik(model, markerTasks, {}, SimTK::Infinity, 1e-5);
 
+    // map the observation order to the marker indices of the Vicon frames
+    vector<int> observationIndices;
+    for (const auto& markerName : observationOrder) {
+        observationIndices.push_back(vicon.getMarkerIndex(markerName));
+    }
+
     // visualizer
     BasicModelVisualizer visualizer(model);
 
     vicon.startAcquisition();
     double previousTime = -1.0;
-    while (true) {
-        auto markerData = vicon.markerBuffer.get(1)[0];
+    while (!vicon.shouldTerminate) {
+        auto markerData = vicon.markerBuffer.getLatest();
         double t = markerData.time;
         if (previousTime >= t) { continue; }
 
         // ik
         InverseKinematics::Input ikInput;
         ikInput.t = t;
-        for (auto markerName : observationOrder) {
-            ikInput.markerObservations.push_back(
-                    markerData.markers[markerName]);
+        for (auto i : observationIndices) {
+            ikInput.markerObservations.push_back(markerData.markers[i]);
         }
         auto ikOutput = ik.solve(ikInput);
 
@@ -0,0 +1,187 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file IKWithViconSimulator.cpp
+ *
+ * \brief Inverse kinematics from a simulated Vicon stream (replay of recorded
+ * markers and ground reaction forces, or synthetic data). Reports the latency
+ * from the acquisition of a frame until the IK solution, and the number of
+ * frames that were not processed because newer frames were available.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "INIReader.h"
+#include "InverseKinematics.h"
+#include "Settings.h"
+#include "ViconDataStream.h"
+#include "ViconSimulatedDataSource.h"
+#include <OpenSim/Simulation/Model/Model.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <numeric>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+void run() {
+    INIReader ini(INI_FILE);
+    auto section = "VICON_SIMULATOR";
+    auto source = ini.getString(section, "SOURCE", "REPLAY");
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto modelFile = subjectDir + ini.getString(section, "MODEL_FILE", "");
+    auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+    auto grfMotFile = subjectDir + ini.getString(section, "GRF_MOT_FILE", "");
+    auto grfRightPointIdentifier =
+            ini.getString(section, "GRF_RIGHT_POINT_IDENTIFIER", "");
+    auto grfRightForceIdentifier =
+            ini.getString(section, "GRF_RIGHT_FORCE_IDENTIFIER", "");
+    auto grfRightTorqueIdentifier =
+            ini.getString(section, "GRF_RIGHT_TORQUE_IDENTIFIER", "");
+    auto grfLeftPointIdentifier =
+            ini.getString(section, "GRF_LEFT_POINT_IDENTIFIER", "");
+    auto grfLeftForceIdentifier =
+            ini.getString(section, "GRF_LEFT_FORCE_IDENTIFIER", "");
+    auto grfLeftTorqueIdentifier =
+            ini.getString(section, "GRF_LEFT_TORQUE_IDENTIFIER", "");
+    auto forcePlateSubsamples =
+            ini.getInteger(section, "FORCE_PLATE_SUBSAMPLES", 10);
+    auto speed = ini.getReal(section, "SPEED", 1.0);
+    auto frameRate = ini.getReal(section, "FRAME_RATE", 100);
+    auto numFrames = ini.getInteger(section, "NUM_FRAMES", 0);
+    auto occlusionProbability =
+            ini.getReal(section, "OCCLUSION_PROBABILITY", 0.0);
+    auto ikAccuracy = ini.getReal(section, "IK_ACCURACY", 1e-5);
+
+    Model model(modelFile);
+    auto state = model.initSystem();
+
+    // setup the data source (the ground reaction forces of the recording are
+    // treated as two force plates at the origin)
+    vector<Vec3> forcePlatePositions{Vec3(0), Vec3(0)};
+    shared_ptr<ViconDataSource> dataSource;
+    if (source == "REPLAY") {
+        dataSource = make_shared<ViconFileDataSource>(
+                trcFile, grfMotFile,
+                vector<ViconFileDataSource::ForcePlate>{
+                        {"right", forcePlatePositions[0],
+                         ExternalWrench::createGRFLabelsFromIdentifiers(
+                                 grfRightPointIdentifier,
+                                 grfRightForceIdentifier,
+                                 grfRightTorqueIdentifier)},
+                        {"left", forcePlatePositions[1],
+                         ExternalWrench::createGRFLabelsFromIdentifiers(
+                                 grfLeftPointIdentifier,
+                                 grfLeftForceIdentifier,
+                                 grfLeftTorqueIdentifier)}},
+                forcePlateSubsamples, speed);
+    } else if (source == "SYNTHETIC") {
+        // the markers of the model at the default pose
+        ViconSyntheticDataSource::Parameters parameters;
+        parameters.frameRate = frameRate;
+        parameters.forcePlateSubsamples = forcePlateSubsamples;
+        parameters.forcePlatePositions = forcePlatePositions;
+        parameters.occlusionProbability = occlusionProbability;
+        parameters.speed = speed;
+        parameters.numFrames = numFrames;
+        model.realizePosition(state);
+        const auto& markerSet = model.getMarkerSet();
+        for (int i = 0; i < markerSet.getSize(); ++i) {
+            parameters.markerNames.push_back(markerSet[i].getName());
+            parameters.markerPositions.push_back(
+                    markerSet[i].getLocationInGround(state));
+        }
+        dataSource = make_shared<ViconSyntheticDataSource>(parameters);
+    } else {
+        THROW_EXCEPTION("unsupported data source: " + source);
+    }
+
+    ViconDataStream vicon(forcePlatePositions, dataSource);
+    vicon.initialize();
+
+    // prepare marker tasks
+    vector<InverseKinematics::MarkerTask> markerTasks;
+    vector<string> observationOrder;
+    InverseKinematics::createMarkerTasksFromMarkerNames(
+            model, vicon.markerNames, markerTasks, observationOrder);
+    vector<int> observationIndices;
+    for (const auto& markerName : observationOrder) {
+        observationIndices.push_back(vicon.getMarkerIndex(markerName));
+    }
+    InverseKinematics ik(model, markerTasks, {}, SimTK::Infinity, ikAccuracy);
+
+    // acquire and solve until the end of the stream
+    vector<double> latencies;
+    int processed = 0, skipped = 0;
+    double previousTime = -1.0;
+    const double rate = dataSource->getFrameRate();
+    vicon.startAcquisition();
+    while (!vicon.shouldTerminate) {
+        auto markerData = vicon.markerBuffer.getLatest();
+        double t = markerData.time;
+        if (previousTime >= t) { continue; }
+        if (previousTime >= 0)
+            skipped += max(0, int(round((t - previousTime) * rate)) - 1);
+
+        InverseKinematics::Input ikInput;
+        ikInput.t = t;
+        for (auto i : observationIndices) {
+            ikInput.markerObservations.push_back(markerData.markers[i]);
+        }
+        auto ikOutput = ik.solve(ikInput);
+
+        auto now = chrono::duration<double>(
+                           chrono::steady_clock::now().time_since_epoch())
+                           .count();
+        latencies.push_back(now - markerData.receiveTime);
+        previousTime = t;
+        processed++;
+    }
+    if (latencies.empty()) THROW_EXCEPTION("no frames were processed");
+
+    // report
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return 1000 * latencies[int(p * (latencies.size() - 1))];
+    };
+    cout << "source: " << source << " at " << rate << " Hz" << endl;
+    cout << "frames processed: " << processed << ", skipped: " << skipped
+         << endl;
+    auto statistics = vicon.getAcquisitionStatistics();
+    cout << "frames acquired: " << statistics.frames
+         << ", idle waits: " << statistics.idleWaits << endl;
+    cout << "latency (ms) mean: "
+         << 1000 *
+                    accumulate(latencies.begin(), latencies.end(), 0.0) /
+                    latencies.size()
+         << ", p50: " << percentile(0.5) << ", p99: " << percentile(0.99)
+         << ", max: " << 1000 * latencies.back() << endl;
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file ViconClientDataSource.h
+ *
+ * \brief Vicon data source that connects to a Vicon server using the Vicon
+ * DataStream SDK.
+ *
+ * Acknowledgement: This class has been mainly adapted from the RTOSIM project
+ * [https://github.com/RealTimeBiomechanics/rtosim] by Pizzolato et al.
+ * http://dx.doi.org/10.1080/10255842.2016.1240789
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "ViconDataSource.h"
+#include <DataStreamClient.h>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Acquires frames from a Vicon server (DataStream SDK client).
+ */
+class Vicon_API ViconClientDataSource : public ViconDataSource {
+ public:
+    void connect(std::string hostName);
+    void initialize(ViconDataStreamSDK::CPP::Direction::Enum xAxis,
+                    ViconDataStreamSDK::CPP::Direction::Enum yAxis,
+                    ViconDataStreamSDK::CPP::Direction::Enum zAxis);
+
+    bool getFrame(double timeout) override;
+    unsigned int getFrameNumber() const override;
+    double getFrameRate() const override;
+    std::vector<std::string> getMarkerNames() const override;
+    bool getMarkerGlobalTranslation(int marker,
+                                    SimTK::Vec3& translation) const override;
+    std::vector<std::string> getForcePlateNames() const override;
+    int getForcePlateSubsamples(int plate) const override;
+    SimTK::Vec3 getGlobalForceVector(int plate, int subsample) const override;
+    SimTK::Vec3 getGlobalMomentVector(int plate, int subsample) const override;
+    SimTK::Vec3 getGlobalCentreOfPressure(int plate,
+                                          int subsample) const override;
+
+ private:
+    // the client queries are not const in the SDK
+    mutable ViconDataStreamSDK::CPP::Client client;
+    std::string subjectName;
+    bool subjectFound = false; // single subject in the current frame
+    std::vector<std::string> markerNames;
+    std::vector<std::string> forcePlateNames;
+};
+
+/**
+ * Convert string to Direction::Enum. The direction must have the same name as:
+ *
+ * # enum Enum
+ * {
+ *   Up,
+ *   Down,
+ *   Left,
+ *   Right,
+ *   Forward,
+ *   Backward
+ * };
+ */
+Vicon_API ViconDataStreamSDK::CPP::Direction::Enum
+stringToDirection(std::string direction);
+
+} // namespace OpenSimRT
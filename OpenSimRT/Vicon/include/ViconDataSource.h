@@ -0,0 +1,86 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file ViconDataSource.h
+ *
+ * \brief An abstraction over the Vicon DataStream client calls that are used
+ * for marker and force plate acquisition.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "internal/ViconExports.h"
+#include <SimTKcommon.h>
+#include <string>
+#include <vector>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Source of Vicon frames (marker positions and force plate
+ * measurements). A frame is fetched with getFrame() and is then queried with
+ * the remaining functions, similar to the Vicon DataStream client. Values use
+ * the conventions of the DataStream SDK: marker translations in mm, force
+ * plate forces and moments (about the force plate origin) as applied on the
+ * force plate, and centre of pressure in m, all expressed in the global frame.
+ */
+class Vicon_API ViconDataSource {
+ public:
+    virtual ~ViconDataSource() = default;
+
+    /**
+     * Fetch the next frame. Blocks (without consuming CPU) until a frame is
+     * available or `timeout` (seconds) has elapsed. Returns false if a frame
+     * could not be obtained within the timeout (the call can be repeated).
+     */
+    virtual bool getFrame(double timeout) = 0;
+
+    /**
+     * Determine if the source has no more frames (e.g., end of a recording).
+     */
+    virtual bool endOfStream() const { return false; }
+
+    virtual unsigned int getFrameNumber() const = 0;
+    virtual double getFrameRate() const = 0;
+
+    /**
+     * Names of the markers of the (single) subject. The order defines the
+     * marker indices.
+     */
+    virtual std::vector<std::string> getMarkerNames() const = 0;
+
+    /**
+     * Global position of the i-th marker of the current frame. Returns false
+     * if the marker is occluded.
+     */
+    virtual bool getMarkerGlobalTranslation(int marker,
+                                            SimTK::Vec3& translation) const = 0;
+
+    virtual std::vector<std::string> getForcePlateNames() const = 0;
+    virtual int getForcePlateSubsamples(int plate) const = 0;
+    virtual SimTK::Vec3 getGlobalForceVector(int plate,
+                                             int subsample) const = 0;
+    virtual SimTK::Vec3 getGlobalMomentVector(int plate,
+                                              int subsample) const = 0;
+    virtual SimTK::Vec3 getGlobalCentreOfPressure(int plate,
+                                                  int subsample) const = 0;
+};
+
+} // namespace OpenSimRT
@@ -31,65 +31,115 @@
 
 #include "CircularBuffer.h"
 #include "InverseDynamics.h"
+#include "ViconDataSource.h"
 #include "internal/ViconExports.h"
-#include <DataStreamClient.h>
 #include <SimTKcommon.h>
-#include <map>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace OpenSimRT {
 /**
- * \brief Connects with Vicon server and collects marker and force plate forces.
+ * \brief Collects marker and force plate forces from a Vicon data source (e.g.,
+ * a Vicon server through the ViconClientDataSource, or a simulated source).
  */
 class Vicon_API ViconDataStream {
  public:
+    /**
+     * Marker positions of a frame. The i-th element corresponds to
+     * markerNames[i] (NaN if occluded).
+     */
     struct MarkerData {
         double time;
-        std::map<std::string, SimTK::Vec3> markers;
+        double receiveTime; // host time when the frame was acquired (seconds
+                            // of a monotonic clock), e.g., for latency
+        std::vector<SimTK::Vec3> markers;
     };
 
+    /**
+     * Force plate measurements of a (sub)frame. The i-th element corresponds
+     * to forcePlateNames[i].
+     */
     struct ForceData {
         double time;
-        std::map<std::string, ExternalWrench::Input> externalWrenches;
+        std::vector<ExternalWrench::Input> externalWrenches;
     };
 
-    ViconDataStream(std::vector<SimTK::Vec3> labForcePlatePositions);
+    /**
+     * The data source must be connected and configured (see
+     * ViconClientDataSource).
+     */
+    ViconDataStream(std::vector<SimTK::Vec3> labForcePlatePositions,
+                    std::shared_ptr<ViconDataSource> dataSource);
 
-    void connect(std::string hostName);
-    void initialize(ViconDataStreamSDK::CPP::Direction::Enum xAxis,
-                    ViconDataStreamSDK::CPP::Direction::Enum yAxis,
-                    ViconDataStreamSDK::CPP::Direction::Enum zAxis);
-    void startAcquisition();
+    /**
+     * Obtain the marker and force plate names from the data source.
+     */
+    void initialize();
+
+    /**
+     * Counters of the acquisition thread. An idle wait is a request to the
+     * data source that timed out without a new frame.
+     */
+    struct AcquisitionStatistics {
+        long long frames;
+        long long idleWaits;
+    };
+
+    /**
+     * Start a (detached) acquisition thread. The thread blocks on the data
+     * source for at most `timeout` seconds per request, thus it does not
+     * consume CPU while idle and checks shouldTerminate at least once per
+     * timeout. When the data source reaches the end of the stream,
+     * shouldTerminate is set and the buffers are switched to CONTINUOUS mode,
+     * so that the consumers are not blocked.
+     */
+    void startAcquisition(double timeout = 0.1);
+
+    /**
+     * Register a function that is called by the acquisition thread after each
+     * acquired frame has been added to the buffers (e.g.,
+     * RealTimeAnalysis::notifyDataAvailable), so that the consumer can wait
+     * for data instead of polling the buffers. Must be set before
+     * startAcquisition().
+     */
+    void setDataAvailableCallback(std::function<void()> callback);
+
+    /**
+     * Thread safe access to the acquisition counters.
+     */
+    AcquisitionStatistics getAcquisitionStatistics() const;
+
+    /**
+     * Index of a marker in MarkerData::markers (throws if the marker is not
+     * streamed). Used to map the observation order of the IK to the frame
+     * once, instead of looking up markers by name in each frame.
+     */
+    int getMarkerIndex(const std::string& markerName) const;
 
     CircularBuffer<2000, MarkerData> markerBuffer;
     CircularBuffer<2000, ForceData> forceBuffer;
     std::vector<std::string> markerNames;
     std::vector<std::string> forcePlateNames;
 
-    bool shouldTerminate;
+    std::atomic_bool shouldTerminate;
 
  private:
-    void getFrame();
+    // returns false if no frame was obtained within the timeout
+    bool getFrame(double timeout);
 
-    ViconDataStreamSDK::CPP::Client client;
+    std::shared_ptr<ViconDataSource> dataSource;
     std::vector<SimTK::Vec3> labForcePlatePositions;
     int forcePlates;
     double previousMarkerDataTime, previousForceDataTime;
+    long long firstFrameNumber;
+    // frames are reused to avoid allocations during acquisition
+    MarkerData markerData;
+    ForceData forceData;
+    std::atomic<long long> acquiredFrames, idleWaits;
+    std::function<void()> dataAvailableCallback;
 };
 
-/**
- * Convert string to Direction::Enum. The direction must have the same name as:
- *
- * # enum Enum
- * {
- *   Up,
- *   Down,
- *   Left,
- *   Right,
- *   Forward,
- *   Backward
- * };
- */
-Vicon_API ViconDataStreamSDK::CPP::Direction::Enum
-stringToDirection(std::string direction);
-
 } // namespace OpenSimRT
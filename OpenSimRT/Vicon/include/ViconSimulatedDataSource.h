@@ -0,0 +1,142 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file ViconSimulatedDataSource.h
+ *
+ * \brief Vicon data sources that do not require a Vicon server: replay of
+ * recorded marker (.trc) and ground reaction force (.mot) files, and synthetic
+ * data generation. Used for testing and benchmarking the acquisition and
+ * processing without hardware.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#pragma once
+
+#include "ViconDataSource.h"
+#include <chrono>
+#include <random>
+
+namespace OpenSimRT {
+
+/**
+ * \brief Replays a .trc (markers) and a .mot (ground reaction forces) file as
+ * a Vicon stream. Frames are delivered at `speed` times the rate of the .trc
+ * file against absolute deadlines (as fast as possible if speed is not
+ * positive). The force plate measurements are interpolated at
+ * `forcePlateSubsamples` subsamples per frame and converted to the DataStream
+ * conventions, thus they are reconstructed by the ViconDataStream.
+ */
+class Vicon_API ViconFileDataSource : public ViconDataSource {
+ public:
+    struct ForcePlate {
+        std::string name;
+        SimTK::Vec3 position; // force plate origin in global frame (m)
+        // the 9 .mot labels of the point, force and torque (see
+        // ExternalWrench::createGRFLabelsFromIdentifiers)
+        std::vector<std::string> labels;
+    };
+
+    ViconFileDataSource(const std::string& trcFile,
+                        const std::string& grfMotFile,
+                        const std::vector<ForcePlate>& forcePlates,
+                        const int& forcePlateSubsamples = 10,
+                        const double& speed = 1.0);
+
+    bool getFrame(double timeout) override;
+    bool endOfStream() const override;
+    unsigned int getFrameNumber() const override;
+    double getFrameRate() const override;
+    std::vector<std::string> getMarkerNames() const override;
+    bool getMarkerGlobalTranslation(int marker,
+                                    SimTK::Vec3& translation) const override;
+    std::vector<std::string> getForcePlateNames() const override;
+    int getForcePlateSubsamples(int plate) const override;
+    SimTK::Vec3 getGlobalForceVector(int plate, int subsample) const override;
+    SimTK::Vec3 getGlobalMomentVector(int plate, int subsample) const override;
+    SimTK::Vec3 getGlobalCentreOfPressure(int plate,
+                                          int subsample) const override;
+
+ private:
+    // index of the force plate measurements of a subsample
+    int index(int frame, int plate, int subsample) const;
+
+    double frameRate;
+    double speed;
+    int numFrames;
+    int frame; // current frame (-1 before the first frame)
+    std::chrono::steady_clock::time_point startTime;
+
+    std::vector<std::string> markerNames;
+    std::vector<SimTK::Vec3> markers; // numFrames x markers (mm)
+
+    std::vector<std::string> forcePlateNames;
+    int subsamples;
+    // numFrames x plates x subsamples
+    std::vector<SimTK::Vec3> forces, moments, centresOfPressure;
+};
+
+/**
+ * \brief Generates a synthetic Vicon stream at an arbitrary rate. Markers
+ * oscillate sinusoidally around their reference positions and can be randomly
+ * occluded, while the force plates measure a periodic vertical force with a
+ * moving centre of pressure.
+ */
+class Vicon_API ViconSyntheticDataSource : public ViconDataSource {
+ public:
+    struct Parameters {
+        double frameRate = 100;
+        int forcePlateSubsamples = 10;
+        std::vector<std::string> markerNames;
+        std::vector<SimTK::Vec3> markerPositions;     // reference (m)
+        std::vector<SimTK::Vec3> forcePlatePositions; // one per plate (m)
+        SimTK::Vec3 amplitude = SimTK::Vec3(0.05);    // marker motion (m)
+        double frequency = 1.0;                       // of the motion (Hz)
+        double occlusionProbability = 0.0;
+        double speed = 1.0; // pacing (as fast as possible if not positive)
+        int numFrames = 0;  // length of the stream (infinite if 0)
+    };
+
+    ViconSyntheticDataSource(const Parameters& parameters);
+
+    bool getFrame(double timeout) override;
+    bool endOfStream() const override;
+    unsigned int getFrameNumber() const override;
+    double getFrameRate() const override;
+    std::vector<std::string> getMarkerNames() const override;
+    bool getMarkerGlobalTranslation(int marker,
+                                    SimTK::Vec3& translation) const override;
+    std::vector<std::string> getForcePlateNames() const override;
+    int getForcePlateSubsamples(int plate) const override;
+    SimTK::Vec3 getGlobalForceVector(int plate, int subsample) const override;
+    SimTK::Vec3 getGlobalMomentVector(int plate, int subsample) const override;
+    SimTK::Vec3 getGlobalCentreOfPressure(int plate,
+                                          int subsample) const override;
+
+ private:
+    double getSubsampleTime(int subsample) const;
+
+    Parameters parameters;
+    int frame; // current frame (-1 before the first frame)
+    std::chrono::steady_clock::time_point startTime;
+    std::vector<bool> occluded;
+    std::mt19937 generator;
+    std::bernoulli_distribution occlusion;
+};
+
+} // namespace OpenSimRT
@@ -0,0 +1,190 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "ViconClientDataSource.h"
+#include "Exception.h"
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace SimTK;
+using namespace OpenSimRT;
+
+using namespace ViconDataStreamSDK::CPP;
+
+/*******************************************************************************/
+
+void ViconClientDataSource::connect(string hostName) {
+    while (!client.IsConnected().Connected) {
+        if (client.Connect(hostName).Result != Result::Success) {
+            cout << "warning - connect failed..." << endl;
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+    }
+    cout << "connected to Vicon server at: " << hostName << endl;
+}
+
+void ViconClientDataSource::initialize(Direction::Enum xAxis,
+                                       Direction::Enum yAxis,
+                                       Direction::Enum zAxis) {
+    // setup data
+    client.EnableMarkerData();
+    client.EnableDeviceData(); // grf
+    client.DisableSegmentData();
+    client.DisableUnlabeledMarkerData();
+
+    // setup stream model
+    while (client.SetStreamMode(StreamMode::ClientPull).Result !=
+           Result::Success) {
+        cout << ".";
+    }
+    cout << endl;
+
+    // get force plates
+    int forcePlates = 0;
+    while (forcePlates < 1) {
+        cout << "waiting for devices..." << endl;
+        client.GetFrame();
+        auto forcePlatesInfo = client.GetForcePlateCount();
+        if (forcePlatesInfo.Result == Result::Success) {
+            forcePlates = forcePlatesInfo.ForcePlateCount;
+        }
+    }
+    cout << "found " << forcePlates << " force plates" << endl;
+    for (int i = 0; i < client.GetDeviceCount().DeviceCount; ++i) {
+        if (client.GetDeviceName(i).DeviceType == DeviceType::ForcePlate) {
+            string name = client.GetDeviceName(i).DeviceName;
+            forcePlateNames.push_back(name);
+            cout << name << endl;
+        }
+    }
+
+    // get marker names
+    do {
+        if (getFrame(1.0)) {
+            int markerCount = client.GetMarkerCount(subjectName).MarkerCount;
+            for (int i = 0; i < markerCount; ++i) {
+                markerNames.push_back(
+                        client.GetMarkerName(subjectName, i).MarkerName);
+            }
+        }
+        cout << ".";
+    } while (!subjectFound);
+    cout << "\n found " << markerNames.size() << " markers" << endl;
+
+    client.SetAxisMapping(xAxis, yAxis, zAxis);
+}
+
+bool ViconClientDataSource::getFrame(double timeout) {
+    // in ClientPull mode GetFrame blocks until the server sends the next
+    // frame, but fails immediately when no frame can be obtained (e.g., lost
+    // connection), thus back off between attempts instead of spinning
+    auto deadline = chrono::steady_clock::now() +
+                    chrono::duration_cast<chrono::steady_clock::duration>(
+                            chrono::duration<double>(timeout));
+    while (client.GetFrame().Result != Result::Success) {
+        auto retry = chrono::steady_clock::now() + chrono::milliseconds(1);
+        if (retry > deadline) return false;
+        this_thread::sleep_until(retry);
+    }
+    int subjectCount = client.GetSubjectCount().SubjectCount;
+    subjectFound = subjectCount == 1;
+    if (!subjectFound) {
+        cout << "warning: " << subjectCount
+             << " subject(s) in the capture volume" << endl;
+    } else if (subjectName.empty()) {
+        subjectName = client.GetSubjectName(0).SubjectName;
+    }
+    return true;
+}
+
+unsigned int ViconClientDataSource::getFrameNumber() const {
+    return client.GetFrameNumber().FrameNumber;
+}
+
+double ViconClientDataSource::getFrameRate() const {
+    return client.GetFrameRate().FrameRateHz;
+}
+
+vector<string> ViconClientDataSource::getMarkerNames() const {
+    return markerNames;
+}
+
+bool ViconClientDataSource::getMarkerGlobalTranslation(
+        int marker, Vec3& translation) const {
+    if (!subjectFound) return false;
+    auto output = client.GetMarkerGlobalTranslation(subjectName,
+                                                    markerNames[marker]);
+    if (output.Result != Result::Success || output.Occluded) return false;
+    translation = Vec3(output.Translation[0], output.Translation[1],
+                       output.Translation[2]);
+    return true;
+}
+
+vector<string> ViconClientDataSource::getForcePlateNames() const {
+    return forcePlateNames;
+}
+
+int ViconClientDataSource::getForcePlateSubsamples(int plate) const {
+    return client.GetForcePlateSubsamples(plate).ForcePlateSubsamples;
+}
+
+Vec3 ViconClientDataSource::getGlobalForceVector(int plate,
+                                                 int subsample) const {
+    auto output = client.GetGlobalForceVector(plate, subsample);
+    return Vec3(output.ForceVector[0], output.ForceVector[1],
+                output.ForceVector[2]);
+}
+
+Vec3 ViconClientDataSource::getGlobalMomentVector(int plate,
+                                                  int subsample) const {
+    auto output = client.GetGlobalMomentVector(plate, subsample);
+    return Vec3(output.MomentVector[0], output.MomentVector[1],
+                output.MomentVector[2]);
+}
+
+Vec3 ViconClientDataSource::getGlobalCentreOfPressure(int plate,
+                                                      int subsample) const {
+    auto output = client.GetGlobalCentreOfPressure(plate, subsample);
+    return Vec3(output.CentreOfPressure[0], output.CentreOfPressure[1],
+                output.CentreOfPressure[2]);
+}
+
+/*******************************************************************************/
+
+Direction::Enum OpenSimRT::stringToDirection(std::string direction) {
+    if (direction == "Up") {
+        return Direction::Enum::Up;
+    } else if (direction == "Down") {
+        return Direction::Enum::Down;
+    } else if (direction == "Left") {
+        return Direction::Enum::Left;
+    } else if (direction == "Right") {
+        return Direction::Enum::Right;
+    } else if (direction == "Forward") {
+        return Direction::Enum::Forward;
+    } else if (direction == "Backward") {
+        return Direction::Enum::Backward;
+    } else {
+        THROW_EXCEPTION("unsupported direction: " + direction);
+    }
+}
+
+/*******************************************************************************/
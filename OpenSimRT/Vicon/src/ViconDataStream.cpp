@@ -18,139 +18,79 @@
  * -----------------------------------------------------------------------------
  */
 #include "ViconDataStream.h"
+#include "Exception.h"
+#include <algorithm>
 #include <chrono>
 #include <functional>
-#include <map>
 #include <thread>
 
-#define MM_TO_M(x) 0.01 * x
+#define MM_TO_M(x) (0.001 * (x))
 
 using namespace std;
 using namespace SimTK;
 using namespace OpenSimRT;
 
-using namespace ViconDataStreamSDK::CPP;
-
 /*******************************************************************************/
 
-ViconDataStream::ViconDataStream(vector<Vec3> labForcePlatePositions)
-        : labForcePlatePositions(labForcePlatePositions) {
+ViconDataStream::ViconDataStream(vector<Vec3> labForcePlatePositions,
+                                 shared_ptr<ViconDataSource> dataSource)
+        : dataSource(dataSource),
+          labForcePlatePositions(labForcePlatePositions) {
     previousMarkerDataTime = -1.0;
     previousForceDataTime = -1.0;
+    firstFrameNumber = -1;
     shouldTerminate = false;
+    acquiredFrames = 0;
+    idleWaits = 0;
 }
 
-void ViconDataStream::connect(string hostName) {
-    while (!client.IsConnected().Connected) {
-        if (client.Connect(hostName).Result != Result::Success) {
-            cout << "warning - connect failed..." << endl;
-            this_thread::sleep_for(chrono::milliseconds(100));
-        }
-    }
-    cout << "connected to Vicon server at: " << hostName << endl;
+void ViconDataStream::initialize() {
+    markerNames = dataSource->getMarkerNames();
+    forcePlateNames = dataSource->getForcePlateNames();
+    forcePlates = forcePlateNames.size();
+    if (labForcePlatePositions.size() < forcePlateNames.size())
+        THROW_EXCEPTION("force plate positions are not provided for all "
+                        "force plates");
+
+    // the layout of the frames is fixed after initialization
+    markerData.markers.resize(markerNames.size());
+    forceData.externalWrenches.resize(forcePlates);
 }
 
-void ViconDataStream::initialize(Direction::Enum xAxis, Direction::Enum yAxis,
-                                 Direction::Enum zAxis) {
-    // setup data
-    client.EnableMarkerData();
-    client.EnableDeviceData(); // grf
-    client.DisableSegmentData();
-    client.DisableUnlabeledMarkerData();
-
-    // setup stream model
-    while (client.SetStreamMode(StreamMode::ClientPull).Result !=
-           Result::Success) {
-        cout << ".";
-    }
-    cout << endl;
-
-    // get force plates
-    forcePlates = 0;
-    while (forcePlates < 1) {
-        cout << "waiting for devices..." << endl;
-        client.GetFrame();
-        auto forcePlatesInfo = client.GetForcePlateCount();
-        if (forcePlatesInfo.Result == Result::Success) {
-            forcePlates = forcePlatesInfo.ForcePlateCount;
-        }
-    }
-    cout << "found " << forcePlates << " force plates" << endl;
-    for (int i = 0; i < client.GetDeviceCount().DeviceCount; ++i) {
-        if (client.GetDeviceName(i).DeviceType == DeviceType::ForcePlate) {
-            string name = client.GetDeviceName(i).DeviceName;
-            forcePlateNames.push_back(name);
-            cout << name << endl;
-        }
-    }
-
-    // get marker names
-    bool frameComplete = false;
-    do {
-        if (client.GetFrame().Result == Result::Success) {
-            int subjectCount = client.GetSubjectCount().SubjectCount;
-            if (subjectCount != 1) {
-                cout << "warning: " << subjectCount
-                     << " subject(s) in the capture volume" << endl;
-            } else {
-                int subjectIndex = subjectCount - 1;
-                string subjectName =
-                        client.GetSubjectName(subjectIndex).SubjectName;
-                int markerCount =
-                        client.GetMarkerCount(subjectName).MarkerCount;
-                for (int i = 0; i < markerCount; ++i) {
-                    markerNames.push_back(
-                            client.GetMarkerName(subjectName, i).MarkerName);
-                }
-                frameComplete = true;
-            }
-        }
-        cout << ".";
-    } while (!frameComplete);
-    cout << "\n found " << markerNames.size() << " markers" << endl;
-
-    client.SetAxisMapping(xAxis, yAxis, zAxis);
+int ViconDataStream::getMarkerIndex(const string& markerName) const {
+    auto it = find(markerNames.begin(), markerNames.end(), markerName);
+    if (it == markerNames.end())
+        THROW_EXCEPTION("marker " + markerName + " is not streamed");
+    return distance(markerNames.begin(), it);
 }
 
-void ViconDataStream::getFrame() {
+bool ViconDataStream::getFrame(double timeout) {
     // wait for frame
-    while (client.GetFrame().Result != Result::Success) { cout << "."; }
+    if (!dataSource->getFrame(timeout)) return false;
+    auto receiveTime = chrono::duration<double>(
+                               chrono::steady_clock::now().time_since_epoch())
+                               .count();
 
     // frame number and frame rate
-    auto frameNumber = client.GetFrameNumber().FrameNumber;
-    static auto firstFrameNumber = frameNumber;
-    auto frameRate = client.GetFrameRate();
+    auto frameNumber = dataSource->getFrameNumber();
+    if (firstFrameNumber < 0) firstFrameNumber = frameNumber;
+    auto frameRate = dataSource->getFrameRate();
 
     // get marker data
     double currentMarkerDataTime =
-            1.0 / frameRate.FrameRateHz * (frameNumber - firstFrameNumber);
+            1.0 / frameRate * (frameNumber - firstFrameNumber);
     if (currentMarkerDataTime > previousMarkerDataTime) {
-        MarkerData markerData;
         markerData.time = currentMarkerDataTime;
-        int subjectCount = client.GetSubjectCount().SubjectCount;
-        if (subjectCount != 1) {
-            cout << "warning: " << subjectCount
-                 << " subject(s) in the capture volume" << endl;
-        } else {
-            int subjectIndex = subjectCount - 1;
-            string subjectName =
-                    client.GetSubjectName(subjectIndex).SubjectName;
-            int markerCount = client.GetMarkerCount(subjectName).MarkerCount;
-            for (int i = 0; i < markerCount; ++i) {
-                string markerName =
-                        client.GetMarkerName(subjectName, i).MarkerName;
-                Output_GetMarkerGlobalTranslation markerGlobalTranslation =
-                        client.GetMarkerGlobalTranslation(subjectName,
-                                                          markerName);
-                if (!markerGlobalTranslation.Occluded) {
-                    // convert to meters
-                    markerData.markers[markerName] = Vec3(
-                            MM_TO_M(markerGlobalTranslation.Translation[0]),
-                            MM_TO_M(markerGlobalTranslation.Translation[1]),
-                            MM_TO_M(markerGlobalTranslation.Translation[2]));
-                } else {
-                    markerData.markers[markerName] = Vec3(NaN);
-                }
+        markerData.receiveTime = receiveTime;
+        Vec3 translation;
+        for (size_t i = 0; i < markerNames.size(); ++i) {
+            if (dataSource->getMarkerGlobalTranslation(i, translation)) {
+                // convert to meters
+                markerData.markers[i] = Vec3(MM_TO_M(translation[0]),
+                                             MM_TO_M(translation[1]),
+                                             MM_TO_M(translation[2]));
+            } else {
+                markerData.markers[i] = Vec3(NaN);
             }
         }
         markerBuffer.add(markerData);
@@ -158,30 +98,20 @@ void ViconDataStream::getFrame() {
     }
 
     // get force data
-    auto forcePlateSubsamples =
-            client.GetForcePlateSubsamples(0).ForcePlateSubsamples;
+    if (forcePlates < 1) return true;
+    auto forcePlateSubsamples = dataSource->getForcePlateSubsamples(0);
     for (int sample = 0; sample < forcePlateSubsamples; ++sample) {
-        double currentForceDataTime = 1.0 / frameRate.FrameRateHz *
-                                      (frameNumber - firstFrameNumber +
-                                       1.0 / forcePlateSubsamples * sample);
+        double currentForceDataTime =
+                1.0 / frameRate *
+                (frameNumber - firstFrameNumber +
+                 1.0 / forcePlateSubsamples * sample);
         if (currentForceDataTime > previousForceDataTime) {
-            ForceData forceData;
             forceData.time = currentForceDataTime;
             for (int i = 0; i < forcePlates; ++i) {
                 Vec3 currentFpPos = labForcePlatePositions[i];
-                Output_GetGlobalForceVector forceVector =
-                        client.GetGlobalForceVector(i);
-                Vec3 grfVec;
-                grfVec[0] = forceVector.ForceVector[0];
-                grfVec[1] = forceVector.ForceVector[1];
-                grfVec[2] = forceVector.ForceVector[2];
-
-                Output_GetGlobalCentreOfPressure centreOfPressure =
-                        client.GetGlobalCentreOfPressure(i);
-                Vec3 grfPoint;
-                grfPoint[0] = centreOfPressure.CentreOfPressure[0];
-                grfPoint[1] = centreOfPressure.CentreOfPressure[1];
-                grfPoint[2] = centreOfPressure.CentreOfPressure[2];
+                Vec3 grfVec = dataSource->getGlobalForceVector(i, sample);
+                Vec3 grfPoint =
+                        dataSource->getGlobalCentreOfPressure(i, sample);
 
                 // calculate the values of the moment of the 'position'
                 // reference system of the force plate in the global coordinate
@@ -194,16 +124,11 @@ void ViconDataStream::getFrame() {
                 momentOnPosition[2] = currentFpPos[0] * grfVec[1] -
                                       currentFpPos[1] * grfVec[0];
 
-                Output_GetGlobalMomentVector momentVector =
-                        client.GetGlobalMomentVector(i);
-
                 // calculate the correct values of the moments relatively the
                 // global coordinate system by adding the missing position
                 // moment
-                Vec3 moments(0.0);
-                moments[0] = momentVector.MomentVector[0] + momentOnPosition[0];
-                moments[1] = momentVector.MomentVector[1] + momentOnPosition[1];
-                moments[2] = momentVector.MomentVector[2] + momentOnPosition[2];
+                Vec3 moments = dataSource->getGlobalMomentVector(i, sample) +
+                               momentOnPosition;
 
                 Vec3 grfTorque;
                 grfTorque[0] = 0;
@@ -220,40 +145,48 @@ void ViconDataStream::getFrame() {
                 forcePlateData.force = -grfVec;
                 forcePlateData.point = grfPoint;
                 forcePlateData.torque = -grfTorque;
-                forceData.externalWrenches[forcePlateNames[i]] = forcePlateData;
+                forceData.externalWrenches[i] = forcePlateData;
             }
             forceBuffer.add(forceData);
             previousForceDataTime = currentForceDataTime;
         }
     }
+    return true;
 }
 
-void ViconDataStream::startAcquisition() {
-    function<void()> acquisitionFunction = [&]() -> void {
-        while (!shouldTerminate) { getFrame(); }
+void ViconDataStream::startAcquisition(double timeout) {
+    function<void()> acquisitionFunction = [this, timeout]() -> void {
+        while (!shouldTerminate) {
+            if (getFrame(timeout)) {
+                acquiredFrames++;
+                if (dataAvailableCallback) dataAvailableCallback();
+            } else {
+                idleWaits++;
+            }
+            if (dataSource->endOfStream()) {
+                // signal termination before unblocking the consumers, so that
+                // they do not keep polling the last frame in CONTINUOUS mode
+                shouldTerminate = true;
+                markerBuffer.setDataRetrievalMode(
+                        DataRetrievalMode::CONTINUOUS);
+                forceBuffer.setDataRetrievalMode(
+                        DataRetrievalMode::CONTINUOUS);
+                if (dataAvailableCallback) dataAvailableCallback();
+                break;
+            }
+        }
     };
     thread acquisitionThread(acquisitionFunction);
     acquisitionThread.detach();
 }
 
-/*******************************************************************************/
+void ViconDataStream::setDataAvailableCallback(function<void()> callback) {
+    dataAvailableCallback = callback;
+}
 
-Direction::Enum OpenSimRT::stringToDirection(std::string direction) {
-    if (direction == "Up") {
-        return Direction::Enum::Up;
-    } else if (direction == "Down") {
-        return Direction::Enum::Down;
-    } else if (direction == "Left") {
-        return Direction::Enum::Left;
-    } else if (direction == "Right") {
-        return Direction::Enum::Right;
-    } else if (direction == "Forward") {
-        return Direction::Enum::Forward;
-    } else if (direction == "Backward") {
-        return Direction::Enum::Backward;
-    } else {
-        THROW_EXCEPTION("unsupported direction: " + direction);
-    }
+ViconDataStream::AcquisitionStatistics
+ViconDataStream::getAcquisitionStatistics() const {
+    return {acquiredFrames.load(), idleWaits.load()};
 }
 
 /*******************************************************************************/
@@ -0,0 +1,256 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ */
+#include "ViconSimulatedDataSource.h"
+#include "Exception.h"
+#include "InverseDynamics.h"
+#include <OpenSim/Common/MarkerData.h>
+#include <OpenSim/Common/Storage.h>
+#include <OpenSim/Common/Units.h>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+using namespace SimTK;
+using namespace OpenSim;
+using namespace OpenSimRT;
+
+// Sleep until the deadline of a frame, relative to the start of the stream, so
+// that the error of each sleep does not accumulate. Returns false if the
+// deadline is further than `timeout`, after sleeping for the timeout.
+static bool waitForFrame(const steady_clock::time_point& startTime,
+                         const int& frame, const double& frameRate,
+                         const double& speed, const double& timeout) {
+    if (speed <= 0) return true;
+    using Duration = steady_clock::duration;
+    auto deadline = startTime + duration_cast<Duration>(duration<double>(
+                                        frame / frameRate / speed));
+    auto limit = steady_clock::now() +
+                 duration_cast<Duration>(duration<double>(timeout));
+    if (deadline > limit) {
+        this_thread::sleep_until(limit);
+        return false;
+    }
+    this_thread::sleep_until(deadline);
+    return true;
+}
+
+/*******************************************************************************/
+
+ViconFileDataSource::ViconFileDataSource(const string& trcFile,
+                                         const string& grfMotFile,
+                                         const vector<ForcePlate>& forcePlates,
+                                         const int& forcePlateSubsamples,
+                                         const double& speed)
+        : speed(speed), frame(-1), subsamples(forcePlateSubsamples) {
+    if (subsamples < 1)
+        THROW_EXCEPTION("at least one force plate subsample is required");
+
+    // markers (in mm)
+    MarkerData markerData(trcFile);
+    markerData.convertToUnits(Units(Units::Millimeters));
+    frameRate = markerData.getDataRate();
+    numFrames = markerData.getNumFrames();
+    const auto& names = markerData.getMarkerNames();
+    for (int j = 0; j < names.getSize(); ++j) markerNames.push_back(names[j]);
+    markers.reserve(numFrames * markerNames.size());
+    for (int i = 0; i < numFrames; ++i) {
+        const auto& frameMarkers = markerData.getFrame(i).getMarkers();
+        for (int j = 0; j < frameMarkers.getSize(); ++j)
+            markers.push_back(frameMarkers[j]);
+    }
+
+    // force plates measurements, converted to the DataStream conventions:
+    // the force and torque are applied on the force plate and the moment is
+    // expressed about the force plate origin
+    Storage grfMotion(grfMotFile);
+    const double t0 = markerData.getStartFrameTime();
+    const int n = numFrames * forcePlates.size() * subsamples;
+    forces.resize(n);
+    moments.resize(n);
+    centresOfPressure.resize(n);
+    for (const auto& forcePlate : forcePlates)
+        forcePlateNames.push_back(forcePlate.name);
+    for (int i = 0; i < numFrames; ++i) {
+        for (int j = 0; j < forcePlates.size(); ++j) {
+            for (int k = 0; k < subsamples; ++k) {
+                double t = t0 + (i + 1.0 / subsamples * k) / frameRate;
+                auto wrench = ExternalWrench::getWrenchFromStorage(
+                        t, forcePlates[j].labels, grfMotion);
+                auto l = index(i, j, k);
+                forces[l] = -wrench.force;
+                centresOfPressure[l] = wrench.point;
+                moments[l] = (wrench.point - forcePlates[j].position) %
+                                     forces[l] -
+                             wrench.torque;
+            }
+        }
+    }
+}
+
+int ViconFileDataSource::index(int frame, int plate, int subsample) const {
+    return (frame * forcePlateNames.size() + plate) * subsamples + subsample;
+}
+
+bool ViconFileDataSource::getFrame(double timeout) {
+    if (endOfStream()) return false;
+    // the stream starts on the first request
+    if (startTime == steady_clock::time_point())
+        startTime = steady_clock::now();
+    if (frame + 1 >= numFrames) {
+        frame = numFrames;
+        return false;
+    }
+    if (!waitForFrame(startTime, frame + 1, frameRate, speed, timeout))
+        return false;
+    ++frame;
+    return true;
+}
+
+bool ViconFileDataSource::endOfStream() const { return frame >= numFrames; }
+
+unsigned int ViconFileDataSource::getFrameNumber() const { return frame; }
+
+double ViconFileDataSource::getFrameRate() const { return frameRate; }
+
+vector<string> ViconFileDataSource::getMarkerNames() const {
+    return markerNames;
+}
+
+bool ViconFileDataSource::getMarkerGlobalTranslation(int marker,
+                                                     Vec3& translation) const {
+    translation = markers[frame * markerNames.size() + marker];
+    return !translation.isNaN();
+}
+
+vector<string> ViconFileDataSource::getForcePlateNames() const {
+    return forcePlateNames;
+}
+
+int ViconFileDataSource::getForcePlateSubsamples(int plate) const {
+    return subsamples;
+}
+
+Vec3 ViconFileDataSource::getGlobalForceVector(int plate, int subsample) const {
+    return forces[index(frame, plate, subsample)];
+}
+
+Vec3 ViconFileDataSource::getGlobalMomentVector(int plate,
+                                                int subsample) const {
+    return moments[index(frame, plate, subsample)];
+}
+
+Vec3 ViconFileDataSource::getGlobalCentreOfPressure(int plate,
+                                                    int subsample) const {
+    return centresOfPressure[index(frame, plate, subsample)];
+}
+
+/*******************************************************************************/
+
+ViconSyntheticDataSource::ViconSyntheticDataSource(const Parameters& parameters)
+        : parameters(parameters), frame(-1), generator(0),
+          occlusion(parameters.occlusionProbability) {
+    if (parameters.frameRate <= 0)
+        THROW_EXCEPTION("frame rate must be positive");
+    if (parameters.forcePlateSubsamples < 1)
+        THROW_EXCEPTION("at least one force plate subsample is required");
+    if (parameters.markerNames.size() != parameters.markerPositions.size())
+        THROW_EXCEPTION("marker names and positions do not agree");
+    occluded.resize(parameters.markerNames.size(), false);
+}
+
+bool ViconSyntheticDataSource::getFrame(double timeout) {
+    if (endOfStream()) return false;
+    // the stream starts on the first request
+    if (startTime == steady_clock::time_point())
+        startTime = steady_clock::now();
+    if (parameters.numFrames > 0 && frame + 1 >= parameters.numFrames) {
+        frame = parameters.numFrames;
+        return false;
+    }
+    if (!waitForFrame(startTime, frame + 1, parameters.frameRate,
+                      parameters.speed, timeout))
+        return false;
+    ++frame;
+    for (int i = 0; i < occluded.size(); ++i)
+        occluded[i] = occlusion(generator);
+    return true;
+}
+
+bool ViconSyntheticDataSource::endOfStream() const {
+    return parameters.numFrames > 0 && frame >= parameters.numFrames;
+}
+
+unsigned int ViconSyntheticDataSource::getFrameNumber() const { return frame; }
+
+double ViconSyntheticDataSource::getFrameRate() const {
+    return parameters.frameRate;
+}
+
+vector<string> ViconSyntheticDataSource::getMarkerNames() const {
+    return parameters.markerNames;
+}
+
+double ViconSyntheticDataSource::getSubsampleTime(int subsample) const {
+    return (frame + 1.0 / parameters.forcePlateSubsamples * subsample) /
+           parameters.frameRate;
+}
+
+bool ViconSyntheticDataSource::getMarkerGlobalTranslation(
+        int marker, Vec3& translation) const {
+    if (occluded[marker]) return false;
+    double phase = 2 * Pi * parameters.frequency * getSubsampleTime(0);
+    translation = 1000 * (parameters.markerPositions[marker] +
+                          parameters.amplitude * sin(phase));
+    return true;
+}
+
+vector<string> ViconSyntheticDataSource::getForcePlateNames() const {
+    vector<string> names;
+    for (int i = 0; i < parameters.forcePlatePositions.size(); ++i)
+        names.push_back("ForcePlate" + to_string(i));
+    return names;
+}
+
+int ViconSyntheticDataSource::getForcePlateSubsamples(int plate) const {
+    return parameters.forcePlateSubsamples;
+}
+
+Vec3 ViconSyntheticDataSource::getGlobalForceVector(int plate,
+                                                    int subsample) const {
+    // periodic vertical load (applied on the plate) of a 70 kg subject
+    double phase = 2 * Pi * parameters.frequency * getSubsampleTime(subsample);
+    return Vec3(0, -700 * (1 + 0.2 * sin(phase)), 0);
+}
+
+Vec3 ViconSyntheticDataSource::getGlobalMomentVector(int plate,
+                                                     int subsample) const {
+    // moment of the force about the force plate origin (no free torque)
+    return (getGlobalCentreOfPressure(plate, subsample) -
+            parameters.forcePlatePositions[plate]) %
+           getGlobalForceVector(plate, subsample);
+}
+
+Vec3 ViconSyntheticDataSource::getGlobalCentreOfPressure(int plate,
+                                                         int subsample) const {
+    // progression of the centre of pressure from heel to toe
+    double phase = 2 * Pi * parameters.frequency * getSubsampleTime(subsample);
+    return parameters.forcePlatePositions[plate] +
+           Vec3(0.1 * sin(phase), 0, 0);
+}
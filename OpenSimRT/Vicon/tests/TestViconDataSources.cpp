@@ -0,0 +1,294 @@
+/**
+ * -----------------------------------------------------------------------------
+ * Copyright 2019-2021 OpenSimRT developers.
+ *
+ * This file is part of OpenSimRT.
+ *
+ * OpenSimRT is free software: you can redistribute it and/or modify it under
+ * the terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * OpenSimRT is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * OpenSimRT. If not, see <https://www.gnu.org/licenses/>.
+ * -----------------------------------------------------------------------------
+ *
+ * @file TestViconDataSources.cpp
+ *
+ * \brief Test the simulated Vicon data sources through the ViconDataStream:
+ * the replayed markers and ground reaction forces must match the recording,
+ * the synthetic stream must follow its analytic model, and both sources must
+ * respect their pacing, timeouts and end of stream.
+ *
+ * @author Dimitar Stanev <jimstanev@gmail.com>
+ */
+#include "Exception.h"
+#include "INIReader.h"
+#include "Settings.h"
+#include "ViconDataStream.h"
+#include "ViconSimulatedDataSource.h"
+#include <OpenSim/Common/MarkerData.h>
+#include <OpenSim/Common/Storage.h>
+#include <OpenSim/Common/Units.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace std;
+using namespace OpenSim;
+using namespace OpenSimRT;
+using namespace SimTK;
+
+void expectEqual(const Vec3& expected, const Vec3& actual,
+                 const double& tolerance, const string& what) {
+    if (expected.isNaN() && actual.isNaN()) return;
+    if (expected.isNaN() || actual.isNaN() ||
+        (expected - actual).norm() > tolerance) {
+        stringstream ss;
+        ss << what << ": expected " << expected << ", got " << actual;
+        THROW_EXCEPTION(ss.str());
+    }
+}
+
+/**
+ * Acquire the whole stream (the buffers must be large enough to hold it) and
+ * return the elapsed time.
+ */
+double acquire(ViconDataStream& vicon,
+               vector<ViconDataStream::MarkerData>& markerFrames,
+               vector<ViconDataStream::ForceData>& forceFrames) {
+    auto start = chrono::steady_clock::now();
+    vicon.startAcquisition(0.01);
+    while (!vicon.shouldTerminate)
+        this_thread::sleep_for(chrono::milliseconds(1));
+    auto elapsed = chrono::duration<double>(chrono::steady_clock::now() -
+                                            start)
+                           .count();
+    markerFrames = vicon.markerBuffer.drain();
+    forceFrames = vicon.forceBuffer.drain();
+    return elapsed;
+}
+
+/**
+ * Replay of the recorded markers and ground reaction forces.
+ */
+void testFileDataSource() {
+    INIReader ini(INI_FILE);
+    auto section = "VICON_SIMULATOR";
+    auto subjectDir = DATA_DIR + ini.getString(section, "SUBJECT_DIR", "");
+    auto trcFile = subjectDir + ini.getString(section, "TRC_FILE", "");
+    auto grfMotFile = subjectDir + ini.getString(section, "GRF_MOT_FILE", "");
+    vector<ViconFileDataSource::ForcePlate> forcePlates{
+            {"right", Vec3(0.3, 0, 0.1),
+             ExternalWrench::createGRFLabelsFromIdentifiers(
+                     ini.getString(section, "GRF_RIGHT_POINT_IDENTIFIER", ""),
+                     ini.getString(section, "GRF_RIGHT_FORCE_IDENTIFIER", ""),
+                     ini.getString(section, "GRF_RIGHT_TORQUE_IDENTIFIER",
+                                   ""))},
+            {"left", Vec3(0.9, 0, -0.1),
+             ExternalWrench::createGRFLabelsFromIdentifiers(
+                     ini.getString(section, "GRF_LEFT_POINT_IDENTIFIER", ""),
+                     ini.getString(section, "GRF_LEFT_FORCE_IDENTIFIER", ""),
+                     ini.getString(section, "GRF_LEFT_TORQUE_IDENTIFIER",
+                                   ""))}};
+    vector<Vec3> forcePlatePositions{forcePlates[0].position,
+                                     forcePlates[1].position};
+
+    // the recording (markers in m)
+    MarkerData markerData(trcFile);
+    markerData.convertToUnits(Units(Units::Meters));
+    Storage grfMotion(grfMotFile);
+    const int numFrames = markerData.getNumFrames();
+    const double t0 = markerData.getStartFrameTime();
+    const double frameRate = markerData.getDataRate();
+
+    // replay as fast as possible
+    const int subsamples = 4;
+    auto dataSource = make_shared<ViconFileDataSource>(
+            trcFile, grfMotFile, forcePlates, subsamples, 0);
+    if (dataSource->getFrameRate() != frameRate)
+        THROW_EXCEPTION("frame rate of the replay differs from the recording");
+    ViconDataStream vicon(forcePlatePositions, dataSource);
+    vicon.initialize();
+    if (vicon.markerNames.size() != markerData.getMarkerNames().getSize() ||
+        vicon.forcePlateNames != vector<string>{"right", "left"})
+        THROW_EXCEPTION("wrong marker or force plate names");
+
+    vector<ViconDataStream::MarkerData> markerFrames;
+    vector<ViconDataStream::ForceData> forceFrames;
+    acquire(vicon, markerFrames, forceFrames);
+    if (!dataSource->endOfStream())
+        THROW_EXCEPTION("acquisition stopped before the end of the stream");
+
+    // markers are converted from mm to m
+    if (markerFrames.size() != numFrames)
+        THROW_EXCEPTION("expected " + to_string(numFrames) +
+                        " marker frames, got " +
+                        to_string(markerFrames.size()));
+    for (int i = 0; i < numFrames; ++i) {
+        if (abs(markerFrames[i].time - i / frameRate) > 1e-9)
+            THROW_EXCEPTION("wrong time of marker frame " + to_string(i));
+        const auto& recorded = markerData.getFrame(i).getMarkers();
+        for (int j = 0; j < recorded.getSize(); ++j)
+            expectEqual(recorded[j], markerFrames[i].markers[j], 1e-9,
+                        "marker " + vicon.markerNames[j] + " of frame " +
+                                to_string(i));
+    }
+
+    // the recorded wrenches are reconstructed at each subsample (the stream
+    // provides the vertical torque only)
+    if (forceFrames.size() != numFrames * subsamples)
+        THROW_EXCEPTION("expected " + to_string(numFrames * subsamples) +
+                        " force frames, got " +
+                        to_string(forceFrames.size()));
+    for (int i = 0; i < forceFrames.size(); ++i) {
+        double t = i / (frameRate * subsamples);
+        if (abs(forceFrames[i].time - t) > 1e-9)
+            THROW_EXCEPTION("wrong time of force frame " + to_string(i));
+        for (int j = 0; j < forcePlates.size(); ++j) {
+            auto recorded = ExternalWrench::getWrenchFromStorage(
+                    t0 + t, forcePlates[j].labels, grfMotion);
+            const auto& streamed = forceFrames[i].externalWrenches[j];
+            auto what = forcePlates[j].name + " plate at " + to_string(t);
+            expectEqual(recorded.force, streamed.force, 1e-6,
+                        "force of " + what);
+            if (abs(recorded.force[1]) >= 10)
+                expectEqual(recorded.point, streamed.point, 1e-6,
+                            "point of " + what);
+            if (abs(recorded.torque[1] - streamed.torque[1]) > 1e-6)
+                THROW_EXCEPTION("torque of " + what + " differs");
+        }
+    }
+    cout << "replay: " << markerFrames.size() << " marker and "
+         << forceFrames.size() << " force frames match the recording" << endl;
+}
+
+/**
+ * Synthetic markers and force plate loads.
+ */
+void testSyntheticDataSource() {
+    ViconSyntheticDataSource::Parameters parameters;
+    parameters.frameRate = 1000;
+    parameters.forcePlateSubsamples = 2;
+    parameters.markerNames = {"A", "B", "C"};
+    parameters.markerPositions = {Vec3(0, 1, 0), Vec3(0.2, 0.5, -0.1),
+                                  Vec3(-0.3, 0.1, 0.4)};
+    parameters.forcePlatePositions = {Vec3(0.5, 0, 0.2)};
+    parameters.frequency = 2;
+    parameters.occlusionProbability = 0.25;
+    parameters.speed = 0;
+    parameters.numFrames = 500;
+
+    auto dataSource = make_shared<ViconSyntheticDataSource>(parameters);
+    ViconDataStream vicon(parameters.forcePlatePositions, dataSource);
+    vicon.initialize();
+    if (vicon.markerNames != parameters.markerNames ||
+        vicon.forcePlateNames.size() != 1)
+        THROW_EXCEPTION("wrong marker or force plate names");
+
+    vector<ViconDataStream::MarkerData> markerFrames;
+    vector<ViconDataStream::ForceData> forceFrames;
+    acquire(vicon, markerFrames, forceFrames);
+    if (markerFrames.size() != parameters.numFrames ||
+        forceFrames.size() !=
+                parameters.numFrames * parameters.forcePlateSubsamples)
+        THROW_EXCEPTION("wrong number of synthetic frames");
+
+    // markers oscillate around their reference positions
+    int occluded = 0, total = 0;
+    for (int i = 0; i < markerFrames.size(); ++i) {
+        double t = i / parameters.frameRate;
+        double phase = 2 * Pi * parameters.frequency * t;
+        for (int j = 0; j < parameters.markerNames.size(); ++j, ++total) {
+            const auto& marker = markerFrames[i].markers[j];
+            if (marker.isNaN()) {
+                occluded++;
+                continue;
+            }
+            expectEqual(parameters.markerPositions[j] +
+                                parameters.amplitude * sin(phase),
+                        marker, 1e-9,
+                        "synthetic marker " + parameters.markerNames[j]);
+        }
+    }
+    double occlusionRate = double(occluded) / total;
+    cout << "synthetic: occlusion rate " << occlusionRate << endl;
+    if (abs(occlusionRate - parameters.occlusionProbability) > 0.05)
+        THROW_EXCEPTION("occlusion rate differs from its probability");
+
+    // periodic vertical load applied at a moving centre of pressure
+    for (int i = 0; i < forceFrames.size(); ++i) {
+        double t = i / (parameters.frameRate * parameters.forcePlateSubsamples);
+        if (abs(forceFrames[i].time - t) > 1e-9)
+            THROW_EXCEPTION("wrong time of synthetic force frame");
+        double phase = 2 * Pi * parameters.frequency * t;
+        const auto& wrench = forceFrames[i].externalWrenches[0];
+        expectEqual(Vec3(0, 700 * (1 + 0.2 * sin(phase)), 0), wrench.force,
+                    1e-9, "synthetic force");
+        expectEqual(parameters.forcePlatePositions[0] +
+                            Vec3(0.1 * sin(phase), 0, 0),
+                    wrench.point, 1e-9, "synthetic centre of pressure");
+        if (abs(wrench.torque[1]) > 1e-9)
+            THROW_EXCEPTION("synthetic load has a free torque");
+    }
+}
+
+/**
+ * Frames are delivered at the frame rate times the speed, and requests that
+ * exceed the timeout return without a frame.
+ */
+void testPacing() {
+    ViconSyntheticDataSource::Parameters parameters;
+    parameters.frameRate = 10;
+    parameters.markerNames = {"A"};
+    parameters.markerPositions = {Vec3(0)};
+    parameters.numFrames = 2;
+
+    ViconSyntheticDataSource source(parameters);
+    if (!source.getFrame(0.01) || source.getFrameNumber() != 0)
+        THROW_EXCEPTION("the first frame must be available immediately");
+    if (source.getFrame(0.01))
+        THROW_EXCEPTION("a frame was delivered before its deadline");
+    if (!source.getFrame(1) || source.getFrameNumber() != 1)
+        THROW_EXCEPTION("the second frame was not delivered");
+    if (source.getFrame(1) || !source.endOfStream())
+        THROW_EXCEPTION("the stream did not end after the last frame");
+
+    // 40 frames at 200 Hz through the stream
+    parameters.frameRate = 200;
+    parameters.numFrames = 40;
+    parameters.forcePlatePositions = {};
+    auto dataSource = make_shared<ViconSyntheticDataSource>(parameters);
+    ViconDataStream vicon({}, dataSource);
+    vicon.initialize();
+    vector<ViconDataStream::MarkerData> markerFrames;
+    vector<ViconDataStream::ForceData> forceFrames;
+    double elapsed = acquire(vicon, markerFrames, forceFrames);
+    double expected = (parameters.numFrames - 1) / parameters.frameRate;
+    cout << "paced stream: " << elapsed << " s (expected " << expected << " s)"
+         << endl;
+    if (markerFrames.size() != parameters.numFrames || elapsed < expected)
+        THROW_EXCEPTION("the stream was not paced at the frame rate");
+}
+
+void run() {
+    testFileDataSource();
+    testSyntheticDataSource();
+    testPacing();
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        run();
+    } catch (exception& e) {
+        cout << e.what() << endl;
+        return -1;
+    }
+    return 0;
+}
@@ -206,6 +206,126 @@ endfunction()
 
 
 
+function(addBenchmarks)
+  # Create Google Benchmark targets for this directory.
+  #
+  # Parse Arguments
+  # ---------------
+  # BENCHMARKPROGRAMS: Names of benchmark CPP files. One benchmark will be
+  #   created for each cpp of these files.
+  # LINKLIBS: Arguments to TARGET_LINK_LIBRARIES.
+  #
+  # Each benchmark is also run by the 'benchmarks' target, which writes the
+  # results to <build>/<BenchmarkName>.json.
+  #
+  # Example:
+  #   addBenchmarks(
+  #       BENCHMARKPROGRAMS ${BENCHMARK_PROGRAMS}
+  #       LINKLIBS Common ${OpenSim_LIBRARIES}
+  #   )
+  # *****************************************************************************
+
+  if(BUILD_BENCHMARKS)
+
+    # Parse arguments.
+    # ----------------
+    set(options)
+    set(oneValueArgs)
+    set(multiValueArgs BENCHMARKPROGRAMS LINKLIBS)
+    cmake_parse_arguments(
+      ADDBENCHMARKS "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN})
+
+    if(NOT TARGET benchmarks)
+      add_custom_target(benchmarks)
+      set_target_properties(benchmarks PROPERTIES FOLDER "Benchmarks")
+    endif()
+
+    # Make benchmark targets.
+    foreach(benchmark_program ${ADDBENCHMARKS_BENCHMARKPROGRAMS})
+      # NAME_WE stands for "name without extension"
+      get_filename_component(BENCHMARK_NAME ${benchmark_program} NAME_WE)
+
+      add_executable(${BENCHMARK_NAME} ${benchmark_program})
+      target_link_libraries(${BENCHMARK_NAME}
+        ${ADDBENCHMARKS_LINKLIBS} benchmark::benchmark)
+      set_target_properties(${BENCHMARK_NAME}
+        PROPERTIES
+        PROJECT_LABEL "Benchmark - ${BENCHMARK_NAME}"
+        FOLDER "Benchmarks"
+        )
+
+      add_custom_target(run_${BENCHMARK_NAME}
+        COMMAND ${BENCHMARK_NAME}
+        --benchmark_out=${PROJECT_BINARY_DIR}/${BENCHMARK_NAME}.json
+        --benchmark_out_format=json
+        DEPENDS ${BENCHMARK_NAME}
+        WORKING_DIRECTORY ${PROJECT_BINARY_DIR}
+        USES_TERMINAL
+        )
+      set_target_properties(run_${BENCHMARK_NAME}
+        PROPERTIES FOLDER "Benchmarks")
+      add_dependencies(benchmarks run_${BENCHMARK_NAME})
+    endforeach()
+  endif()
+endfunction()
+
+
+function(addPerformanceTests)
+  # Register the performance gate of test programs (see PerformanceGate.h).
+  #
+  # Parse Arguments
+  # ---------------
+  # TESTS: Names of test targets (created by addTests) that support the
+  #   --performance and --update-baseline arguments.
+  #
+  # Each test is added as <TestName>Performance with the "performance" label
+  # (ctest -L performance) and is run serially, so that the measurements are not
+  # disturbed by other tests. The 'update_performance_baselines' target stores
+  # the measurements as the new baselines.
+  #
+  # Example:
+  #   addPerformanceTests(
+  #       TESTS TestRTFromFile TestIKIMUFromFile
+  #   )
+  # *****************************************************************************
+
+  if(BUILD_TESTING AND BUILD_PERFORMANCE_GATE)
+
+    # Parse arguments.
+    # ----------------
+    set(options)
+    set(oneValueArgs)
+    set(multiValueArgs TESTS)
+    cmake_parse_arguments(
+      ADDPERFORMANCETESTS "${options}" "${oneValueArgs}" "${multiValueArgs}"
+      ${ARGN})
+
+    if(NOT TARGET update_performance_baselines)
+      add_custom_target(update_performance_baselines)
+      set_target_properties(update_performance_baselines
+        PROPERTIES FOLDER "Tests")
+    endif()
+
+    foreach(TEST_NAME ${ADDPERFORMANCETESTS_TESTS})
+      add_test(NAME ${TEST_NAME}Performance
+        COMMAND ${TEST_NAME} --performance)
+      set_tests_properties(${TEST_NAME}Performance
+        PROPERTIES LABELS performance RUN_SERIAL TRUE)
+
+      add_custom_target(update_${TEST_NAME}_baseline
+        COMMAND ${TEST_NAME} --update-baseline
+        DEPENDS ${TEST_NAME}
+        USES_TERMINAL
+        )
+      set_target_properties(update_${TEST_NAME}_baseline
+        PROPERTIES FOLDER "Tests")
+      add_dependencies(update_performance_baselines
+        update_${TEST_NAME}_baseline)
+    endforeach()
+  endif()
+endfunction()
+
+
 function(addApplications)
   # Create an application/executable. To be used in the Appliations directory.
   #